@@ -38,6 +38,7 @@ PIM::PIM( Module *parent, const string& name,
   DenseAllocator( parent, name, inputs, outputs ),
   _PIM_iter(iters)
 {
+  _random.Key( RandomStream::allocator, RandomStreamId( FullName( ) ) );
 }
 
 PIM::~PIM( )
@@ -61,7 +62,7 @@ void PIM::Allocate( )
     for ( output = 0; output < _outputs; ++output ) {
       
       // A random arbiter between input requests
-      input_offset  = RandomInt( _inputs - 1 );
+      input_offset  = _random.Int( _inputs - 1 );
       
       for ( int i = 0; i < _inputs; ++i ) {
 	input = ( i + input_offset ) % _inputs;  
@@ -83,7 +84,7 @@ void PIM::Allocate( )
     for ( input = 0; input < _inputs; ++input ) {
       
       // A random arbiter between output grants
-      output_offset  = RandomInt( _outputs - 1 );
+      output_offset  = _random.Int( _outputs - 1 );
       
       for ( int o = 0; o < _outputs; ++o ) {
 	output = ( o + output_offset ) % _outputs;
@@ -0,0 +1,376 @@
+/*
+ * analytical_model.cpp
+ * - Fast analytical estimate of a configuration (analytical_model = 1):
+ *   the routing function walked once per source-destination pair, the
+ *   channel loads of the traffic pattern and an M/D/1-style queueing
+ *   delay per channel; analytical_model = 2 also runs the detailed
+ *   simulation and reports how far the estimate is off
+ */
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "analytical_model.hpp"
+#include "random_utils.hpp"
+#include "traffic.hpp"
+#include "trafficmanager.hpp"
+
+static double WallTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+AnalyticalModel::AnalyticalModel( const Configuration & config,
+                                  const vector<Network *> & net )
+  : Module( 0, "analytical_model" ), _config( &config ), _net( net ),
+    _unroutable( 0 ), _offered( 0.0 ), _max_load( 0.0 ), _max_channel( -1 ),
+    _saturated( false ), _run_time( 0.0 )
+{
+  _nodes = net[0]->NumNodes( );
+  _classes = config.GetInt( "classes" );
+  _subnets = config.GetInt( "subnets" );
+  _samples = config.GetInt( "analytical_samples" );
+  if ( _samples < 1 ) {
+    cerr << "Error: analytical_samples must be at least 1" << endl;
+    exit(-1);
+  }
+
+  string const rf = config.GetStr( "routing_function" ) + "_" +
+                    config.GetStr( "topology" );
+  map<string, tRoutingFunction>::const_iterator i = gRoutingFunctionMap.find( rf );
+  if ( i == gRoutingFunctionMap.end( ) ) {
+    cerr << "Error: Invalid routing function: " << rf << endl;
+    exit(-1);
+  }
+  _rf = i->second;
+
+  int const alloc_delay = config.GetInt( "speculative" ) ?
+    max( config.GetInt( "vc_alloc_delay" ), config.GetInt( "sw_alloc_delay" ) ) :
+    config.GetInt( "vc_alloc_delay" ) + config.GetInt( "sw_alloc_delay" );
+  _router_delay = config.GetInt( "routing_delay" ) + alloc_delay +
+    config.GetInt( "st_prepare_delay" ) + config.GetInt( "st_final_delay" );
+
+  _traffic = config.GetStrArray( "traffic" );
+  _traffic.resize( _classes, _traffic.back( ) );
+
+  // packet sizes as the traffic manager reads them
+  vector<vector<int> > sizes;
+  string const size_str = config.GetStr( "packet_size" );
+  if ( size_str.empty( ) ) {
+    sizes.push_back( vector<int>( 1, config.GetInt( "packet_size" ) ) );
+  } else {
+    vector<string> const strs = tokenize_str( size_str );
+    for ( size_t s = 0; s < strs.size( ); ++s ) {
+      sizes.push_back( tokenize_int( strs[s] ) );
+    }
+  }
+  sizes.resize( _classes, sizes.back( ) );
+  vector<vector<int> > rates;
+  string const rate_str = config.GetStr( "packet_size_rate" );
+  if ( rate_str.empty( ) ) {
+    for ( int c = 0; c < _classes; ++c ) {
+      rates.push_back( vector<int>( sizes[c].size( ), config.GetInt( "packet_size_rate" ) ) );
+    }
+  } else {
+    vector<string> strs = tokenize_str( rate_str );
+    strs.resize( _classes, strs.back( ) );
+    for ( int c = 0; c < _classes; ++c ) {
+      rates.push_back( tokenize_int( strs[c] ) );
+      rates[c].resize( sizes[c].size( ), rates[c].back( ) );
+    }
+  }
+  _size_mean.resize( _classes, 0.0 );
+  _size_square.resize( _classes, 0.0 );
+  for ( int c = 0; c < _classes; ++c ) {
+    int total = 0;
+    for ( size_t s = 0; s < sizes[c].size( ); ++s ) {
+      total += rates[c][s];
+      _size_mean[c] += (double)rates[c][s] * sizes[c][s];
+      _size_square[c] += (double)rates[c][s] * sizes[c][s] * sizes[c][s];
+    }
+    _size_mean[c] /= total;
+    _size_square[c] /= total;
+  }
+
+  _load = config.GetFloatArray( "injection_rate" );
+  if ( _load.empty( ) ) {
+    _load.push_back( config.GetFloat( "injection_rate" ) );
+  }
+  _load.resize( _classes, _load.back( ) );
+  if ( config.GetInt( "injection_rate_uses_flits" ) ) {
+    for ( int c = 0; c < _classes; ++c ) {
+      _load[c] /= _size_mean[c];
+    }
+  }
+
+  for ( int n = 0; n < _nodes; ++n ) {
+    _eject[net[0]->GetEject( n )] = n;
+  }
+  _path.resize( _nodes * _nodes );
+  _hops.resize( _nodes * _nodes, 0 );
+  _routed.resize( _nodes * _nodes, false );
+
+  _rate.resize( _classes, 0.0 );
+  _latency.resize( _classes, 0.0 );
+  _zero_load.resize( _classes, 0.0 );
+  _hop_sum.resize( _classes, 0.0 );
+}
+
+// follows the preferred output of every hop, as a head flit on an idle
+// network would; false when the packet does not arrive
+bool AnalyticalModel::_Route( int src, int dest, int cl )
+{
+  int const pair = src * _nodes + dest;
+  if ( _routed[pair] ) {
+    return !_path[pair].empty( );
+  }
+  _routed[pair] = true;
+
+  Flit * f = Flit::New( );
+  f->src = src;
+  f->dest = dest;
+  f->cl = cl;
+  f->head = true;
+  f->tail = true;
+
+  OutputSet route;
+  _rf( NULL, f, -1, &route, true );
+  vector<int> path;
+  bool arrived = false;
+  if ( !route.GetSet( ).empty( ) ) {
+    f->vc = route.GetSet( ).begin( )->vc_start;
+    FlitChannel * chan = _net[0]->GetInject( src );
+    int const limit = 4 * _net[0]->NumRouters( );
+    int hops = 0;
+    while ( hops <= limit ) {
+      map<const FlitChannel *, int>::const_iterator index = _channel_index.find( chan );
+      if ( index == _channel_index.end( ) ) {
+        index = _channel_index.insert( make_pair( chan, (int)_channels.size( ) ) ).first;
+        _channels.push_back( chan );
+      }
+      path.push_back( index->second );
+
+      Router * r = chan->GetSink( );
+      if ( !r ) {
+        map<const FlitChannel *, int>::const_iterator e = _eject.find( chan );
+        arrived = ( e != _eject.end( ) ) && ( e->second == dest );
+        break;
+      }
+      _rf( r, f, chan->GetSinkPort( ), &route, false );
+      set<OutputSet::sSetElement> const & outputs = route.GetSet( );
+      if ( outputs.empty( ) ) {
+        break;
+      }
+      set<OutputSet::sSetElement>::const_iterator best = outputs.begin( );
+      for ( set<OutputSet::sSetElement>::const_iterator o = outputs.begin( );
+            o != outputs.end( ); ++o ) {
+        if ( o->pri > best->pri ) {
+          best = o;
+        }
+      }
+      f->vc = best->vc_start;
+      chan = r->GetOutputChannel( best->output_port );
+      ++hops;
+    }
+    _hops[pair] = hops;
+  }
+  f->Free( );
+
+  if ( arrived ) {
+    _path[pair].swap( path );
+  } else {
+    ++_unroutable;
+  }
+  return arrived;
+}
+
+// Pollaczek-Khinchine waiting time of a channel serving one flit per
+// cycle, M/D/1 for a single packet size
+double AnalyticalModel::_Wait( int channel ) const
+{
+  double const rho = _flit_rate[channel];
+  if ( rho >= 1.0 ) {
+    return HUGE_VAL;
+  }
+  return _size_square_rate[channel] / ( 2.0 * ( 1.0 - rho ) );
+}
+
+void AnalyticalModel::Run( )
+{
+  double const start = WallTime( );
+
+  // the destinations come from the traffic patterns, keep the simulation
+  // stream where it was
+  vector<long> save_x;
+  vector<double> save_u;
+  SaveRandomState( save_x, save_u );
+
+  // powered-off cores neither send nor receive, as in _GeneratePacket
+  vector<bool> const & core_states = _net[0]->GetCoreStates( );
+
+  // packet rate of every pair and class, a packet picks one subnet
+  vector<map<int, double> > demand( _classes );
+  for ( int c = 0; c < _classes; ++c ) {
+    TrafficPattern * pattern = TrafficPattern::New( _traffic[c], _nodes, _config, c );
+    double const weight = _load[c] / _samples / _subnets;
+    for ( int src = 0; src < _nodes; ++src ) {
+      if ( !core_states[src] ) {
+        continue;
+      }
+      for ( int s = 0; s < _samples; ++s ) {
+        int dest = pattern->dest( src );
+        if ( !core_states[dest] ) {
+          if ( _traffic[c].compare( 0, 7, "tornado" ) == 0 ) {
+            dest = src;
+          } else {
+            for ( int tries = 0; !core_states[dest] && ( tries < 64 * _nodes ); ++tries ) {
+              dest = pattern->dest( src );
+            }
+          }
+        }
+        if ( _Route( src, dest, c ) ) {
+          demand[c][src * _nodes + dest] += weight;
+        }
+      }
+    }
+    delete pattern;
+  }
+
+  RestoreRandomState( save_x, save_u );
+
+  _flit_rate.assign( _channels.size( ), 0.0 );
+  _packet_rate.assign( _channels.size( ), 0.0 );
+  _size_square_rate.assign( _channels.size( ), 0.0 );
+  for ( int c = 0; c < _classes; ++c ) {
+    for ( map<int, double>::const_iterator d = demand[c].begin( );
+          d != demand[c].end( ); ++d ) {
+      vector<int> const & path = _path[d->first];
+      for ( size_t h = 0; h < path.size( ); ++h ) {
+        _flit_rate[path[h]] += d->second * _size_mean[c];
+        _packet_rate[path[h]] += d->second;
+        _size_square_rate[path[h]] += d->second * _size_square[c];
+      }
+    }
+  }
+  for ( size_t ch = 0; ch < _channels.size( ); ++ch ) {
+    if ( _flit_rate[ch] > _max_load ) {
+      _max_load = _flit_rate[ch];
+      _max_channel = ch;
+    }
+  }
+  _saturated = ( _max_load >= 1.0 );
+
+  // head latency of every hop plus the tail behind it
+  for ( int c = 0; c < _classes; ++c ) {
+    for ( map<int, double>::const_iterator d = demand[c].begin( );
+          d != demand[c].end( ); ++d ) {
+      vector<int> const & path = _path[d->first];
+      double zero_load = _size_mean[c] - 1.0 + _hops[d->first] * _router_delay;
+      double wait = 0.0;
+      for ( size_t h = 0; h < path.size( ); ++h ) {
+        zero_load += _channels[path[h]]->GetLatency( );
+        wait += _Wait( path[h] );
+      }
+      _rate[c] += d->second;
+      _zero_load[c] += d->second * zero_load;
+      _latency[c] += d->second * ( zero_load + wait );
+      _hop_sum[c] += d->second * _hops[d->first];
+    }
+    _offered += _rate[c] * _size_mean[c] * _subnets / _nodes;
+  }
+
+  _run_time = WallTime( ) - start;
+}
+
+void AnalyticalModel::Display( ostream & os ) const
+{
+  os << "====== Analytical Model ======" << endl;
+  os << "Routed pairs = " << count( _routed.begin( ), _routed.end( ), true ) - _unroutable;
+  if ( _unroutable > 0 ) {
+    os << " (" << _unroutable << " not delivered)";
+  }
+  os << endl;
+
+  double load = 0.0;
+  for ( int c = 0; c < _classes; ++c ) {
+    ostringstream prefix;
+    if ( _classes > 1 ) {
+      prefix << "Class " << c << " ";
+    }
+    if ( _rate[c] <= 0.0 ) {
+      continue;
+    }
+    os << prefix.str( ) << "Zero-load latency estimate = "
+       << _zero_load[c] / _rate[c] << endl;
+    os << prefix.str( ) << "Packet latency estimate = ";
+    if ( _saturated ) {
+      os << "saturated" << endl;
+    } else {
+      os << _latency[c] / _rate[c] << endl;
+    }
+    os << prefix.str( ) << "Hops average estimate = " << _hop_sum[c] / _rate[c] << endl;
+  }
+  for ( size_t ch = 0; ch < _channels.size( ); ++ch ) {
+    load += _flit_rate[ch];
+  }
+  if ( !_channels.empty( ) ) {
+    os << "Channel load average = " << load / _channels.size( ) << endl;
+  }
+  if ( _max_channel >= 0 ) {
+    os << "Channel load maximum = " << _max_load << " ("
+       << _channels[_max_channel]->FullName( ) << ")" << endl;
+    os << "Saturation throughput estimate = "
+       << _offered / _max_load << " flits/node/cycle" << endl;
+  }
+  os << "Analytical model time = " << 1000.0 * _run_time << " ms" << endl;
+}
+
+void AnalyticalModel::Validate( const TrafficManager * tm, ostream & os ) const
+{
+  vector<pair<string, double> > metrics;
+  tm->OverallMetrics( metrics );
+  map<string, double> simulated( metrics.begin( ), metrics.end( ) );
+
+  os << "====== Analytical Model Validation ======" << endl;
+  for ( int c = 0; c < _classes; ++c ) {
+    ostringstream prefix;
+    if ( _classes > 1 ) {
+      prefix << "Class " << c << " ";
+    }
+    if ( _rate[c] <= 0.0 ) {
+      continue;
+    }
+    string const names[] = { "Packet latency average", "Hops average" };
+    double const model[] = { _saturated ? HUGE_VAL : _latency[c] / _rate[c],
+                             _hop_sum[c] / _rate[c] };
+    for ( int m = 0; m < 2; ++m ) {
+      map<string, double>::const_iterator sim = simulated.find( prefix.str( ) + names[m] );
+      if ( sim == simulated.end( ) ) {
+        continue;
+      }
+      os << prefix.str( ) << names[m] << ": model = ";
+      if ( model[m] == HUGE_VAL ) {
+        os << "saturated";
+      } else {
+        os << model[m];
+      }
+      os << ", simulated = " << sim->second;
+      if ( model[m] != HUGE_VAL && sim->second > 0.0 ) {
+        os << ", error = " << 100.0 * ( model[m] - sim->second ) / sim->second << "%";
+      }
+      os << endl;
+    }
+  }
+  if ( _max_load > 0.0 ) {
+    map<string, double>::const_iterator sim = simulated.find( "Accepted flit rate average" );
+    if ( ( _classes == 1 ) && ( sim != simulated.end( ) ) ) {
+      os << "Accepted flit rate average: offered = " << _offered
+         << ", simulated = " << sim->second << ", saturation estimate = "
+         << _offered / _max_load << endl;
+    }
+  }
+}
@@ -0,0 +1,86 @@
+/*
+ * analytical_model.hpp
+ * - Fast analytical estimate of a configuration (analytical_model = 1):
+ *   the routing function walked once per source-destination pair, the
+ *   channel loads of the traffic pattern and an M/D/1-style queueing
+ *   delay per channel; analytical_model = 2 also runs the detailed
+ *   simulation and reports how far the estimate is off
+ */
+
+#ifndef _ANALYTICAL_MODEL_HPP_
+#define _ANALYTICAL_MODEL_HPP_
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "module.hpp"
+#include "network.hpp"
+#include "config_utils.hpp"
+#include "routefunc.hpp"
+
+class TrafficManager;
+
+class AnalyticalModel : public Module {
+
+  Configuration const * _config;
+  vector<Network *> _net;
+  tRoutingFunction _rf;
+  int _nodes;
+  int _classes;
+  int _subnets;
+  int _samples;
+  int _router_delay;
+
+  vector<string> _traffic;
+  vector<double> _load;             // packets per node and cycle
+  vector<double> _size_mean;        // flits per packet
+  vector<double> _size_square;
+
+  // channels in the order of their index, the injection and ejection
+  // channels of every node included
+  vector<FlitChannel *> _channels;
+  map<const FlitChannel *, int> _channel_index;
+  map<const FlitChannel *, int> _eject;
+
+  // routed path of each pair, channel indices and router hops
+  vector<vector<int> > _path;
+  vector<int> _hops;
+  vector<bool> _routed;
+  int _unroutable;
+
+  // per channel: flits, packets and packets times size squared per cycle
+  vector<double> _flit_rate;
+  vector<double> _packet_rate;
+  vector<double> _size_square_rate;
+
+  // per class: packet rate weighted sums over the pairs
+  vector<double> _rate;
+  vector<double> _latency;
+  vector<double> _zero_load;
+  vector<double> _hop_sum;
+
+  double _offered;                  // flits per node and cycle
+  double _max_load;
+  int _max_channel;
+  bool _saturated;
+  double _run_time;
+
+  bool _Route( int src, int dest, int cl );
+  double _Wait( int channel ) const;
+
+public:
+
+  AnalyticalModel( const Configuration & config,
+                   const vector<Network *> & net );
+
+  void Run( );
+  void Display( ostream & os = cout ) const;
+
+  // the estimate next to the overall results of the detailed run
+  void Validate( const TrafficManager * tm, ostream & os = cout ) const;
+
+};
+
+#endif
@@ -85,7 +85,7 @@ int BatchTrafficManager::_IssuePacket( int source, int cl )
 	  (_requestsOutstanding[source] < _max_outstanding))) {
 	
 	//coin toss to determine request type.
-	result = (RandomFloat() < 0.5) ? 2 : 1;
+	result = (_packet_random[cl * _nodes + source].Float() < 0.5) ? 2 : 1;
       
 	_requestsOutstanding[source]++;
       }
@@ -94,7 +94,7 @@ int BatchTrafficManager::_IssuePacket( int source, int cl )
     if((_packet_seq_no[source] < _batch_size) && 
        ((_max_outstanding <= 0) || 
 	(_requestsOutstanding[source] < _max_outstanding))) {
-      result = _GetNextPacketSize(cl);
+      result = _GetNextPacketSize(cl, source);
       _requestsOutstanding[source]++;
     }
   }
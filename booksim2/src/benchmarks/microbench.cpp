@@ -0,0 +1,1123 @@
+/*
+ * microbench.cpp
+ * - Standalone microbenchmarks of the allocators, arbiters and routing
+ *   functions outside of a network run: randomized request patterns,
+ *   ns/op, grant and route quality, checks against reference models and
+ *   against recorded grant / route trace checksums
+ *
+ *   make microbench
+ *   ./booksim_microbench --filter=islip --sizes=5,20 --density=0.5
+ *   ./booksim_microbench --update           # record new trace checksums
+ *   ./booksim_microbench k=4 num_vcs=4      # routing on a 4-ary network
+ *   ./booksim_microbench --filter=^sim_     # concurrent simulations
+ *                                           # against ./booksim runs
+ *   ./booksim_microbench --filter=^rng_     # random number generators
+ *
+ * Dashed options configure the benchmark, param=value pairs and config
+ * files configure the networks the routing functions run on. Exit status
+ * is non-zero when a check fails or a trace no longer matches.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "booksim.hpp"
+#include "booksim_config.hpp"
+#include "allocator.hpp"
+#include "arbiter.hpp"
+#include "prio_arb.hpp"
+#include "routefunc.hpp"
+#include "network.hpp"
+#include "flit.hpp"
+#include "outputset.hpp"
+#include "random_utils.hpp"
+#include "profiler.hpp"
+#include "trafficmanager.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// the functions of main.cpp, only the simulation benchmarks run a traffic
+// manager
+
+int GetSimTime() {
+  TrafficManager * const tm = gSimContext->traffic_manager;
+  return tm ? tm->getTime() : 0;
+}
+
+class Stats;
+Stats * GetStats(const std::string & name) {
+  TrafficManager * const tm = gSimContext->traffic_manager;
+  return tm ? tm->getStats(name) : NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Options {
+  vector<int> sizes;
+  double density;
+  int priorities;
+  int patterns;
+  double min_time;
+  int seed;
+  string filter;
+  string reference;
+  string booksim;  // the simulator binary, see BenchSimulations
+  bool update;
+};
+
+struct Result {
+  string name;
+  double ns_per_op;
+  double quality;   // matches / maximum matching, minimal / routed hops,
+                    // speedup of concurrent simulations or over the
+                    // Knuth generator
+  double fairness;  // Jain's index of the per-input service, < 0 if n/a
+  unsigned long long checksum;
+  string check;     // empty when the reference checks passed
+};
+
+// requests are drawn from their own stream, so the patterns do not depend
+// on what the benchmarked code draws from the simulator generator
+class PatternRandom {
+  unsigned long long _state;
+
+ public:
+  PatternRandom(int seed) : _state(0x9E3779B97F4A7C15ULL * (seed + 1)) {}
+
+  // splitmix64
+  unsigned long long Next() {
+    unsigned long long z = (_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+  double Float() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+  int Int(int n) { return (int)(Next() % (unsigned long long)n); }
+};
+
+struct Request {
+  int in;
+  int out;
+  int in_pri;
+  int out_pri;
+};
+typedef vector<Request> Pattern;
+
+static double WallTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+// FNV-1a over the grant / route trace
+static inline void Hash(unsigned long long & h, int v) {
+  h ^= (unsigned int)v;
+  h *= 1099511628211ULL;
+}
+static const unsigned long long HASH_INIT = 14695981039346656037ULL;
+
+static double Jain(const vector<long long> & served,
+                   const vector<long long> & requested) {
+  double sum = 0.0, sum2 = 0.0;
+  int n = 0;
+  for (size_t i = 0; i < served.size(); ++i) {
+    if (requested[i] == 0) continue;
+    double const s = (double)served[i] / requested[i];
+    sum += s;
+    sum2 += s * s;
+    ++n;
+  }
+  return (sum2 > 0.0) ? sum * sum / (n * sum2) : 1.0;
+}
+
+// keeps the timed loops from being optimized away
+static volatile int gSink;
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocators
+
+static vector<Pattern> AllocPatterns(int size, const Options & opts) {
+  PatternRandom rng(opts.seed);
+  vector<Pattern> patterns(opts.patterns);
+  for (int p = 0; p < opts.patterns; ++p) {
+    for (int in = 0; in < size; ++in) {
+      for (int out = 0; out < size; ++out) {
+        if (rng.Float() < opts.density) {
+          Request r;
+          r.in = in;
+          r.out = out;
+          r.in_pri = rng.Int(opts.priorities);
+          r.out_pri = rng.Int(opts.priorities);
+          patterns[p].push_back(r);
+        }
+      }
+    }
+  }
+  return patterns;
+}
+
+static bool Augment(int in, const vector<vector<int> > & adj,
+                    vector<int> & out_match, vector<bool> & seen) {
+  for (size_t i = 0; i < adj[in].size(); ++i) {
+    int const out = adj[in][i];
+    if (seen[out]) continue;
+    seen[out] = true;
+    if (out_match[out] < 0 || Augment(out_match[out], adj, out_match, seen)) {
+      out_match[out] = in;
+      return true;
+    }
+  }
+  return false;
+}
+
+// reference maximum matching, augmenting paths
+static int MaxMatching(const Pattern & pattern, int size) {
+  vector<vector<int> > adj(size);
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    adj[pattern[i].in].push_back(pattern[i].out);
+  }
+  vector<int> out_match(size, -1);
+  int matched = 0;
+  for (int in = 0; in < size; ++in) {
+    vector<bool> seen(size, false);
+    if (Augment(in, adj, out_match, seen)) ++matched;
+  }
+  return matched;
+}
+
+static inline void Load(Allocator * a, const Pattern & pattern) {
+  a->Clear();
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    const Request & r = pattern[i];
+    a->AddRequest(r.in, r.out, 1, r.in_pri, r.out_pri);
+  }
+}
+
+static Result BenchAllocator(const string & type, int size,
+                             const Options & opts) {
+  Result result;
+  ostringstream name;
+  name << "alloc_" << type << "_" << size << "x" << size;
+  result.name = name.str();
+
+  vector<Pattern> patterns = AllocPatterns(size, opts);
+
+  // grants, quality and the reference checks on a fresh allocator
+  RandomSeed(opts.seed);
+  Allocator * a = Allocator::NewAllocator(NULL, "alloc", type, size, size);
+  if (!a) {
+    cerr << "Error: unknown allocator " << type << endl;
+    exit(-1);
+  }
+  vector<long long> requested(size, 0), served(size, 0);
+  long long matched = 0, maximum = 0;
+  result.checksum = HASH_INIT;
+  for (size_t p = 0; p < patterns.size() && result.check.empty(); ++p) {
+    const Pattern & pattern = patterns[p];
+    Load(a, pattern);
+    a->Allocate();
+
+    vector<bool> request(size * size, false);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      request[pattern[i].in * size + pattern[i].out] = true;
+      requested[pattern[i].in] += (i == 0 || pattern[i - 1].in != pattern[i].in);
+    }
+    int grants = 0;
+    vector<bool> out_used(size, false);
+    for (int in = 0; in < size; ++in) {
+      int const out = a->OutputAssigned(in);
+      Hash(result.checksum, out);
+      if (out < 0) continue;
+      if (!request[in * size + out] || out_used[out] ||
+          a->InputAssigned(out) != in) {
+        ostringstream err;
+        err << "invalid grant " << in << " -> " << out << " in pattern " << p;
+        result.check = err.str();
+        break;
+      }
+      out_used[out] = true;
+      ++served[in];
+      ++grants;
+    }
+    int const max_grants = MaxMatching(pattern, size);
+    if (type == "max_size" && grants != max_grants) {
+      ostringstream err;
+      err << grants << " grants, maximum is " << max_grants << " in pattern "
+          << p;
+      result.check = err.str();
+    }
+    matched += grants;
+    maximum += max_grants;
+  }
+  result.quality = maximum ? (double)matched / maximum : 1.0;
+  result.fairness = Jain(served, requested);
+  delete a;
+
+  // timed loop, request loading is part of every allocation in a router
+  a = Allocator::NewAllocator(NULL, "alloc", type, size, size);
+  long long ops = 0;
+  int sink = 0;
+  double const start = WallTime();
+  double elapsed;
+  do {
+    for (size_t p = 0; p < patterns.size(); ++p) {
+      Load(a, patterns[p]);
+      a->Allocate();
+      for (int in = 0; in < size; ++in) {
+        sink += a->OutputAssigned(in);
+      }
+    }
+    ops += patterns.size();
+    elapsed = WallTime() - start;
+  } while (elapsed < opts.min_time);
+  gSink = sink;
+  delete a;
+
+  result.ns_per_op = 1e9 * elapsed / ops;
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Arbiters
+
+static vector<Pattern> ArbPatterns(int size, const Options & opts) {
+  PatternRandom rng(opts.seed);
+  vector<Pattern> patterns(opts.patterns);
+  for (int p = 0; p < opts.patterns; ++p) {
+    for (int in = 0; in < size; ++in) {
+      if (rng.Float() < opts.density) {
+        Request r;
+        r.in = in;
+        r.out = 0;
+        r.in_pri = rng.Int(opts.priorities);
+        r.out_pri = 0;
+        patterns[p].push_back(r);
+      }
+    }
+  }
+  return patterns;
+}
+
+// reference round-robin and least-recently-served (matrix) arbitration,
+// the highest priority wins first
+class ReferenceArbiter {
+  bool _lru;
+  int _size;
+  int _pointer;
+  vector<long long> _served;
+  long long _time;
+
+ public:
+  ReferenceArbiter(bool lru, int size)
+      : _lru(lru), _size(size), _pointer(0), _served(size), _time(0) {
+    // the matrix arbiter starts out favoring the higher inputs
+    for (int i = 0; i < size; ++i) _served[i] = -i;
+  }
+
+  int Arbitrate(const Pattern & pattern) {
+    int winner = -1;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      const Request & r = pattern[i];
+      if (winner < 0) {
+        winner = i;
+        continue;
+      }
+      const Request & w = pattern[winner];
+      if (r.in_pri != w.in_pri) {
+        if (r.in_pri > w.in_pri) winner = i;
+      } else if (_lru) {
+        if (_served[r.in] < _served[w.in]) winner = i;
+      } else if ((r.in - _pointer + _size) % _size <
+                 (w.in - _pointer + _size) % _size) {
+        winner = i;
+      }
+    }
+    if (winner < 0) return -1;
+    int const in = pattern[winner].in;
+    _pointer = (in + 1) % _size;
+    _served[in] = ++_time;
+    return in;
+  }
+};
+
+static Result BenchArbiter(const string & type, int size,
+                           const Configuration & config,
+                           const Options & opts) {
+  Result result;
+  ostringstream name;
+  name << "arb_" << type << "_" << size;
+  result.name = name.str();
+
+  vector<Pattern> patterns = ArbPatterns(size, opts);
+  bool const prio = (type == "prio");
+
+  Arbiter * a = NULL;
+  PriorityArbiter * pa = NULL;
+  if (prio) {
+    pa = new PriorityArbiter(config, NULL, "arb", size);
+  } else {
+    a = Arbiter::NewArbiter(NULL, "arb", type, size);
+  }
+  ReferenceArbiter * ref = NULL;
+  if (type == "round_robin" || prio) {
+    ref = new ReferenceArbiter(false, size);
+  } else if (type == "matrix") {
+    ref = new ReferenceArbiter(true, size);
+  }
+
+  vector<long long> requested(size, 0), served(size, 0);
+  long long grants = 0, busy = 0;
+  result.checksum = HASH_INIT;
+  for (size_t p = 0; p < patterns.size() && result.check.empty(); ++p) {
+    const Pattern & pattern = patterns[p];
+    int winner;
+    if (prio) {
+      pa->Clear();
+      for (size_t i = 0; i < pattern.size(); ++i) {
+        pa->AddRequest(pattern[i].in, pattern[i].in, pattern[i].in_pri);
+      }
+      pa->Arbitrate();
+      winner = pa->Match();
+    } else {
+      a->Clear();
+      for (size_t i = 0; i < pattern.size(); ++i) {
+        a->AddRequest(pattern[i].in, pattern[i].in, pattern[i].in_pri);
+      }
+      winner = a->Arbitrate();
+      a->UpdateState();
+    }
+    Hash(result.checksum, winner);
+
+    bool valid = (winner < 0) == pattern.empty();
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      ++requested[pattern[i].in];
+      valid = valid || (pattern[i].in == winner);
+    }
+    int const expected = ref ? ref->Arbitrate(pattern) : winner;
+    if (!valid || winner != expected) {
+      ostringstream err;
+      err << "winner " << winner << ", expected " << expected
+          << " in pattern " << p;
+      result.check = err.str();
+    }
+    if (winner >= 0) {
+      ++served[winner];
+      ++grants;
+    }
+    busy += !pattern.empty();
+  }
+  result.quality = busy ? (double)grants / busy : 1.0;
+  result.fairness = Jain(served, requested);
+  delete a;
+  delete pa;
+  delete ref;
+
+  long long ops = 0;
+  int sink = 0;
+  double const start = WallTime();
+  double elapsed;
+  if (prio) {
+    pa = new PriorityArbiter(config, NULL, "arb", size);
+    do {
+      for (size_t p = 0; p < patterns.size(); ++p) {
+        pa->Clear();
+        for (size_t i = 0; i < patterns[p].size(); ++i) {
+          const Request & r = patterns[p][i];
+          pa->AddRequest(r.in, r.in, r.in_pri);
+        }
+        pa->Arbitrate();
+        sink += pa->Match();
+      }
+      ops += patterns.size();
+      elapsed = WallTime() - start;
+    } while (elapsed < opts.min_time);
+    delete pa;
+  } else {
+    a = Arbiter::NewArbiter(NULL, "arb", type, size);
+    do {
+      for (size_t p = 0; p < patterns.size(); ++p) {
+        a->Clear();
+        for (size_t i = 0; i < patterns[p].size(); ++i) {
+          const Request & r = patterns[p][i];
+          a->AddRequest(r.in, r.in, r.in_pri);
+        }
+        sink += a->Arbitrate();
+        a->UpdateState();
+      }
+      ops += patterns.size();
+      elapsed = WallTime() - start;
+    } while (elapsed < opts.min_time);
+    delete a;
+  }
+  gSink = sink;
+
+  result.ns_per_op = 1e9 * elapsed / ops;
+  return result;
+}
+
+// groups of about sqrt(size) inputs
+static string TreeArbiterType(int size) {
+  int groups = 1;
+  for (int g = 2; g * g <= size; ++g) {
+    if (size % g == 0) groups = g;
+  }
+  ostringstream type;
+  type << "tree(" << groups << ",round_robin)";
+  return type.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Routing functions
+
+class RouteWalker {
+  Network * _net;
+  tRoutingFunction _rf;
+  map<const FlitChannel *, int> _eject;
+
+ public:
+  long long calls;
+  long long hops;
+
+  RouteWalker(Network * net, tRoutingFunction rf)
+      : _net(net), _rf(rf), calls(0), hops(0) {
+    for (int n = 0; n < net->NumNodes(); ++n) {
+      _eject[net->GetEject(n)] = n;
+    }
+  }
+
+  // routes a head flit hop by hop along the preferred output, returns the
+  // router hops taken or -1 when it does not arrive at its destination
+  int Walk(int src, int dest, vector<int> * ports) {
+    Flit * f = Flit::New();
+    f->src = src;
+    f->dest = dest;
+    f->head = true;
+    f->tail = true;
+
+    OutputSet route;
+    _rf(NULL, f, -1, &route, true);
+    f->vc = route.GetSet().begin()->vc_start;
+
+    FlitChannel * chan = _net->GetInject(src);
+    int taken = 0;
+    int result = -1;
+    int const limit = 4 * _net->NumRouters();
+    while (taken <= limit) {
+      Router * r = chan->GetSink();
+      _rf(r, f, chan->GetSinkPort(), &route, false);
+      ++calls;
+      const set<OutputSet::sSetElement> & outputs = route.GetSet();
+      if (outputs.empty()) break;
+      set<OutputSet::sSetElement>::const_iterator best = outputs.begin();
+      for (set<OutputSet::sSetElement>::const_iterator i = outputs.begin();
+           i != outputs.end(); ++i) {
+        if (i->pri > best->pri) best = i;
+      }
+      if (ports) ports->push_back(best->output_port);
+      f->vc = best->vc_start;
+      chan = r->GetOutputChannel(best->output_port);
+      if (!chan->GetSink()) {
+        map<const FlitChannel *, int>::const_iterator e = _eject.find(chan);
+        if (e != _eject.end() && e->second == dest) result = taken;
+        break;
+      }
+      ++taken;
+    }
+    hops += taken;
+    f->Free();
+    return result;
+  }
+};
+
+// minimal router hops, the mesh is built with unused wraparound channels
+static int MinimalHops(int src, int dest, bool torus) {
+  int hops = 0;
+  for (int dim = 0, stride = 1; dim < gN; ++dim, stride *= gK) {
+    int const d = abs((src / stride) % gK - (dest / stride) % gK);
+    hops += torus ? min(d, gK - d) : d;
+  }
+  return hops;
+}
+
+// dimension-order output ports of a mesh, independent of dor_next_mesh
+static vector<int> ReferenceDOR(int src, int dest) {
+  vector<int> ports;
+  for (int dim = 0, stride = 1; dim < gN; ++dim, stride *= gK) {
+    int const cur = (src / stride) % gK;
+    int const dst = (dest / stride) % gK;
+    for (int i = cur; i != dst; i += (cur < dst) ? 1 : -1) {
+      ports.push_back(2 * dim + ((cur < dst) ? 0 : 1));
+    }
+  }
+  ports.push_back(2 * gN);
+  return ports;
+}
+
+static Result BenchRouting(const string & rf_name, Network * net,
+                           const string & topo, const Options & opts) {
+  Result result;
+  ostringstream name;
+  name << "route_" << rf_name << "_k" << gK << "n" << gN;
+  result.name = name.str();
+  result.fairness = -1.0;
+
+  tRoutingFunction rf = gRoutingFunctionMap[rf_name];
+  bool const dor = (topo == "mesh") &&
+                   (rf_name.compare(0, 3, "dor") == 0 ||
+                    rf_name.compare(0, 9, "dim_order") == 0);
+  int const nodes = net->NumNodes();
+
+  RandomSeed(opts.seed);
+  RouteWalker walker(net, rf);
+  long long minimal = 0, routed = 0;
+  result.checksum = HASH_INIT;
+  for (int src = 0; src < nodes && result.check.empty(); ++src) {
+    for (int dest = 0; dest < nodes && result.check.empty(); ++dest) {
+      vector<int> ports;
+      int const taken = walker.Walk(src, dest, &ports);
+      for (size_t i = 0; i < ports.size(); ++i) {
+        Hash(result.checksum, ports[i]);
+      }
+      ostringstream err;
+      if (taken < 0) {
+        err << "packet " << src << " -> " << dest << " not delivered";
+      } else if (dor && ports != ReferenceDOR(src, dest)) {
+        err << "packet " << src << " -> " << dest
+            << " left dimension order";
+      }
+      result.check = err.str();
+      minimal += MinimalHops(src, dest, topo == "torus");
+      routed += taken;
+    }
+  }
+  result.quality = routed ? (double)minimal / routed : 1.0;
+
+  RouteWalker timed(net, rf);
+  double const start = WallTime();
+  double elapsed;
+  do {
+    for (int src = 0; src < nodes; ++src) {
+      for (int dest = 0; dest < nodes; ++dest) {
+        timed.Walk(src, dest, NULL);
+      }
+    }
+    elapsed = WallTime() - start;
+  } while (elapsed < opts.min_time);
+
+  result.ns_per_op = 1e9 * elapsed / timed.calls;
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// a complete simulation in a context of its own, as in main.cpp
+struct Simulation {
+  BookSimConfig config;
+  bool result;
+  int cycles;
+  string stats;  // the overall stats in CSV form
+  double elapsed;
+
+  void Run() {
+    SimContext context;
+    gSimContext = &context;
+    double const start = WallTime();
+    InitializeRoutingMap(config);
+    vector<Network *> net(config.GetInt("subnets"));
+    for (size_t i = 0; i < net.size(); ++i) {
+      ostringstream name;
+      name << "network_" << i;
+      net[i] = Network::New(config, name.str());
+    }
+    context.traffic_manager = TrafficManager::New(config, net);
+    result = context.traffic_manager->Run();
+    cycles = context.traffic_manager->getTime();
+    ostringstream csv;
+    context.traffic_manager->DisplayOverallStatsCSV(csv);
+    stats = csv.str();
+    delete context.traffic_manager;
+    context.traffic_manager = NULL;
+    for (size_t i = 0; i < net.size(); ++i) {
+      delete net[i];
+    }
+    elapsed = WallTime() - start;
+    gSimContext = NULL;
+  }
+};
+
+static void RunSimulation(Simulation * sim) { sim->Run(); }
+
+// the same simulation as a booksim process, whose overall stats in CSV form
+// are the reference for the threads; the settings go to a config file
+static void RunBookSim(const string & booksim, const vector<string> & settings,
+                       Simulation * sim) {
+  sim->result = false;
+  sim->cycles = 0;
+  sim->elapsed = 0.0;
+  char path[] = "/tmp/booksim_microbench_XXXXXX";
+  int const fd = mkstemp(path);
+  if (fd < 0) return;
+  close(fd);
+  ofstream cfg(path);
+  for (size_t i = 0; i < settings.size(); ++i) {
+    cfg << settings[i] << ";" << endl;
+  }
+  cfg.close();
+
+  string const command = booksim + " " + path + " print_csv_results=1 2>&1";
+  double const start = WallTime();
+  FILE * const out = popen(command.c_str(), "r");
+  if (!out) {
+    remove(path);
+    return;
+  }
+  const char * const csv[] = {"results:", "replications:", "sampling:"};
+  string line;
+  char buf[4096];
+  while (fgets(buf, sizeof(buf), out)) {
+    line += buf;
+    if (line[line.size() - 1] != '\n') continue;
+    for (size_t i = 0; i < sizeof(csv) / sizeof(*csv); ++i) {
+      if (line.compare(0, strlen(csv[i]), csv[i]) == 0) sim->stats += line;
+    }
+    // the last run of sim_count
+    if (line.compare(0, 14, "Time taken is ") == 0) {
+      sim->cycles = atoi(line.c_str() + 14);
+    }
+    line.clear();
+  }
+  pclose(out);
+  sim->elapsed = WallTime() - start;
+  remove(path);
+  // booksim exits non-zero on success, the stats tell
+  sim->result = !sim->stats.empty();
+}
+
+// differently configured simulations on their own threads must give the
+// results booksim gives for them; ns/op is per simulated cycle, quality
+// the speedup over running them one after the other as booksim processes
+static Result BenchSimulations(const vector<vector<string> > & settings,
+                               const string & name, const Options & opts) {
+  Result result;
+  result.name = name;
+  result.fairness = -1.0;
+  result.checksum = HASH_INIT;
+
+  int const n = settings.size();
+  vector<Simulation> serial(n), concurrent(n);
+  for (int i = 0; i < n; ++i) {
+    for (size_t j = 0; j < settings[i].size(); ++j) {
+      concurrent[i].config.ParseString(settings[i][j]);
+    }
+  }
+
+  double serial_time = 0.0;
+  for (int i = 0; i < n; ++i) {
+    RunBookSim(opts.booksim, settings[i], &serial[i]);
+    serial_time += serial[i].elapsed;
+  }
+
+  // the simulations report to the console, which is shared
+  SimContext * const context = gSimContext;
+  streambuf * const console = cout.rdbuf(NULL);
+  double const start = WallTime();
+  vector<thread> threads;
+  for (int i = 0; i < n; ++i) {
+    threads.push_back(thread(RunSimulation, &concurrent[i]));
+  }
+  for (int i = 0; i < n; ++i) {
+    threads[i].join();
+  }
+  double const concurrent_time = WallTime() - start;
+  cout.rdbuf(console);
+  gSimContext = context;
+
+  long long cycles = 0;
+  for (int i = 0; i < n; ++i) {
+    if (!serial[i].result) {
+      result.check = "booksim reference run failed, see --booksim";
+    } else if (!concurrent[i].result) {
+      result.check = "simulation did not complete";
+    } else if (concurrent[i].stats != serial[i].stats ||
+               concurrent[i].cycles != serial[i].cycles) {
+      result.check = "concurrent results differ from booksim";
+    }
+    for (size_t c = 0; c < serial[i].stats.size(); ++c) {
+      Hash(result.checksum, serial[i].stats[c]);
+    }
+    cycles += concurrent[i].cycles;
+  }
+  result.ns_per_op = cycles ? 1e9 * concurrent_time / cycles : 0.0;
+  result.quality = serial_time / concurrent_time;
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Random streams
+
+// Philox4x32-10 known answers of the Random123 distribution
+static string PhiloxKnownAnswers() {
+  static const unsigned int kat[][7] = {
+    {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+     0x6627e8d5},
+    {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+     0x408f276d},
+    {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+     0xd16cfe09}
+  };
+  for (int i = 0; i < 3; ++i) {
+    unsigned int ctr[4] = {kat[i][0], kat[i][1], kat[i][2], kat[i][3]};
+    Philox4x32(ctr, kat[i][4], kat[i][5]);
+    if (ctr[0] != kat[i][6]) {
+      ostringstream err;
+      err << "Philox known answer " << i << " differs";
+      return err.str();
+    }
+  }
+  return "";
+}
+
+// ns/op per 32-bit draw of the Knuth generator, or of a counter-based
+// stream one at a time or in bulk; the checksum covers the first draws
+// and the streams must agree whichever way they are drawn
+static Result BenchRandom(const string & kind, double knuth_ns,
+                          const Options & opts) {
+  Result result;
+  result.name = "rng_" + kind;
+  result.fairness = -1.0;
+  result.checksum = HASH_INIT;
+
+  bool const streams = (kind != "knuth");
+  bool const legacy = gSimContext->random_streams;
+  gSimContext->random_streams = streams;
+  gSimContext->random_seed = opts.seed;
+  RandomSeed(opts.seed);
+
+  int const n = 4096;
+  vector<unsigned int> draws(n);
+  RandomStream random(RandomStream::packet, 0);
+  for (int i = 0; i < n; ++i) {
+    draws[i] = streams ? random.Next() : RandomIntLong();
+    Hash(result.checksum, draws[i]);
+  }
+  if (streams) {
+    result.check = PhiloxKnownAnswers();
+    vector<unsigned int> bulk(n);
+    RandomStream again(RandomStream::packet, 0);
+    again.Next();
+    bulk[0] = draws[0];
+    again.Fill(&bulk[1], 1000);
+    again.Skip(95);
+    again.Fill(&bulk[1096], n - 1096);
+    copy(draws.begin() + 1001, draws.begin() + 1096, bulk.begin() + 1001);
+    if (result.check.empty() && bulk != draws) {
+      result.check = "bulk or skipped draws differ";
+    }
+  }
+
+  // timed loop
+  long long ops = 0;
+  unsigned int sink = 0;
+  double const start = WallTime();
+  double elapsed;
+  do {
+    if (kind == "philox_fill") {
+      random.Fill(&draws[0], n);
+      sink += draws[n - 1];
+    } else if (streams) {
+      for (int i = 0; i < n; ++i) sink += random.Next();
+    } else {
+      for (int i = 0; i < n; ++i) sink += RandomIntLong();
+    }
+    ops += n;
+    elapsed = WallTime() - start;
+  } while (elapsed < opts.min_time);
+  gSink = sink;
+  gSimContext->random_streams = legacy;
+
+  result.ns_per_op = 1e9 * elapsed / ops;
+  result.quality = (knuth_ns > 0.0) ? knuth_ns / result.ns_per_op : 1.0;
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static map<string, unsigned long long> LoadReference(const string & file,
+                                                     const string & header) {
+  map<string, unsigned long long> reference;
+  ifstream in(file.c_str());
+  string line;
+  if (!getline(in, line)) return reference;
+  if (line != header) {
+    cout << "Reference " << file << " was recorded with other options, "
+         << "traces are not compared" << endl;
+    return reference;
+  }
+  string name, checksum;
+  while (in >> name >> checksum) {
+    reference[name] = strtoull(checksum.c_str(), NULL, 16);
+  }
+  return reference;
+}
+
+static void Display(const Result & r, const string & trace) {
+  cout << left << setw(48) << r.name << right << fixed << setprecision(1)
+       << setw(10) << r.ns_per_op << " ns/op" << setprecision(3)
+       << "  quality " << setw(5) << r.quality << "  fairness ";
+  if (r.fairness < 0.0) {
+    cout << "    -";
+  } else {
+    cout << setw(5) << r.fairness;
+  }
+  cout << "  " << (r.check.empty() ? trace : "FAILED: " + r.check) << endl;
+  cout.unsetf(ios::fixed);
+}
+
+// prints every result against its recorded trace, in benchmark order
+struct Report {
+  const map<string, unsigned long long> & reference;
+  vector<Result> results;
+  int failures;
+  int mismatches;
+
+  Report(const map<string, unsigned long long> & ref)
+      : reference(ref), failures(0), mismatches(0) {}
+
+  void Add(const Result & r) {
+    string trace = "new";
+    map<string, unsigned long long>::const_iterator i = reference.find(r.name);
+    if (i != reference.end()) {
+      trace = (i->second == r.checksum) ? "trace ok" : "TRACE MISMATCH";
+      mismatches += (i->second != r.checksum);
+    }
+    failures += !r.check.empty();
+    Display(r, trace);
+    results.push_back(r);
+  }
+};
+
+static vector<int> ParseSizes(const string & str) {
+  vector<int> sizes;
+  istringstream in(str);
+  string size;
+  while (getline(in, size, ',')) {
+    sizes.push_back(atoi(size.c_str()));
+  }
+  return sizes;
+}
+
+int main(int argc, char **argv) {
+  SimContext context;
+  gSimContext = &context;
+
+  Options opts;
+  opts.sizes = ParseSizes("5,20,64");
+  opts.density = 0.25;
+  opts.priorities = 1;
+  opts.patterns = 1000;
+  opts.min_time = 0.2;
+  opts.seed = 1;
+  opts.reference = "../utils/microbench_reference.txt";
+  opts.booksim = "./booksim";
+  opts.update = false;
+
+  // ParseArgs would take --option=value for a parameter override
+  vector<char *> config_args(1, argv[0]);
+  for (int i = 1; i < argc; ++i) {
+    string arg(argv[i]);
+    if (arg[0] != '-') {
+      config_args.push_back(argv[i]);
+      continue;
+    }
+    size_t pos = arg.find('=');
+    string const key = arg.substr(0, pos);
+    string const value = (pos == string::npos) ? "" : arg.substr(pos + 1);
+    if (key == "--sizes") {
+      opts.sizes = ParseSizes(value);
+    } else if (key == "--density") {
+      opts.density = atof(value.c_str());
+    } else if (key == "--priorities") {
+      opts.priorities = atoi(value.c_str());
+    } else if (key == "--patterns") {
+      opts.patterns = atoi(value.c_str());
+    } else if (key == "--min-time") {
+      opts.min_time = atof(value.c_str());
+    } else if (key == "--seed") {
+      opts.seed = atoi(value.c_str());
+    } else if (key == "--filter") {
+      opts.filter = value;
+    } else if (key == "--reference") {
+      opts.reference = value;
+    } else if (key == "--booksim") {
+      opts.booksim = value;
+    } else if (key == "--update") {
+      opts.update = true;
+    } else {
+      cerr << "Usage: " << argv[0] << " [--sizes=5,20,64] [--density=0.25]"
+           << " [--priorities=1] [--patterns=1000] [--min-time=0.2]"
+           << " [--seed=1] [--filter=regex] [--reference=file] [--update]"
+           << " [--booksim=./booksim]"
+           << " [configfile...] [param=value...]" << endl;
+      return 2;
+    }
+  }
+  if (opts.sizes.empty() || opts.priorities < 1 || opts.patterns < 1) {
+    cerr << "Error: invalid microbenchmark options" << endl;
+    return 2;
+  }
+
+  BookSimConfig config;
+  ParseArgs(&config, config_args.size(), &config_args[0]);
+  InitializeRoutingMap(config);
+  regex const filter(opts.filter);
+
+  ostringstream header;
+  header << "# microbench density=" << opts.density
+         << " priorities=" << opts.priorities
+         << " patterns=" << opts.patterns << " seed=" << opts.seed;
+  map<string, unsigned long long> reference =
+      LoadReference(opts.reference, header.str());
+
+  const char * const allocators[] = {
+    "max_size", "pim(1)", "pim(3)", "islip(1)", "islip(3)", "loa",
+    "wavefront", "rr_wavefront", "select(1)",
+    "separable_input_first(round_robin)", "separable_input_first(matrix)",
+    "separable_output_first(round_robin)", "separable_output_first(matrix)"
+  };
+  const char * const arbiters[] = {"round_robin", "matrix", "tree", "prio"};
+
+  Report report(reference);
+
+  for (size_t s = 0; s < opts.sizes.size(); ++s) {
+    int const size = opts.sizes[s];
+    for (size_t i = 0; i < sizeof(allocators) / sizeof(*allocators); ++i) {
+      ostringstream name;
+      name << "alloc_" << allocators[i] << "_" << size << "x" << size;
+      if (!regex_search(name.str(), filter)) continue;
+      report.Add(BenchAllocator(allocators[i], size, opts));
+    }
+  }
+  for (size_t s = 0; s < opts.sizes.size(); ++s) {
+    int const size = opts.sizes[s];
+    for (size_t i = 0; i < sizeof(arbiters) / sizeof(*arbiters); ++i) {
+      string type = arbiters[i];
+      ostringstream name;
+      name << "arb_" << (type == "tree" ? TreeArbiterType(size) : type) << "_"
+           << size;
+      if (!regex_search(name.str(), filter)) continue;
+      if (type == "tree") type = TreeArbiterType(size);
+      report.Add(BenchArbiter(type, size, config, opts));
+    }
+  }
+
+  // every routing function registered for the mesh and the torus, on an
+  // idle network of input-queued routers with all routers powered on
+  const char * const topologies[] = {"mesh", "torus"};
+  for (size_t t = 0; t < sizeof(topologies) / sizeof(*topologies); ++t) {
+    string const topo = topologies[t];
+    string const suffix = "_" + topo;
+    ostringstream size;
+    size << "_k" << config.GetInt("k") << "n" << config.GetInt("n");
+    vector<string> functions;
+    for (map<string, tRoutingFunction>::const_iterator i =
+             gRoutingFunctionMap.begin();
+         i != gRoutingFunctionMap.end(); ++i) {
+      const string & rf = i->first;
+      if (rf.size() <= suffix.size() ||
+          rf.compare(rf.size() - suffix.size(), suffix.size(), suffix) != 0)
+        continue;
+      // follow the ring and routing tables the RP fabric manager sets up
+      if (rf == "rp_mesh" || rf == "ring_dateline_mesh") continue;
+      if (regex_search("route_" + rf + size.str(), filter)) {
+        functions.push_back(rf);
+      }
+    }
+    if (functions.empty()) continue;
+
+    BookSimConfig net_config = config;
+    net_config.Assign("topology", topo);
+    net_config.Assign("routing_function", "dim_order");
+    net_config.Assign("router", "iq");
+    net_config.Assign("powergate_type", "no_pg");
+    Network * net = Network::New(net_config, "microbench_" + topo);
+    for (size_t i = 0; i < functions.size(); ++i) {
+      // the per-destination VC variants split the VCs among the nodes or
+      // among the coordinates of a dimension
+      const string & rf = functions[i];
+      int const vcs = (rf.find("_pni_") != string::npos) ? gK
+          : (rf.find("_ni_") != string::npos) ? gNodes : 1;
+      if (gNumVCs < vcs) {
+        cout << left << setw(48) << "route_" + rf + size.str() << right
+             << "  skipped, needs num_vcs >= " << vcs << endl;
+        continue;
+      }
+      report.Add(BenchRouting(rf, net, topo, opts));
+    }
+    delete net;
+  }
+
+  // a mesh and a torus of different sizes, loads and seeds, as in the
+  // throughput benchmark
+  if (regex_search("sim_mesh_torus_concurrent", filter)) {
+    const char * const common[] = {
+      "sim_type=throughput", "converged_threshold=-1", "warmup_periods=1",
+      "sample_period=1000", "max_samples=4", "sim_count=1",
+      "latency_thres=-1.0", "injection_rate_uses_flits=1", "sim_power=0",
+      "packet_size=4", "router=iq", "powergate_type=no_pg"
+    };
+    const char * const sims[][4] = {
+      {"topology=mesh", "k=8", "routing_function=dor", "injection_rate=0.1"},
+      {"topology=torus", "k=4", "routing_function=dim_order",
+       "injection_rate=0.3"}
+    };
+    vector<vector<string> > settings(2);
+    for (int i = 0; i < 2; ++i) {
+      settings[i].assign(common, common + sizeof(common) / sizeof(*common));
+      settings[i].insert(settings[i].end(), sims[i], sims[i] + 4);
+      ostringstream seed;
+      seed << "seed=" << i + 1;
+      settings[i].push_back(seed.str());
+    }
+    report.Add(BenchSimulations(settings, "sim_mesh_torus_concurrent", opts));
+  }
+
+  const char * const generators[] = {"knuth", "philox_next", "philox_fill"};
+  double knuth_ns = 0.0;
+  for (size_t i = 0; i < sizeof(generators) / sizeof(*generators); ++i) {
+    if (!regex_search(string("rng_") + generators[i], filter)) continue;
+    report.Add(BenchRandom(generators[i], knuth_ns, opts));
+    if (i == 0) knuth_ns = report.results.back().ns_per_op;
+  }
+
+  const vector<Result> & results = report.results;
+  if (opts.update) {
+    ofstream out(opts.reference.c_str());
+    if (!out) {
+      cerr << "Error: cannot write " << opts.reference << endl;
+      return 1;
+    }
+    out << header.str() << endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+      char checksum[17];
+      snprintf(checksum, sizeof(checksum), "%016llx", results[i].checksum);
+      out << results[i].name << " " << checksum << endl;
+    }
+    cout << "Traces written to " << opts.reference << endl;
+  }
+
+  cout << report.failures << " failed check(s), " << report.mismatches
+       << " trace mismatch(es)" << endl;
+  return (report.failures || report.mismatches) ? 1 : 0;
+}
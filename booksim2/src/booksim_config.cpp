@@ -114,6 +114,11 @@ BookSimConfig::BookSimConfig() {
 
   _int_map["max_held_slots"] = -1;
 
+  // buffer_policy = damq: per-port flit pool with linked-list VCs
+  _int_map["damq_vc_min"] = 1;        // slots reserved per VC
+  _int_map["damq_shared_size"] = -1;  // shared region, -1 = rest of the pool
+  _int_map["damq_vc_max"] = -1;       // per-VC cap, -1 = reserved + shared
+
   _int_map["feedback_aging_scale"] = 1;
   _int_map["feedback_offset"] = 0;
 
@@ -131,6 +136,8 @@ BookSimConfig::BookSimConfig() {
 
   _int_map["hold_switch_for_packet"] =
       0;  // hold a switch config for the entire packet
+  _int_map["packet_chain_max"] =
+      1;  // packets that may reuse a held switch config back to back
 
   _int_map["input_speedup"] = 1;   // expansion of input ports into crossbar
   _int_map["output_speedup"] = 1;  // expansion of output ports into crossbar
@@ -140,6 +147,8 @@ BookSimConfig::BookSimConfig() {
   _int_map["sw_alloc_delay"] = 1;
   _int_map["st_prepare_delay"] = 0;
   _int_map["st_final_delay"] = 1;
+  _int_map["single_cycle"] =
+      0;  // route, VC select and traverse in one cycle when uncontended
 
   //==== Event-driven =====================================
 
@@ -290,9 +299,43 @@ BookSimConfig::BookSimConfig() {
 
   _int_map["seed"] = 0;     // random seed for simulation, e.g. traffic
   AddStrField("seed", "");  // workaround to allow special "time" value
-
+  _int_map["random_streams"] = 0; // counter-based stream per source, router and allocator instead of one shared stream
+
+  // independent replications with seeds seed, seed + 1, ..., the first runs
+  // in this traffic manager and the others on worker threads
+  _int_map["replications"] = 1;
+  _int_map["replication_workers"] = 0;  // replications at a time, 0 = online CPUs
+  _int_map["replication_min"] = 3;      // before stopping on replication_ci
+  _float_map["replication_ci"] = 0.0;   // stop once every CI half-width is below this fraction of its mean
+  _float_map["replication_confidence"] = 0.95;
+  AddStrField("replication_log", "");   // output of replication i to <replication_log>.<i>
+
+  // sampled simulation, detailed windows between fast-forward periods in
+  // which packets are delivered with the latency of the previous window
+  _int_map["sampling"] = 0;
+  _int_map["sampling_windows"] = 10;      // measured windows, the overall statistics average them
+  _int_map["sampling_warmup"] = 1000;     // unmeasured detailed cycles ahead of each window
+  _int_map["sampling_window"] = 1000;     // measured cycles per window
+  _int_map["sampling_interval"] = 10000;  // fast-forward cycles between windows
+  _float_map["sampling_confidence"] = 0.95;
+
+  // discrete-event kernel: only channels and routers with work are
+  // evaluated and idle cycles are skipped, the statistics stay the same
+  _int_map["event_kernel"] = 0;
+
+  // iSLIP allocators of a baseline DOR mesh (iq routers, private
+  // buffers, no power gating) on flat per-network arrays, same grants
+  _int_map["mesh_kernel"] = 1;
+
+  // queueing-model estimate from the routing function and traffic pattern,
+  // 1 = instead of the simulation, 2 = ahead of it and validated against it
+  _int_map["analytical_model"] = 0;
+  _int_map["analytical_samples"] = 64;  // destination draws per source and class
+  
   _int_map["print_activity"] = 0;
 
+  _int_map["profile"] = 0; // self-profile of the simulator pipeline stages
+
   _int_map["print_csv_results"] = 0;
 
   _int_map["deadlock_warn_timeout"] = 256;
@@ -341,6 +384,14 @@ BookSimConfig::BookSimConfig() {
   /* ==== DSENT power model - Begin ==== */
   // use dsent, set dsent_model = 1 in config file
   _int_map["dsent_model"] = 0;
+  // evaluate the energy/power parameters below with DSENT at startup,
+  // results are cached in dsent_cache_dir keyed by the router/link parameters
+  _int_map["dsent_eval"] = 0;
+  _int_map["dsent_router_ports"] = 0;  // 0: derived from the topology
+  _float_map["dsent_rr_link_length"] = 1.0e-3;  // meters
+  _float_map["dsent_rs_link_length"] = 1.0e-4;  // meters
+  AddStrField("dsent_tech_model", "../../gem5/ext/dsent/tech/tech_models/Bulk32HVT.model");
+  AddStrField("dsent_cache_dir", "dsent_cache");
   // energy/power parameters, default 32 nm HVT library with FLOV router architecture
   // dynamic
   _float_map["energy_per_buffwrite"] = 3.38124e-12;
@@ -364,6 +415,10 @@ BookSimConfig::BookSimConfig() {
   _float_map["rs_link_leak"] = 1.09052e-05;             // per link
   // frequency
   _float_map["frequency"] = 2.0e+9;
+  // per-router and network power time series, sampled every
+  // power_trace_epoch cycles (0 disables tracing)
+  _int_map["power_trace_epoch"] = 0;
+  AddStrField("power_trace_file", "power_trace.txt");
   /* ==== DSENT power model - End ==== */
 
   /* ==== Power Gate - Begin ==== */
@@ -379,6 +434,22 @@ BookSimConfig::BookSimConfig() {
   _int_map["drain_threshold"] = 100;
   _int_map["bet_threshold"] = 10;
   _int_map["wakeup_threshold"] = 10;
+  // FLOV predictive wakeup: wake a gated router when its next packet is
+  // expected within the lookahead, or a packet is generated towards it
+  // record exact router idle periods and bound gating with an oracle
+  _int_map["flov_oracle_analysis"] = 0;
+  _float_map["flov_oracle_latency_budget"] = 0.0; // wakeup penalty cycles per packet
+  _int_map["flov_predictive_wakeup"] = 0;
+  _int_map["flov_wakeup_lookahead"] = 10;  // cycles, usually wakeup_threshold
+  // runtime core schedule: the off cores wake up for flov_core_on_cycles
+  // every flov_core_period cycles, staggered, 0 keeps them off
+  _int_map["flov_core_period"] = 0;
+  _int_map["flov_core_on_cycles"] = 0;
+  // FLOV multi-hop (SMART) bypass: links a flit may cross in one cycle
+  // through consecutive gated-off routers, 1 disables it
+  _int_map["smart_hpc_max"] = 1;
+  // adaptive_flov: weigh the downstream congestion of a side-band network
+  _int_map["flov_regional_congestion"] = 0;
   _int_map["nord_performance_centric_wakeup_threshold"] = 1; // number of VC requests at NI within monitor epoch
   _int_map["nord_power_centric_wakeup_threshold"] = 3;
   _int_map["nord_wakeup_monitor_epoch"] = 10; // report every 10 cycles
@@ -387,7 +458,22 @@ BookSimConfig::BookSimConfig() {
   _float_map["low_watermark"] = 1.2;
   _float_map["high_watermark"] = 1.5;
   _int_map["flov_monitor_epoch"] = 1000;
+  AddStrField("flov_vote_policy", "row_col"); // can be {row_col, region, local}
+  _int_map["flov_vote_region_size"] = 4; // region side length in routers
+  AddStrField("flov_pg_policy", "watermark"); // local votes: {watermark, qlearn}
+  _float_map["flov_rl_alpha"] = 0.2;          // Q-learning rate
+  _float_map["flov_rl_gamma"] = 0.8;          // discount per monitor epoch
+  _float_map["flov_rl_epsilon"] = 0.1;        // exploration while training
+  _float_map["flov_rl_latency_weight"] = 1.0; // reward per zero-load latency
+  _float_map["flov_rl_leakage_weight"] = 0.5; // reward per powered-on epoch
+  _int_map["flov_rl_train"] = 1;              // 0: greedy on a loaded table
+  _int_map["flov_rl_seed"] = 0;               // exploration random stream
+  AddStrField("flov_rl_qtable", "");          // Q-table loaded/saved here
   _int_map["routing_deadlock_timeout_threshold"] = 512;
+  // Router Parking: epoch-based re-parking by the fabric manager, 0 disables
+  _int_map["rp_reconfig_epoch"] = 0;
+  _int_map["rp_reconfig_compute_latency"] = 100; // table computation at FM
+  _int_map["rp_reconfig_hop_latency"] = 1; // table distribution per hop
   /* ==== Power Gate - End ==== */
 
   //==================Network file===========================
@@ -26,6 +26,8 @@
 */
 
 #include <sstream>
+#include <cassert>
+#include <cstdlib>
 
 #include "globals.hpp"
 #include "booksim.hpp"
@@ -33,7 +35,8 @@
 
 Buffer::Buffer( const Configuration& config, int outputs, 
 		Module *parent, const string& name ) :
-Module( parent, name ), _occupancy(0)
+Module( parent, name ), _occupancy(0), _damq(false),
+  _damq_shared_occupancy(0), _damq_free_head(-1)
 {
   int num_vcs = config.GetInt( "num_vcs" );
 
@@ -44,6 +47,18 @@ Module( parent, name ), _occupancy(0)
 
   _vc.resize(num_vcs);
 
+  if(config.GetStr("buffer_policy") == "damq") {
+    _damq = true;
+    DAMQLimits(config, _size, &_damq_vc_min, &_damq_vc_max, &_damq_shared_size);
+    _damq_next.resize(_size);
+    for(int s = 0; s < _size; ++s) {
+      _damq_next[s] = s + 1 < _size ? s + 1 : -1;
+    }
+    _damq_free_head = _size > 0 ? 0 : -1;
+    _damq_head.resize(num_vcs, -1);
+    _damq_tail.resize(num_vcs, -1);
+  }
+
   for(int i = 0; i < num_vcs; ++i) {
     ostringstream vc_name;
     vc_name << "vc_" << i;
@@ -68,6 +83,30 @@ void Buffer::AddFlit( int vc, Flit *f )
   if(_occupancy >= _size) {
     Error("Flit buffer overflow.");
   }
+  if(_damq) {
+    int const occupancy = _vc[vc]->GetOccupancy();
+    if((occupancy >= _damq_vc_max) ||
+       ((occupancy >= _damq_vc_min) &&
+	(_damq_shared_occupancy >= _damq_shared_size))) {
+      ostringstream err;
+      err << "DAMQ buffer overflow for VC " << vc;
+      Error(err.str());
+    }
+    if(occupancy >= _damq_vc_min) {
+      ++_damq_shared_occupancy;
+    }
+    // link a free slot at the tail of the VC's list
+    int const slot = _damq_free_head;
+    assert(slot >= 0);
+    _damq_free_head = _damq_next[slot];
+    _damq_next[slot] = -1;
+    if(_damq_tail[vc] >= 0) {
+      _damq_next[_damq_tail[vc]] = slot;
+    } else {
+      _damq_head[vc] = slot;
+    }
+    _damq_tail[vc] = slot;
+  }
   ++_occupancy;
   _vc[vc]->AddFlit(f);
 #ifdef TRACK_BUFFERS
@@ -75,6 +114,50 @@ void Buffer::AddFlit( int vc, Flit *f )
 #endif
 }
 
+void Buffer::_DAMQRemoveSlot( int vc )
+{
+  int const slot = _damq_head[vc];
+  assert(slot >= 0);
+  _damq_head[vc] = _damq_next[slot];
+  if(_damq_head[vc] < 0) {
+    _damq_tail[vc] = -1;
+  }
+  _damq_next[slot] = _damq_free_head;
+  _damq_free_head = slot;
+  if(_vc[vc]->GetOccupancy() > _damq_vc_min) {
+    assert(_damq_shared_occupancy > 0);
+    --_damq_shared_occupancy;
+  }
+}
+
+void Buffer::DAMQLimits( const Configuration& config, int pool_size,
+			 int *vc_min, int *vc_max, int *shared_size )
+{
+  int const num_vcs = config.GetInt("num_vcs");
+  *vc_min = config.GetInt("damq_vc_min");
+  if(*vc_min < 0) {
+    *vc_min = 0;
+  }
+  *shared_size = config.GetInt("damq_shared_size");
+  if(*shared_size < 0) {
+    *shared_size = pool_size - num_vcs * *vc_min;
+  }
+  if((*shared_size < 0) || (num_vcs * *vc_min + *shared_size > pool_size)) {
+    cout << "Error: DAMQ reservations (" << num_vcs << " x " << *vc_min
+	 << ") plus shared region (" << *shared_size
+	 << ") exceed the buffer size (" << pool_size << ")" << endl;
+    exit(-1);
+  }
+  *vc_max = config.GetInt("damq_vc_max");
+  if(*vc_max < 0) {
+    *vc_max = *vc_min + *shared_size;
+  }
+  if(*vc_max < 1) {
+    cout << "Error: DAMQ VCs must be able to hold at least one flit" << endl;
+    exit(-1);
+  }
+}
+
 void Buffer::Display( ostream & os ) const
 {
   for(vector<VC*>::const_iterator i = _vc.begin(); i != _vc.end(); ++i) {
@@ -43,6 +43,21 @@ class Buffer : public Module {
 
   vector<VC*> _vc;
 
+  // DAMQ organization: the _size flit slots form one pool, each VC is a
+  // linked list of slots with _damq_vc_min reserved and the rest drawn
+  // from a shared region of _damq_shared_size slots
+  bool _damq;
+  int _damq_vc_min;
+  int _damq_vc_max;
+  int _damq_shared_size;
+  int _damq_shared_occupancy;
+  int _damq_free_head;
+  vector<int> _damq_next;
+  vector<int> _damq_head;
+  vector<int> _damq_tail;
+
+  void _DAMQRemoveSlot( int vc );
+
 #ifdef TRACK_BUFFERS
   vector<int> _class_occupancy;
 #endif
@@ -57,6 +72,9 @@ public:
 
   inline Flit *RemoveFlit( int vc )
   {
+    if(_damq) {
+      _DAMQRemoveSlot(vc);
+    }
     --_occupancy;
 #ifdef TRACK_BUFFERS
     int cl = _vc[vc]->FrontFlit()->cl;
@@ -157,6 +175,10 @@ public:
 
   void Display( ostream & os = cout ) const;
 
+  // per-VC reservation, per-VC cap and shared region of a DAMQ pool
+  static void DAMQLimits( const Configuration& config, int pool_size,
+			  int *vc_min, int *vc_max, int *shared_size );
+
   /* ==== Power Gate - Begin ==== */
   inline void ClearRouteSet( int vc )
   {
@@ -39,6 +39,7 @@
 
 #include "booksim.hpp"
 #include "buffer_state.hpp"
+#include "buffer.hpp"
 #include "random_utils.hpp"
 #include "globals.hpp"
 
@@ -87,6 +88,8 @@ BufferState::BufferPolicy * BufferState::BufferPolicy::New(Configuration const &
     sp = new FeedbackSharedBufferPolicy(config, parent, name);
   } else if(buffer_policy == "simplefeedback") {
     sp = new SimpleFeedbackSharedBufferPolicy(config, parent, name);
+  } else if(buffer_policy == "damq") {
+    sp = new DAMQBufferPolicy(config, parent, name);
   } else {
     cout << "Unknown buffer policy: " << buffer_policy << endl;
   }
@@ -598,6 +601,71 @@ void BufferState::SimpleFeedbackSharedBufferPolicy::FreeSlotFor(int vc)
   SharedBufferPolicy::FreeSlotFor(vc);
 }
 
+BufferState::DAMQBufferPolicy::DAMQBufferPolicy(Configuration const & config, BufferState * parent, const string & name)
+  : BufferPolicy(config, parent, name)
+{
+  _vcs = config.GetInt("num_vcs");
+  int buf_size = config.GetInt("buf_size");
+  if(buf_size < 0) {
+    buf_size = _vcs * config.GetInt("vc_buf_size");
+  }
+  Buffer::DAMQLimits(config, buf_size, &_vc_min, &_vc_max, &_shared_size);
+  _full_vc_max = _vc_max;
+}
+
+// slots held beyond the per-VC reservations; computed from the occupancies
+// so that FLOV's ClearCredits()/FullCredits() need no policy bookkeeping
+int BufferState::DAMQBufferPolicy::_SharedOccupancy() const
+{
+  int shared = 0;
+  for(int v = 0; v < _vcs; ++v) {
+    shared += max(_buffer_state->OccupancyFor(v) - _vc_min, 0);
+  }
+  return shared;
+}
+
+void BufferState::DAMQBufferPolicy::SendingFlit(Flit const * const f)
+{
+  int const vc = f->vc;
+  if((_buffer_state->OccupancyFor(vc) > _vc_max) ||
+      (_SharedOccupancy() > _shared_size)) {
+    ostringstream err;
+    err << "DAMQ buffer overflow for VC " << vc;
+    Error(err.str());
+  }
+}
+
+bool BufferState::DAMQBufferPolicy::IsFullFor(int vc) const
+{
+  int const occupancy = _buffer_state->OccupancyFor(vc);
+  return ((occupancy >= _vc_max) ||
+      ((occupancy >= _vc_min) && (_SharedOccupancy() >= _shared_size)));
+}
+
+int BufferState::DAMQBufferPolicy::AvailableFor(int vc) const
+{
+  int const occupancy = _buffer_state->OccupancyFor(vc);
+  return min(_vc_max - occupancy,
+      max(_vc_min - occupancy, 0) + _shared_size - _SharedOccupancy());
+}
+
+int BufferState::DAMQBufferPolicy::LimitFor(int vc) const
+{
+  return _vc_max;
+}
+
+/* ==== Power Gate - Begin ==== */
+void BufferState::DAMQBufferPolicy::SetVCBufferSize(int vc_buf_size)
+{
+  _vc_max = min(vc_buf_size, _full_vc_max);
+}
+
+void BufferState::DAMQBufferPolicy::ResetVCBufferSize()
+{
+  _vc_max = _full_vc_max;
+}
+/* ==== Power Gate - End ==== */
+
 BufferState::BufferState( const Configuration& config, Module *parent, const string& name ) :
   Module( parent, name ), _occupancy(0)
 {
@@ -773,6 +841,15 @@ void BufferState::FillCredits()
   _buffer_policy->ResetVCBufferSize();
 }
 
+bool BufferState::CanRelayCredits() const
+{
+  for (int vc = 0; vc < _vcs; ++vc) {
+    if (RelayCreditsFor(vc) < 0)
+      return false;
+  }
+  return true;
+}
+
 void BufferState::ResetVCBufferSize() {
   _size = _vcs * _full_vc_buf_size;
   _buffer_policy->ResetVCBufferSize();
@@ -178,6 +178,29 @@ class BufferState : public Module {
     virtual void FreeSlotFor(int vc = 0);
   };
 
+  // credit side of a DAMQ input buffer (see Buffer): per-VC minimum
+  // reservation plus a shared region, all derived from the VC occupancies
+  class DAMQBufferPolicy : public BufferPolicy {
+  protected:
+    int _vcs;
+    int _vc_min;
+    int _vc_max;
+    int _full_vc_max;
+    int _shared_size;
+    int _SharedOccupancy() const;
+  public:
+    DAMQBufferPolicy(Configuration const & config, BufferState * parent,
+        const string & name);
+    virtual void SendingFlit(Flit const * const f);
+    virtual bool IsFullFor(int vc = 0) const;
+    virtual int AvailableFor(int vc = 0) const;
+    virtual int LimitFor(int vc = 0) const;
+    /* ==== Power Gate - Begin ==== */
+    virtual void ResetVCBufferSize();
+    virtual void SetVCBufferSize(int vc_buf_size);
+    /* ==== Power Gate - End ==== */
+  };
+
   bool _wait_for_tail_credit;
   int  _size;
   /* ==== Power Gate - Begin ==== */
@@ -264,6 +287,13 @@ public:
   inline int Size() const {
     return _size;
   }
+  // ClearCredits() charges each VC _size/_vcs slots, an off router hands the
+  // rest back upstream; only exact when no VC holds more than that share
+  inline int RelayCreditsFor( int vc = 0 ) const {
+    assert((vc >= 0) && (vc < _vcs));
+    return _size / _vcs - _vc_occupancy[vc];
+  }
+  bool CanRelayCredits() const;
   /* ==== Power Gate - End ==== */
 
 #ifdef TRACK_BUFFERS
@@ -39,6 +39,7 @@
 
 #include <queue>
 #include <cassert>
+#include <limits>
 
 #include "globals.hpp"
 #include "module.hpp"
@@ -55,6 +56,12 @@ public:
   // Physical Parameters
   void SetLatency(int cycles);
   int GetLatency() const { return _delay ; }
+  /* ==== Power Gate - Begin ==== */
+  // nothing sent this cycle or still in flight
+  bool Empty() const { return !_input && _wait_queue.empty(); }
+  /* ==== Power Gate - End ==== */
+  // event kernel: the module woken when data is delivered
+  void SetReader(TimedModule * reader) { _reader = reader; }
   
   // Send data 
   virtual void Send(T * data);
@@ -65,8 +72,10 @@ public:
   virtual void ReadInputs();
   virtual void Evaluate() {}
   virtual void WriteOutputs();
+  virtual int NextEventTime() const;
 
 protected:
+  TimedModule * _reader;
   int _delay;
   T * _input;
   T * _output;
@@ -76,7 +85,7 @@ protected:
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _reader(0), _delay(1), _input(0), _output(0) {
 }
 
 template<typename T>
@@ -90,6 +99,9 @@ void Channel<T>::SetLatency(int cycles) {
 template<typename T>
 void Channel<T>::Send(T * data) {
   _input = data;
+  if(data) {
+    Wake(GetSimTime() + 1);
+  }
 }
 
 template<typename T>
@@ -120,6 +132,18 @@ void Channel<T>::WriteOutputs() {
   _output = item.second;
   assert(_output);
   _wait_queue.pop();
+  if(_reader) {
+    _reader->Wake(GetSimTime() + 1);
+  }
+}
+
+template<typename T>
+int Channel<T>::NextEventTime() const {
+  if(_input || _output) {
+    return GetSimTime() + 1;
+  }
+  return _wait_queue.empty() ? numeric_limits<int>::max() :
+    _wait_queue.front().first;
 }
 
 #endif
@@ -38,6 +38,7 @@
 extern "C" int yyparse();
 
 class Configuration {
+  // the configuration being parsed, the parser is not reentrant
   static Configuration * theConfig;
   FILE * _config_file;
   string _config_string;
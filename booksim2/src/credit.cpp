@@ -32,9 +32,7 @@
 
 #include "booksim.hpp"
 #include "credit.hpp"
-
-stack<Credit *> Credit::_all;
-stack<Credit *> Credit::_free;
+#include "globals.hpp"
 
 Credit::Credit()
 {
@@ -50,30 +48,33 @@ void Credit::Reset()
 }
 
 Credit * Credit::New() {
+  stack<Credit *> & free_list = gSimContext->free_credits;
   Credit * c;
-  if(_free.empty()) {
+  if(free_list.empty()) {
     c = new Credit();
-    _all.push(c);
+    gSimContext->credits.push(c);
   } else {
-    c = _free.top();
+    c = free_list.top();
     c->Reset();
-    _free.pop();
+    free_list.pop();
   }
   return c;
 }
 
 void Credit::Free() {
-  _free.push(this);
+  gSimContext->free_credits.push(this);
 }
 
 void Credit::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
+  stack<Credit *> & all = gSimContext->credits;
+  while(!all.empty()) {
+    delete all.top();
+    all.pop();
   }
+  gSimContext->free_credits = stack<Credit *>();
 }
 
 
 int Credit::OutStanding(){
-  return _all.size()-_free.size();
+  return gSimContext->credits.size()-gSimContext->free_credits.size();
 }
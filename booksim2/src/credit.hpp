@@ -49,8 +49,6 @@ public:
   static int OutStanding();
 private:
 
-  static stack<Credit *> _all;
-  static stack<Credit *> _free;
 
   Credit();
   ~Credit() {}
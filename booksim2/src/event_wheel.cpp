@@ -0,0 +1,133 @@
+/*
+ * event_wheel.cpp
+ * - Timing wheel of the event kernel (event_kernel = 1): every timed
+ *   module of a network is put on the slot of the next cycle it has work
+ *   in and a cycle evaluates the modules due only; wake-ups further out
+ *   than the wheel wait in an overflow list
+ */
+
+#include <cassert>
+#include <limits>
+
+#include "event_wheel.hpp"
+
+void TimedModule::_Schedule( int time )
+{
+  _event_wheel->Schedule( _event_id, time );
+}
+
+EventWheel::EventWheel( deque<TimedModule *> const & modules,
+                        int channel_modules, int horizon, int time )
+  : _modules( modules.begin( ), modules.end( ) ),
+    _channel_modules( channel_modules ), _time( time - 1 ), _pending( 0 ),
+    _due_channels( 0 )
+{
+  int size = 16;
+  while ( size <= horizon ) {
+    size *= 2;
+  }
+  _mask = size - 1;
+  _words = ( _modules.size( ) + 63 ) / 64;
+  _slots.resize( size, vector<unsigned long long>( _words, 0 ) );
+  _slot_count.resize( size, 0 );
+
+  // nothing is known about the modules yet
+  for ( size_t id = 0; id < _modules.size( ); ++id ) {
+    _modules[id]->SetEventWheel( this, id );
+    Schedule( id, time );
+  }
+}
+
+EventWheel::~EventWheel( )
+{
+  for ( size_t id = 0; id < _modules.size( ); ++id ) {
+    _modules[id]->SetEventWheel( NULL, -1 );
+  }
+}
+
+void EventWheel::Schedule( int id, int time )
+{
+  if ( time <= _time ) {
+    return;
+  }
+  if ( time - _time > _mask ) {
+    _overflow.insert( make_pair( time, id ) );
+  } else {
+    _Insert( id, time );
+  }
+}
+
+void EventWheel::_Insert( int id, int time )
+{
+  int const slot = time & _mask;
+  unsigned long long & word = _slots[slot][id >> 6];
+  unsigned long long const bit = 1ULL << ( id & 63 );
+  if ( !( word & bit ) ) {
+    word |= bit;
+    ++_slot_count[slot];
+    ++_pending;
+  }
+}
+
+vector<TimedModule *> const & EventWheel::Advance( int time )
+{
+  assert( time > _time );
+  // cycles skipped over must not have had any work
+  for ( int t = _time + 1; ( t < time ) && ( t <= _time + _mask ); ++t ) {
+    assert( _slot_count[t & _mask] == 0 );
+  }
+  _time = time;
+
+  while ( !_overflow.empty( ) && ( _overflow.begin( )->first - _time <= _mask ) ) {
+    multimap<int, int>::iterator const iter = _overflow.begin( );
+    _Insert( iter->second, iter->first );
+    _overflow.erase( iter );
+  }
+
+  int const slot = _time & _mask;
+  _due_ids.clear( );
+  _due.clear( );
+  _due_channels = 0;
+  if ( _slot_count[slot] > 0 ) {
+    vector<unsigned long long> & words = _slots[slot];
+    for ( int w = 0; w < _words; ++w ) {
+      unsigned long long word = words[w];
+      words[w] = 0;
+      while ( word ) {
+        int const id = w * 64 + __builtin_ctzll( word );
+        word &= word - 1;
+        _due_ids.push_back( id );
+        _due.push_back( _modules[id] );
+        if ( id < _channel_modules ) {
+          ++_due_channels;
+        }
+      }
+    }
+    _pending -= _slot_count[slot];
+    _slot_count[slot] = 0;
+  }
+  return _due;
+}
+
+void EventWheel::Reschedule( )
+{
+  for ( size_t i = 0; i < _due_ids.size( ); ++i ) {
+    int const time = _due[i]->NextEventTime( );
+    if ( time != numeric_limits<int>::max( ) ) {
+      Schedule( _due_ids[i], time );
+    }
+  }
+}
+
+int EventWheel::NextTime( ) const
+{
+  if ( _pending > 0 ) {
+    for ( int t = _time + 1; t <= _time + _mask; ++t ) {
+      if ( _slot_count[t & _mask] > 0 ) {
+        return t;
+      }
+    }
+  }
+  return _overflow.empty( ) ? numeric_limits<int>::max( ) :
+    _overflow.begin( )->first;
+}
@@ -0,0 +1,67 @@
+/*
+ * event_wheel.hpp
+ * - Timing wheel of the event kernel (event_kernel = 1): every timed
+ *   module of a network is put on the slot of the next cycle it has work
+ *   in and a cycle evaluates the modules due only; wake-ups further out
+ *   than the wheel wait in an overflow list
+ */
+
+#ifndef _EVENT_WHEEL_HPP_
+#define _EVENT_WHEEL_HPP_
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "timed_module.hpp"
+
+using namespace std;
+
+class EventWheel {
+
+  // modules in evaluation order, the first _channel_modules are channels
+  vector<TimedModule *> _modules;
+  int _channel_modules;
+
+  // one bit per module and cycle, the modules due are read off in order
+  int _time;
+  int _mask;
+  int _words;
+  vector<vector<unsigned long long> > _slots;
+  vector<int> _slot_count;
+  int _pending;
+  multimap<int, int> _overflow;
+
+  void _Insert( int id, int time );
+
+  vector<int> _due_ids;
+  vector<TimedModule *> _due;
+  int _due_channels;
+
+public:
+
+  // all modules due at time, no wake-up further than horizon cycles
+  // out stays in the overflow list
+  EventWheel( deque<TimedModule *> const & modules, int channel_modules,
+              int horizon, int time );
+  ~EventWheel( );
+
+  // work for module id at time; a module due in the current cycle is
+  // evaluated anyway, so wake-ups at or before it are dropped
+  void Schedule( int id, int time );
+
+  // the modules due at time in evaluation order, channels first
+  vector<TimedModule *> const & Advance( int time );
+  inline vector<TimedModule *> const & Due( ) const { return _due; }
+  inline int DueChannels( ) const { return _due_channels; }
+
+  // puts the modules just evaluated back at their next event
+  void Reschedule( );
+
+  // the earliest cycle after the current one with work, or
+  // numeric_limits<int>::max() when there is none
+  int NextTime( ) const;
+
+};
+
+#endif
@@ -36,9 +36,7 @@
 
 #include "booksim.hpp"
 #include "flit.hpp"
-
-stack<Flit *> Flit::_all;
-stack<Flit *> Flit::_free;
+#include "globals.hpp"
 
 ostream& operator<<( ostream& os, const Flit& f )
 {
@@ -80,36 +78,41 @@ void Flit::Reset()
   intm =-1;
   ph = -1;
   data = 0;
+  la_router = -1;
   /* ==== Power Gate - Begin ==== */
   rtime     = -1 ;
   bypass_vc = -1 ;
   flov_hops = 0 ;
+  smart_cycles = 0 ;
   misroute_hops = 0;
   ring_dest = 0;
   /* ==== Power Gate - End ==== */
 }
 
 Flit * Flit::New() {
+  stack<Flit *> & free_list = gSimContext->free_flits;
   Flit * f;
-  if(_free.empty()) {
+  if(free_list.empty()) {
     f = new Flit;
-    _all.push(f);
+    gSimContext->flits.push(f);
   } else {
-    f = _free.top();
+    f = free_list.top();
     f->Reset();
-    _free.pop();
+    free_list.pop();
   }
   return f;
 }
 
 void Flit::Free() {
   Reset();
-  _free.push(this);
+  gSimContext->free_flits.push(this);
 }
 
 void Flit::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
+  stack<Flit *> & all = gSimContext->flits;
+  while(!all.empty()) {
+    delete all.top();
+    all.pop();
   }
+  gSimContext->free_flits = stack<Flit *>();
 }
@@ -75,6 +75,7 @@ public:
 
   /* ==== Power Gate - Begin ==== */
   int flov_hops;
+  int smart_cycles; // link cycles saved by multi-hop bypass
   int misroute_hops;
   int ring_dest;
   /* ==== Power Gate - End ==== */
@@ -93,6 +94,7 @@ public:
 
   // Lookahead route info
   OutputSet la_route_set;
+  int la_router; // router the lookahead route was computed for
 
   void Reset();
 
@@ -105,8 +107,6 @@ private:
   Flit();
   ~Flit() {}
 
-  static stack<Flit *> _all;
-  static stack<Flit *> _free;
 
 };
 
@@ -72,6 +72,17 @@ void FlitChannel::Send(Flit * f) {
   Channel<Flit>::Send(f);
 }
 
+/* ==== Power Gate - Begin ==== */
+void FlitChannel::Bypass(Flit * f) {
+  assert(f);
+  ++_active[f->cl];
+  if(f->watch) {
+    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+	       << "Bypassing channel for flit " << f->id << "." << endl;
+  }
+}
+/* ==== Power Gate - End ==== */
+
 void FlitChannel::ReadInputs() {
   Flit const * const & f = _input;
   if(f && f->watch) {
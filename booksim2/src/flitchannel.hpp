@@ -78,6 +78,10 @@ public:
 
   // Send flit
   virtual void Send(Flit * flit);
+  /* ==== Power Gate - Begin ==== */
+  // crossed by a multi-hop bypass within the cycle, only counts activity
+  void Bypass(Flit * flit);
+  /* ==== Power Gate - End ==== */
 
   virtual void ReadInputs();
   virtual void WriteOutputs();
@@ -11,11 +11,14 @@
 #include <limits>
 #include <cstdlib>
 #include <ctime>
+#include <algorithm>
+#include <functional>
 
 #include "booksim.hpp"
 #include "booksim_config.hpp"
 #include "flovtrafficmanager.hpp"
 #include "random_utils.hpp"
+#include "misc_utils.hpp"
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
 
@@ -89,14 +92,93 @@ FLOVTrafficManager::FLOVTrafficManager( const Configuration &config,
         tmp_name.str("");
     }
 
-    _router_idle_periods.resize(_nodes, 0);
-    _idle_cycles.resize(_nodes);
-    _overall_idle_cycles.resize(_nodes);
-    for (int n = 0; n < _nodes; ++n) {
-      _idle_cycles[n].resize(320000, 0);
-      _overall_idle_cycles[n].resize(32000, 0);
+    _smart_hpc_max = config.GetInt("smart_hpc_max");
+    _smart_cycle_stats.resize(_classes);
+    _overall_smart_cycle_stats.resize(_classes, 0.0);
+    for (int c = 0; c < _classes; ++c) {
+        ostringstream tmp_name;
+
+        tmp_name << "smart_cycle_stat_" << c;
+        _smart_cycle_stats[c] = new Stats(this, tmp_name.str(), 1.0, 20);
+        tmp_name.str("");
     }
+    _overall_bypass_hops.resize(_smart_hpc_max + 1, 0);
+
+    _router_idle_periods.resize(_nodes, 0);
+    _idle_cycles.resize(_nodes, vector<int>(_idle_hist_buckets, 0));
+    _overall_idle_cycles.resize(_nodes,
+        vector<long long>(_idle_hist_buckets, 0));
+    _inj_pending_flits.resize(_nodes, 0);
+    _last_eject_time.resize(_nodes, -1);
     _wakeup_handshake_latency.resize(_nodes, false);
+    _dest_pending_flits.resize(_nodes, 0);
+
+    _core_period = config.GetInt("flov_core_period");
+    _core_on_cycles = config.GetInt("flov_core_on_cycles");
+    _scheduled_routers.resize(_net[0]->NumRouters(), false);
+    if (_core_period > 0) {
+      if (_core_on_cycles <= 0 || _core_on_cycles >= _core_period) {
+        Error("flov_core_on_cycles must be in (0, flov_core_period)");
+      }
+      // G-FLOV never wakes a router whose core was off
+      if (config.GetStr("router") != "rflov") {
+        Error("flov_core_period needs router = rflov");
+      }
+      vector<bool> const & core_states = _net[0]->GetCoreStates();
+      vector<bool> const & router_states = _net[0]->GetRouterStates();
+      for (int n = 0; n < _nodes; ++n) {
+        int const r = _net[0]->CoreRouter(n);
+        if (!core_states[n] && !router_states[r]) {
+          _scheduled_cores.push_back(n);
+          _scheduled_routers[r] = true;
+        }
+      }
+    }
+
+    _predictive_wakeup = (config.GetInt("flov_predictive_wakeup") > 0);
+    _wakeup_lookahead = config.GetInt("flov_wakeup_lookahead");
+    _last_gen_time.resize(_nodes, -1);
+    _avg_interarrival.resize(_nodes, -1.0);
+    _pred_wakeup_time.resize(_nodes, -1);
+    _pred_power_on_time.resize(_nodes, -1);
+    _pred_arrival_time.resize(_nodes, -1);
+    _core_off_time.resize(_nodes, -1);
+    _core_wake_time.resize(_nodes, -1);
+    _avg_off_period.resize(_nodes, -1.0);
+    _lookahead_wakeup_time.resize(_nodes, -1);
+    _lookahead_power_on_time.resize(_nodes, -1);
+    _frequency = config.GetFloat("frequency");
+    _router_leakage = 0.0;
+    if (config.GetInt("dsent_model")) {
+      // same router leakage terms as the DSENT power model
+      const Router * router = _net[0]->GetRouters()[0];
+      int channel_width = config.GetInt("channel_width");
+      _router_leakage = router->NumInputs() * (config.GetFloat("input_leak") +
+          (config.GetFloat("pipeline_reg0_leak") +
+           config.GetFloat("pipeline_reg1_leak")) * channel_width) +
+        config.GetFloat("switch_leak") + config.GetFloat("xbar_leak") +
+        config.GetFloat("xbar_sel_dff_leak") + router->NumOutputs() *
+        config.GetFloat("pipeline_reg2_part_leak") * channel_width +
+        config.GetFloat("clk_tree_leak");
+    }
+    _wakeup_stall_cycles = 0;
+    _pred_wakeups = 0;
+    _pred_useful = 0;
+    _pred_wasted = 0;
+    _lookahead_wakeups = 0;
+    _hidden_wakeup_cycles = 0;
+    _early_on_cycles = 0;
+
+    _oracle_analysis = (config.GetInt("flov_oracle_analysis") > 0);
+    _oracle_latency_budget = config.GetFloat("flov_oracle_latency_budget");
+    _idle_threshold = config.GetInt("idle_threshold");
+    _bet_threshold = config.GetInt("bet_threshold");
+    _wakeup_latency = config.GetInt("wakeup_threshold");
+    _oracle_idle_run.resize(_net[0]->NumRouters(), 0);
+    _oracle_idle_periods.resize(_net[0]->NumRouters());
+    _oracle_base_off_cycles.resize(_net[0]->NumRouters(), 0);
+    _oracle_base_overhead_cycles.resize(_net[0]->NumRouters(), 0.0);
+    _oracle_base_stall_cycles = 0;
 
     _monitor_counter = 0;
     _monitor_epoch = config.GetInt("flov_monitor_epoch");
@@ -107,9 +189,45 @@ FLOVTrafficManager::FLOVTrafficManager( const Configuration &config,
     _plat_low_watermark = zeroload_latency * low_watermark;
 
     _powergate_type = config.GetStr("powergate_type");
-    _power_state_votes.resize(_nodes, 0);
-    _per_node_plat.resize(_nodes);
-    for (int n = 0; n < _nodes; ++n) {
+    _num_routers = _net[0]->NumRouters();
+    _power_state_votes.resize(_num_routers, 0);
+    string const vote_policy = config.GetStr("flov_vote_policy");
+    if (vote_policy == "row_col") {
+      _vote_policy = row_col_vote;
+    } else if (vote_policy == "region") {
+      _vote_policy = region_vote;
+    } else if (vote_policy == "local") {
+      _vote_policy = local_vote;
+    } else {
+      Error("Unknown FLOV vote policy: " + vote_policy);
+    }
+    _pg_policy = NULL;
+    if (_vote_policy == local_vote) {
+      _pg_policy = PowerGatingPolicy::New(config, this, "pg_policy",
+          _num_routers);
+    } else if (config.GetStr("flov_pg_policy") != "watermark") {
+      cout << "Error: flov_pg_policy " << config.GetStr("flov_pg_policy")
+        << " needs flov_vote_policy = local" << endl;
+      exit(-1);
+    }
+    {
+      const Router * router = _net[0]->GetRouters()[0];
+      int buf_size = config.GetInt("buf_size");
+      if (buf_size < 0) {
+        buf_size = config.GetInt("num_vcs") * config.GetInt("vc_buf_size");
+      }
+      _buffer_capacity = router->NumInputs() * buf_size;
+    }
+    _epoch_idle_cycles.resize(_num_routers, 0);
+    _epoch_off_cycles.resize(_num_routers, 0);
+    _region_size = config.GetInt("flov_vote_region_size");
+    assert(_region_size > 0);
+    _regions_per_dim = (gK + _region_size - 1) / _region_size;
+    _region_plat_sum.resize(powi(_regions_per_dim, gN), 0.0);
+    _region_plat_samples.resize(powi(_regions_per_dim, gN), 0);
+    _region_votes.resize(powi(_regions_per_dim, gN), 0);
+    _per_node_plat.resize(_num_routers);
+    for (int n = 0; n < _num_routers; ++n) {
       ostringstream tmp_name;
 
       tmp_name << "per_node_plat_stat_" << n;
@@ -125,7 +243,9 @@ FLOVTrafficManager::~FLOVTrafficManager( )
     /* ==== Power Gate - Begin ==== */
     for ( int c = 0; c < _classes; ++c ) {
         delete _flov_hop_stats[c];
+        delete _smart_cycle_stats[c];
     }
+    delete _pg_policy;
     /* ==== Power Gate - End ==== */
 }
 
@@ -135,6 +255,9 @@ void FLOVTrafficManager::_RetireFlit( Flit *f, int dest )
 
     assert(_total_in_flight_flits[f->cl].count(f->id) > 0);
     _total_in_flight_flits[f->cl].erase(f->id);
+    /* ==== Power Gate - Begin ==== */
+    --_dest_pending_flits[dest];
+    /* ==== Power Gate - End ==== */
 
     if(f->record) {
         assert(_measured_in_flight_flits[f->cl].count(f->id) > 0);
@@ -218,7 +341,14 @@ void FLOVTrafficManager::_RetireFlit( Flit *f, int dest )
             _hop_stats[f->cl]->AddSample( f->hops );
             /* ==== Power Gate - Begin ==== */
             _flov_hop_stats[f->cl]->AddSample(f->flov_hops);
-            _per_node_plat[dest]->AddSample(f->atime - head->ctime);
+            _smart_cycle_stats[f->cl]->AddSample(f->smart_cycles);
+            int const router = _net[0]->CoreRouter(dest);
+            _per_node_plat[router]->AddSample(f->atime - head->ctime);
+            if (_vote_policy == region_vote) {
+              int region = _Region(router);
+              _region_plat_sum[region] += f->atime - head->ctime;
+              ++_region_plat_samples[region];
+            }
             /* ==== Power Gate - End ==== */
 
             if((_slowest_packet[f->cl] < 0) ||
@@ -258,6 +388,60 @@ void FLOVTrafficManager::_GeneratePacket( int source, int stype,
     assert(core_states[source] == true);
     /* ==== Power Gate - End ==== */
 
+    Flit::FlitType packet_type = Flit::ANY_TYPE;
+    int size = _GetNextPacketSize(cl, source); //input size
+    int pid = _cur_pid++;
+    assert(_cur_pid);
+    int packet_destination = _traffic_pattern[cl]->dest(source);
+    /* ==== Power Gate - Begin ==== */
+    // tornado may carry its digit parameters, e.g. tornado({8,2,1}) on a cmesh
+    if (_traffic[cl].compare(0, 7, "tornado") == 0 &&
+        core_states[packet_destination] == false) {
+        packet_destination = source;
+    } else {
+        while (core_states[packet_destination] != true)
+            packet_destination = _traffic_pattern[cl]->dest(source);
+    }
+    assert(core_states[packet_destination] == true);
+    if (_predictive_wakeup) {
+        _WakeUpDemand(source);
+    }
+    /* ==== Power Gate - End ==== */
+    bool record = false;
+    bool watch = gWatchOut && (_packets_to_watch.count(pid) > 0);
+    if(_use_read_write[cl]){
+        if(stype > 0) {
+            if (stype == 1) {
+                packet_type = Flit::READ_REQUEST;
+                size = _read_request_size[cl];
+            } else if (stype == 2) {
+                packet_type = Flit::WRITE_REQUEST;
+                size = _write_request_size[cl];
+            } else {
+                ostringstream err;
+                err << "Invalid packet type: " << packet_type;
+                Error( err.str( ) );
+            }
+        } else {
+            PacketReplyInfo* rinfo = _repliesPending[source].front();
+            if (rinfo->type == Flit::READ_REQUEST) {//read reply
+                size = _read_reply_size[cl];
+                packet_type = Flit::READ_REPLY;
+            } else if(rinfo->type == Flit::WRITE_REQUEST) {  //write reply
+                size = _write_reply_size[cl];
+                packet_type = Flit::WRITE_REPLY;
+            } else {
+                ostringstream err;
+                err << "Invalid packet type: " << rinfo->type;
+                Error( err.str( ) );
+            }
+            packet_destination = rinfo->source;
+            time = rinfo->time;
+            record = rinfo->record;
+            _repliesPending[source].pop_front();
+            rinfo->Free();
+        }
+    }
 
     if ((packet_destination < 0) || (packet_destination >= _nodes)) {
         ostringstream err;
@@ -272,7 +456,7 @@ void FLOVTrafficManager::_GeneratePacket( int source, int stype,
     }
 
     int subnetwork = ((packet_type == Flit::ANY_TYPE) ?
-                      RandomInt(_subnets-1) :
+                      _packet_random[cl * _nodes + source].Int(_subnets-1) :
                       _subnet[packet_type]);
 
     if ( watch ) {
@@ -347,7 +531,29 @@ void FLOVTrafficManager::_GeneratePacket( int source, int stype,
         }
 
         _partial_packets[source][cl].push_back( f );
+        /* ==== Power Gate - Begin ==== */
+        ++_inj_pending_flits[source];
+        ++_dest_pending_flits[packet_destination];
+        /* ==== Power Gate - End ==== */
     }
+
+    /* ==== Power Gate - Begin ==== */
+    // lookahead: the destination router has to be on to eject the packet
+    if (_predictive_wakeup && packet_destination != source) {
+        int const subnet = _subnet[packet_type];
+        Router * router =
+          _net[subnet]->GetRouters()[_net[subnet]->CoreRouter(packet_destination)];
+        if (router->GetPowerState() == Router::power_off ||
+            router->GetPowerState() == Router::draining) {
+            router->WakeUp();
+            ++_lookahead_wakeups;
+            if (_lookahead_wakeup_time[packet_destination] < 0) {
+                _lookahead_wakeup_time[packet_destination] = _time;
+                _lookahead_power_on_time[packet_destination] = -1;
+            }
+        }
+    }
+    /* ==== Power Gate - End ==== */
 }
 
 void FLOVTrafficManager::_Inject()
@@ -392,6 +598,10 @@ void FLOVTrafficManager::_Inject()
 
 void FLOVTrafficManager::_Step( )
 {
+    PROFILE_SCOPE(_profile_owner, step);
+    ProfileScope profile;
+    _ProfilePhase();
+
     bool flits_in_flight = false;
     for(int c = 0; c < _classes; ++c) {
         flits_in_flight |= !_total_in_flight_flits[c].empty();
@@ -402,13 +612,13 @@ void FLOVTrafficManager::_Step( )
         /* ==== Power Gate Debug - Begin ==== */
         cout << GetSimTime() << endl;
         const vector<Router *> routers = _net[0]->GetRouters();
-        for (int n = 0; n < _nodes; ++n) {
+        for (int n = 0; n < _num_routers; ++n) {
             if (n % gK == 0)
                 cout << endl;
             cout << Router::POWERSTATE[routers[n]->GetPowerState()] << "\t";
         }
         cout << endl;
-        for (int n = 0; n < _nodes; ++n)
+        for (int n = 0; n < _num_routers; ++n)
             routers[n]->Display(cout);
         cout << endl << endl;
         /* ==== Power Gate Debug - End ==== */
@@ -416,126 +626,33 @@ void FLOVTrafficManager::_Step( )
 
     /* ==== Power Gate - Begin ==== */
     // adaptive power-gating
-    if (_powergate_type == "flov" && _monitor_counter / _monitor_epoch > 0) {
-      int turn = _monitor_counter % _monitor_epoch;
-      for (int row = 0; row < gK; ++row) {
-        for (int col = 0; col < gK; ++col) {
-          if (row == turn || col == turn) {
-            int n = row * gK + col;
-            if (_per_node_plat[n]->NumSamples() == 0)
-              continue;
-
-            int vote = 0;
-            double avg_plat = _per_node_plat[n]->Average();
-            if (avg_plat < _plat_low_watermark) {
-              vote = 1;
-            } else if (avg_plat > _plat_high_watermark) {
-              vote = -1;
-            }
-
-            if (row == turn) {
-              for (int c = 0; c < gK; ++c) {
-                if (c == col)
-                  continue;
-
-                int node = row * gK + c;
-                _power_state_votes[node] += vote;
-              }
-            }
-            if (col == turn) {
-              for (int r = 0; r < gK; ++r) {
-                if (r == row)
-                  continue;
-
-                int node = r * gK + col;
-                _power_state_votes[node] += vote;
-              }
-            }
-            _power_state_votes[n] += vote;
-
-            _per_node_plat[n]->Clear();
+    profile.Start(_profile_owner, Profiler::power_state);
+    if (_powergate_type == "flov") {
+      if (_vote_policy == region_vote || _vote_policy == local_vote) {
+        if (_monitor_counter >= _monitor_epoch) {
+          if (_vote_policy == region_vote) {
+            _RegionVote();
+          } else {
+            _LocalVote();
           }
+          _monitor_counter = 0;
         }
+      } else if (_monitor_counter / _monitor_epoch > 0) {
+        _RowColumnVote();
       }
-
-      if (turn == gK) {
-        vector<Router *> routers = _net[0]->GetRouters();
-        for (int n = 0; n < _nodes; ++n) {
-          if (n >= _nodes - gK) {
-            _power_state_votes[n] = 0;
-            continue;
-          }
-
-          if (_power_state_votes[n] > 0) {
-            routers[n]->AggressPowerGatingPolicy();
-            //cout << GetSimTime() << " | node " << n
-            //  << " | (vote " << _power_state_votes[n]
-            //  << ") can switch off to save more power" << endl;
-          } else if (_power_state_votes[n] < 0) {
-            routers[n]->RegressPowerGatingPolicy();
-            //cout << GetSimTime() << " | node " << n
-            //  << " | (vote " << _power_state_votes[n]
-            //  << ") should switch on for performance" << endl;
-          }
-          _power_state_votes[n] = 0;
-        }
-        _monitor_counter = 0;
-      }
-    }
-
-    for (int n = 0; n < _nodes; ++n) {
-        bool is_idle = true;
-        bool is_inj_busy = false;
-        for (int c = 0; c < _classes; ++c) { // injection
-            list<Flit *> const & flist = _partial_packets[n][c];
-            if (!flist.empty()) {
-                is_inj_busy = true;
-                break;
-            }
-        }
-        for (int subnet = 0; subnet < _subnets; ++subnet) {
-            Flit * const f = _net[subnet]->ReadFlit(n); // ejection
-            if (is_inj_busy || f) {
-                is_idle = false;
-                break;
-            }
-        }
-        if (is_idle == true) {  // found an idle cycle
-            for (int subnet = 0; subnet < _subnets; ++subnet) {
-                vector<Router *> routers = _net[subnet]->GetRouters();
-                routers[n]->IdleDetected();
-            }
-            ++_router_idle_periods[n];
-        } else {    // busy for any subnetwork with the node
-            int cur_idle_cycles = _router_idle_periods[n];
-            if (cur_idle_cycles >= _overall_idle_cycles[n].size()) {
-                for (int i = 0; i < _nodes; ++i) {
-                    _idle_cycles[i].resize(cur_idle_cycles + 10, 0);
-                    _overall_idle_cycles[i].resize(cur_idle_cycles + 10, 0);
-                }
-            }
-            if (cur_idle_cycles != 0) { // for the busy cycle
-                ++_idle_cycles[n][0];
-                ++_overall_idle_cycles[n][0];
-            }
-            ++_idle_cycles[n][cur_idle_cycles];
-            ++_overall_idle_cycles[n][cur_idle_cycles];
-            _router_idle_periods[n] = 0;
-            // Power on Router
-            for (int subnet = 0; subnet < _subnets; ++subnet) {
-                vector<Router *> routers = _net[subnet]->GetRouters();
-                routers[n]->WakeUp();
-            }
-        }
     }
     /* ==== Power Gate - End ==== */
 
     vector<map<int, Flit *> > flits(_subnets);
 
+    profile.Start(_profile_owner, Profiler::eject);
     for ( int subnet = 0; subnet < _subnets; ++subnet ) {
         for ( int n = 0; n < _nodes; ++n ) {
             Flit * const f = _net[subnet]->ReadFlit( n );
             if ( f ) {
+                /* ==== Power Gate - Begin ==== */
+                _last_eject_time[n] = _time;
+                /* ==== Power Gate - End ==== */
                 if(f->watch) {
                     *gWatchOut << GetSimTime() << " | "
                                << "node" << n << " | "
@@ -569,9 +686,25 @@ void FLOVTrafficManager::_Step( )
                 c->Free();
             }
         }
+    }
+
+    /* ==== Power Gate - Begin ==== */
+    // routers must see the idle/wakeup signals before reading their inputs
+    profile.Start(_profile_owner, Profiler::power_state);
+    if (_core_period > 0) {
+        _CoreSchedule();
+    }
+    _DetectIdleNodes();
+    if (_predictive_wakeup) {
+        _PredictWakeUp();
+    }
+    /* ==== Power Gate - End ==== */
+
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
         _net[subnet]->ReadInputs( );
     }
 
+    profile.Start(_profile_owner, Profiler::inject);
     if ( !_empty_network ) {
         _Inject();
     }
@@ -631,6 +764,7 @@ void FLOVTrafficManager::_Step( )
                     Router * router = inject->GetSink();
                     assert(router);
                     if (router->GetPowerState() != Router::power_on) {
+                        ++_wakeup_stall_cycles;
                         if (_wakeup_handshake_latency[n]) {
                             router->WakeUp();
                             _wakeup_handshake_latency[n] = false;
@@ -756,6 +890,7 @@ void FLOVTrafficManager::_Step( )
                     Router * router = inject->GetSink();
                     assert(router);
                     if (router->GetPowerState() != Router::power_on) {
+                        ++_wakeup_stall_cycles;
                         if (_wakeup_handshake_latency[n]) {
                             router->WakeUp();
                             _wakeup_handshake_latency[n] = false;
@@ -780,6 +915,7 @@ void FLOVTrafficManager::_Step( )
                             assert(router);
                             int in_channel = inject->GetSinkPort();
                             _rf(router, f, in_channel, &f->la_route_set, false);
+                            f->la_router = router->GetID();
                             if(f->watch) {
                                 *gWatchOut << GetSimTime() << " | "
                                            << "node" << n << " | "
@@ -803,6 +939,9 @@ void FLOVTrafficManager::_Step( )
                 _last_class[n][subnet] = c;
 
                 _partial_packets[n][c].pop_front();
+                /* ==== Power Gate - Begin ==== */
+                --_inj_pending_flits[n];
+                /* ==== Power Gate - End ==== */
 
 #ifdef TRACK_FLOWS
                 ++_outstanding_credits[c][subnet][n];
@@ -850,6 +989,7 @@ void FLOVTrafficManager::_Step( )
         }
     }
 
+    profile.Start(_profile_owner, Profiler::retire);
     for(int subnet = 0; subnet < _subnets; ++subnet) {
         for(int n = 0; n < _nodes; ++n) {
             map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
@@ -884,14 +1024,614 @@ void FLOVTrafficManager::_Step( )
     }
 
     ++_monitor_counter;
+    profile.Stop();
+
     ++_time;
     assert(_time);
+    /* ==== DSENT power model - Begin ==== */
+    _PowerTraceStep();
+    /* ==== DSENT power model - End ==== */
     if(gTrace){
         cout<<"TIME "<<_time<<endl;
     }
 
 }
 
+/* ==== Power Gate - Begin ==== */
+// one row and one column vote per cycle, votes propagate along them
+// nodes whose coordinate in some dimension equals the turn vote for the
+// lines through them along the other dimensions (rows and columns in 2D)
+void FLOVTrafficManager::_RowColumnVote( )
+{
+  int turn = _monitor_counter % _monitor_epoch;
+  for (int n = 0; n < _num_routers; ++n) {
+    bool in_turn = false;
+    for (int dim = 0; dim < gN; ++dim) {
+      if (Router::Coordinate(n, dim) == turn)
+        in_turn = true;
+    }
+    if (!in_turn || _per_node_plat[n]->NumSamples() == 0)
+      continue;
+
+    int vote = 0;
+    double avg_plat = _per_node_plat[n]->Average();
+    if (avg_plat < _plat_low_watermark) {
+      vote = 1;
+    } else if (avg_plat > _plat_high_watermark) {
+      vote = -1;
+    }
+
+    for (int dim = 0; dim < gN; ++dim) {
+      if (Router::Coordinate(n, dim) != turn)
+        continue;
+      for (int line = 0; line < gN; ++line) {
+        if (line == dim)
+          continue;
+        int const offset = powi(gK, line);
+        int const c = Router::Coordinate(n, line);
+        for (int k = 0; k < gK; ++k) {
+          if (k == c)
+            continue;
+
+          int node = n + (k - c) * offset;
+          _power_state_votes[node] += vote;
+        }
+      }
+    }
+    _power_state_votes[n] += vote;
+
+    _per_node_plat[n]->Clear();
+  }
+
+  if (turn == gK) {
+    vector<Router *> routers = _net[0]->GetRouters();
+    for (int n = 0; n < _num_routers; ++n) {
+      if (routers[n]->IsAlwaysOn()) {
+        _power_state_votes[n] = 0;
+        continue;
+      }
+
+      if (_power_state_votes[n] > 0) {
+        routers[n]->AggressPowerGatingPolicy();
+        //cout << GetSimTime() << " | node " << n
+        //  << " | (vote " << _power_state_votes[n]
+        //  << ") can switch off to save more power" << endl;
+      } else if (_power_state_votes[n] < 0) {
+        routers[n]->RegressPowerGatingPolicy();
+        //cout << GetSimTime() << " | node " << n
+        //  << " | (vote " << _power_state_votes[n]
+        //  << ") should switch on for performance" << endl;
+      }
+      _power_state_votes[n] = 0;
+    }
+    _monitor_counter = 0;
+  }
+}
+
+int FLOVTrafficManager::_Region( int node ) const
+{
+  int region = 0;
+  for (int dim = gN - 1; dim >= 0; --dim) {
+    region = region * _regions_per_dim +
+      Router::Coordinate(node, dim) / _region_size;
+  }
+  return region;
+}
+
+// nodes aggregate latency into regions as samples arrive, each epoch every
+// router combines the votes of its own region, the adjacent regions and
+// the whole network, so decisions land once per epoch for any mesh size
+void FLOVTrafficManager::_RegionVote( )
+{
+  int const num_regions = powi(_regions_per_dim, gN);
+
+  double total_plat = 0.0;
+  int total_samples = 0;
+  for (int r = 0; r < num_regions; ++r) {
+    _region_votes[r] = 0;
+    if (_region_plat_samples[r] == 0)
+      continue;
+
+    double avg_plat = _region_plat_sum[r] / _region_plat_samples[r];
+    if (avg_plat < _plat_low_watermark) {
+      _region_votes[r] = 1;
+    } else if (avg_plat > _plat_high_watermark) {
+      _region_votes[r] = -1;
+    }
+    total_plat += _region_plat_sum[r];
+    total_samples += _region_plat_samples[r];
+    _region_plat_sum[r] = 0.0;
+    _region_plat_samples[r] = 0;
+  }
+
+  int global_vote = 0;
+  if (total_samples > 0) {
+    double avg_plat = total_plat / total_samples;
+    if (avg_plat < _plat_low_watermark) {
+      global_vote = 1;
+    } else if (avg_plat > _plat_high_watermark) {
+      global_vote = -1;
+    }
+  }
+
+  for (int n = 0; n < _num_routers; ++n) {
+    _per_node_plat[n]->Clear();
+  }
+
+  vector<Router *> routers = _net[0]->GetRouters();
+  for (int n = 0; n < _num_routers; ++n) {
+    if (routers[n]->IsAlwaysOn())
+      continue;
+
+    int region = _Region(n);
+    int vote = 2 * _region_votes[region] + global_vote;
+    for (int dim = 0; dim < gN; ++dim) {
+      int const offset = powi(_regions_per_dim, dim);
+      int const r = region / offset % _regions_per_dim;
+      if (r > 0)
+        vote += _region_votes[region - offset];
+      if (r < _regions_per_dim - 1)
+        vote += _region_votes[region + offset];
+    }
+
+    if (vote > 0) {
+      routers[n]->AggressPowerGatingPolicy();
+    } else if (vote < 0) {
+      routers[n]->RegressPowerGatingPolicy();
+    }
+  }
+}
+
+// every router reports its own epoch to the policy engine and acts on the
+// answer; latency is pooled with the neighbors since a gated router sees
+// few packets of its own
+void FLOVTrafficManager::_LocalVote( )
+{
+  vector<Router *> routers = _net[0]->GetRouters();
+  for (int n = 0; n < _num_routers; ++n) {
+    Router * const router = routers[n];
+    unsigned long long const off_cycles = router->GetPowerOffCycles();
+
+    PGObservation obs;
+    double plat_sum = _per_node_plat[n]->Sum();
+    int plat_samples = _per_node_plat[n]->NumSamples();
+    obs.neighbors_off = 0;
+    for (int out = 0; out < 2 * gN; ++out) {
+      Router const * const neighbor = router->GetNeighborRouter(out);
+      if (!neighbor)
+        continue;
+      plat_sum += _per_node_plat[neighbor->GetID()]->Sum();
+      plat_samples += _per_node_plat[neighbor->GetID()]->NumSamples();
+      if (neighbor->GetPowerState() != Router::power_on)
+        ++obs.neighbors_off;
+    }
+    obs.plat = plat_samples > 0 ? plat_sum / plat_samples : -1.0;
+    int occupancy = 0;
+    for (int in = 0; in < router->NumInputs(); ++in) {
+      occupancy += router->GetBufferOccupancy(in);
+    }
+    obs.occupancy = (double)occupancy / _buffer_capacity;
+    obs.idle = (double)_epoch_idle_cycles[n] / _monitor_counter;
+    obs.level = router->PowerGatingLevel();
+    obs.on = 1.0 - (double)(off_cycles - _epoch_off_cycles[n]) /
+      _monitor_counter;
+    _epoch_idle_cycles[n] = 0;
+    _epoch_off_cycles[n] = off_cycles;
+
+    if (router->IsAlwaysOn())
+      continue;
+
+    int vote = _pg_policy->Vote(n, obs);
+    if (vote > 0) {
+      router->AggressPowerGatingPolicy();
+    } else if (vote < 0) {
+      router->RegressPowerGatingPolicy();
+    }
+  }
+
+  for (int n = 0; n < _num_routers; ++n) {
+    _per_node_plat[n]->Clear();
+  }
+}
+
+// the measurement window starts: idle periods already running count from
+// here, the policy is judged by its counters from here on
+void FLOVTrafficManager::_OracleReset( )
+{
+  const vector<Router *> & routers = _net[0]->GetRouters();
+  for (int r = 0; r < _num_routers; ++r) {
+    _oracle_idle_run[r] = 0;
+    _oracle_idle_periods[r].clear();
+    _oracle_base_off_cycles[r] = routers[r]->GetPowerOffCycles();
+    _oracle_base_overhead_cycles[r] = routers[r]->GetPowerGateOverheadCycles();
+  }
+  _oracle_base_stall_cycles = _wakeup_stall_cycles;
+}
+
+// Savings are in router-leakage cycles: cycles gated minus bet_threshold
+// per gating event, the same overhead the DSENT power model charges.
+// The oracle knows every idle period of length L in advance. It gates when
+// L > wakeup + BET and wakes up early enough to hide the wakeup, saving
+// L - wakeup - BET. A latency budget buys later wakeups, one cycle of
+// penalty per extra gated cycle, first on gated periods, then on the
+// longest of the periods too short to gate for free. Each policy is
+// compared with the oracle allowed the same penalty.
+static double OracleSaved(double free_saved, long long gated,
+    const vector<int> & short_periods, int wakeup, int bet, double budget)
+{
+  double saved = free_saved;
+  double gain = min(budget, (double)gated * wakeup);
+  saved += gain;
+  budget -= gain;
+  for (size_t i = 0; i < short_periods.size(); ++i) {
+    double const upfront = wakeup + bet - short_periods[i];
+    if (budget <= upfront)
+      break;
+    gain = min(budget - upfront, (double)(short_periods[i] - bet));
+    saved += gain;
+    budget -= upfront + gain;
+  }
+  return saved;
+}
+
+// the timeout policy replays idle_threshold on the recorded periods and
+// wakes up on demand
+void FLOVTrafficManager::_DisplayOracleAnalysis( ostream & os ) const
+{
+  const vector<Router *> & routers = _net[0]->GetRouters();
+  long long const min_gated = _wakeup_latency + _bet_threshold;
+
+  long long periods = 0;
+  double idle_cycles = 0.0;
+  double short_idle_cycles = 0.0;
+  double oracle_saved = 0.0;
+  long long oracle_gated = 0;
+  double timeout_saved = 0.0;
+  double timeout_penalty = 0.0;
+  double measured_saved = 0.0;
+  vector<int> short_periods;  // BET < L <= wakeup + BET
+  int gateable = 0;
+  for (int r = 0; r < _num_routers; ++r) {
+    if (routers[r]->IsAlwaysOn())
+      continue;
+    ++gateable;
+    measured_saved += (double)(routers[r]->GetPowerOffCycles() -
+        _oracle_base_off_cycles[r]) - (routers[r]->GetPowerGateOverheadCycles() -
+        _oracle_base_overhead_cycles[r]);
+
+    map<int, long long> lengths = _oracle_idle_periods[r];
+    if (_oracle_idle_run[r] > 0)
+      ++lengths[_oracle_idle_run[r]];
+    for (map<int, long long>::const_iterator iter = lengths.begin();
+         iter != lengths.end(); ++iter) {
+      long long const len = iter->first;
+      long long const count = iter->second;
+      periods += count;
+      idle_cycles += (double)len * count;
+
+      if (len > min_gated) {
+        oracle_saved += (double)(len - min_gated) * count;
+        oracle_gated += count;
+      } else {
+        short_idle_cycles += (double)len * count;
+        if (len > _bet_threshold)
+          short_periods.insert(short_periods.end(), count, len);
+      }
+
+      if (len > _idle_threshold) {
+        long long const off = max(len - _idle_threshold,
+            (long long)_bet_threshold);
+        timeout_saved += (double)(off - _bet_threshold) * count;
+        timeout_penalty += (double)(_wakeup_latency +
+            (off + _idle_threshold - len)) * count;
+      }
+    }
+  }
+  sort(short_periods.begin(), short_periods.end(), greater<int>());
+
+  long long packets = 0;
+  for (int c = 0; c < _classes; ++c) {
+    packets += _plat_stats[c]->NumSamples();
+  }
+  double const measured_penalty =
+    (double)(_wakeup_stall_cycles - _oracle_base_stall_cycles);
+
+  const char * const names[3] = {"budget", "timeout", "measured"};
+  double const saved[3] = {-1.0, timeout_saved, measured_saved};
+  double const penalty[3] = {_oracle_latency_budget * packets,
+    timeout_penalty, measured_penalty};
+
+  double const window = (double)(_time - _reset_time) * gateable;
+  os << "====== Oracle Power Gating ======" << endl;
+  os << "Gateable router cycles = " << window << ", idle "
+     << (window > 0.0 ? 100.0 * idle_cycles / window : 0.0) << "%" << endl;
+  os << "Idle periods = " << periods << " (average "
+     << (periods > 0 ? idle_cycles / periods : 0.0) << " cycles), "
+     << (idle_cycles > 0.0 ? 100.0 * short_idle_cycles / idle_cycles : 0.0)
+     << "% of idle cycles in periods <= wakeup + BET" << endl;
+  os << "Saved router-leakage cycles (penalty cycles; oracle at that penalty, gap):"
+     << endl;
+  for (int p = 0; p < 3; ++p) {
+    double const oracle = OracleSaved(oracle_saved, oracle_gated,
+        short_periods, _wakeup_latency, _bet_threshold, penalty[p]);
+    os << "	" << names[p];
+    if (p == 0) {
+      os << " " << _oracle_latency_budget << "/packet = " << oracle
+         << " (" << penalty[p] << ")";
+      if (_router_leakage > 0.0) {
+        os << ", " << oracle * _router_leakage / _frequency << " J";
+      }
+      os << endl;
+      continue;
+    }
+    if (p == 1) {
+      os << " idle_threshold " << _idle_threshold;
+    } else {
+      os << " " << _powergate_type;
+    }
+    os << " = " << saved[p] << " (" << penalty[p] << "; " << oracle << ", "
+       << (oracle > 0.0 ? 100.0 * (1.0 - saved[p] / oracle) : 0.0) << "%)"
+       << endl;
+  }
+}
+
+int FLOVTrafficManager::_IdleHistBucket( int idle_cycles )
+{
+  int bucket = 0;
+  while (idle_cycles > 0 && bucket < _idle_hist_buckets - 1) {
+    idle_cycles >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+// a node is busy while it has flits waiting for injection or ejected a
+// flit this cycle, both known from events the injection/ejection path sees;
+// a router is idle only when all of its nodes are
+void FLOVTrafficManager::_DetectIdleNodes( )
+{
+  vector<bool> router_busy(_num_routers, false);
+  for (int n = 0; n < _nodes; ++n) {
+    if (_inj_pending_flits[n] == 0 && _last_eject_time[n] != _time) {
+      // found an idle cycle
+      ++_router_idle_periods[n];
+    } else {    // busy for any subnetwork with the node
+      int cur_idle_cycles = _router_idle_periods[n];
+      if (cur_idle_cycles != 0) { // for the busy cycle
+        ++_idle_cycles[n][0];
+        ++_overall_idle_cycles[n][0];
+      }
+      int bucket = _IdleHistBucket(cur_idle_cycles);
+      ++_idle_cycles[n][bucket];
+      ++_overall_idle_cycles[n][bucket];
+      _router_idle_periods[n] = 0;
+      router_busy[_net[0]->CoreRouter(n)] = true;
+    }
+  }
+
+  for (int r = 0; r < _num_routers; ++r) {
+    if (!router_busy[r])
+      ++_epoch_idle_cycles[r];
+  }
+
+  if (_oracle_analysis) {
+    for (int r = 0; r < _num_routers; ++r) {
+      if (!router_busy[r]) {
+        ++_oracle_idle_run[r];
+      } else if (_oracle_idle_run[r] > 0) {
+        ++_oracle_idle_periods[r][_oracle_idle_run[r]];
+        _oracle_idle_run[r] = 0;
+      }
+    }
+  }
+
+  for (int subnet = 0; subnet < _subnets; ++subnet) {
+    vector<Router *> routers = _net[subnet]->GetRouters();
+    for (int r = 0; r < _num_routers; ++r) {
+      if (router_busy[r]) {
+        routers[r]->WakeUp();  // Power on Router
+      } else {
+        routers[r]->IdleDetected();
+      }
+    }
+  }
+}
+
+// a modeled packet counts toward the votes like a retired one
+void FLOVTrafficManager::_FastForwardPacket( int source, int dest, int cl, int latency )
+{
+  int const router = _net[0]->CoreRouter(dest);
+  _per_node_plat[router]->AddSample(latency);
+  if (_vote_policy == region_vote) {
+    int region = _Region(router);
+    _region_plat_sum[region] += latency;
+    ++_region_plat_samples[region];
+  }
+  if (_predictive_wakeup) {
+    _WakeUpDemand(source);
+  }
+}
+
+// a packet was generated at node: update its inter-arrival estimate and
+// settle an outstanding prediction
+void FLOVTrafficManager::_WakeUpDemand( int node )
+{
+  if (_last_gen_time[node] >= 0) {
+    double interval = _time - _last_gen_time[node];
+    if (_avg_interarrival[node] < 0.0) {
+      _avg_interarrival[node] = interval;
+    } else {
+      _avg_interarrival[node] = 0.75 * _avg_interarrival[node] + 0.25 * interval;
+    }
+  }
+  _last_gen_time[node] = _time;
+  _SettlePrediction(node);
+}
+
+// the node needs its router now, an outstanding prediction was useful
+void FLOVTrafficManager::_SettlePrediction( int node )
+{
+  if (_pred_wakeup_time[node] < 0)
+    return;
+
+  ++_pred_useful;
+  if (_pred_power_on_time[node] >= 0) {
+    // the whole wakeup finished before the packet showed up
+    _hidden_wakeup_cycles += _pred_power_on_time[node] - _pred_wakeup_time[node];
+    _early_on_cycles += _time - _pred_power_on_time[node];
+  } else {
+    _hidden_wakeup_cycles += _time - _pred_wakeup_time[node];
+  }
+  _pred_wakeup_time[node] = -1;
+  _pred_power_on_time[node] = -1;
+}
+
+// sleeping cores wake up for _core_on_cycles every _core_period cycles,
+// staggered over the period; a waking core is available once its router
+// is on, the wait counts as exposed wakeup stall, and it does not catch
+// up on the packets of its off time
+void FLOVTrafficManager::_CoreSchedule( )
+{
+  vector<bool> & core_states = _net[0]->GetCoreStates();
+  vector<bool> router_on(_num_routers, false);
+  int const scheduled = _scheduled_cores.size();
+  for (int i = 0; i < scheduled; ++i) {
+    int const n = _scheduled_cores[i];
+    int const r = _net[0]->CoreRouter(n);
+    int const phase = (long long)i * _core_period / scheduled;
+    bool const on =
+      ((_time - phase) % _core_period + _core_period) % _core_period < _core_on_cycles;
+    if (!on) {
+      if (core_states[n]) {
+        core_states[n] = false;
+        _core_off_time[n] = _time;
+        _last_gen_time[n] = -1;  // the off time is no inter-arrival time
+      }
+      _core_wake_time[n] = -1;
+      continue;
+    }
+    router_on[r] = true;
+    if (core_states[n])
+      continue;
+    if (_core_wake_time[n] < 0) {
+      _core_wake_time[n] = _time;
+      if (_predictive_wakeup) {
+        _SettlePrediction(n);
+      }
+      if (_core_off_time[n] >= 0) {
+        double period = _time - _core_off_time[n];
+        if (_avg_off_period[n] < 0.0) {
+          _avg_off_period[n] = period;
+        } else {
+          _avg_off_period[n] = 0.75 * _avg_off_period[n] + 0.25 * period;
+        }
+      }
+    }
+    bool powered = true;
+    for (int subnet = 0; subnet < _subnets; ++subnet) {
+      powered &= (_net[subnet]->GetRouters()[r]->GetPowerState() == Router::power_on);
+    }
+    if (powered) {
+      core_states[n] = true;
+      _wakeup_stall_cycles += _time - _core_wake_time[n];
+      _core_wake_time[n] = -1;
+      for (int c = 0; c < _classes; ++c) {
+        _qtime[n][c] = max(_qtime[n][c], _time);
+      }
+    }
+  }
+
+  vector<bool> & router_states = _net[0]->GetRouterStates();
+  for (int n = 0; n < _nodes; ++n) {
+    if (core_states[n] || _inj_pending_flits[n] > 0 || _dest_pending_flits[n] > 0)
+      router_on[_net[0]->CoreRouter(n)] = true;
+  }
+  for (int r = 0; r < _num_routers; ++r) {
+    if (!_scheduled_routers[r] || router_on[r] == router_states[r])
+      continue;
+    router_states[r] = router_on[r];
+    for (int subnet = 0; subnet < _subnets; ++subnet) {
+      _net[subnet]->GetRouters()[r]->SetRouterState(router_on[r]);
+    }
+  }
+}
+
+// start waking up gated routers whose next packet is expected within the
+// wakeup lookahead, so the wakeup latency overlaps the idle time; for a
+// sleeping core the next packet comes with its expected turn-on
+void FLOVTrafficManager::_PredictWakeUp( )
+{
+  vector<bool> const & core_states = _net[0]->GetCoreStates();
+  for (int n = 0; n < _nodes; ++n) {
+    int const r = _net[0]->CoreRouter(n);
+    Router * router = _net[0]->GetRouters()[r];
+    Router::ePowerState state = router->GetPowerState();
+
+    // a destination router woken by lookahead leaks until its first flit
+    if (_lookahead_wakeup_time[n] >= 0) {
+      if (state == Router::power_on && _lookahead_power_on_time[n] < 0)
+        _lookahead_power_on_time[n] = _time;
+      if (_last_eject_time[n] == _time) {
+        if (_lookahead_power_on_time[n] >= 0)
+          _early_on_cycles += _time - _lookahead_power_on_time[n];
+        _lookahead_wakeup_time[n] = -1;
+        _lookahead_power_on_time[n] = -1;
+      }
+    }
+
+    if (_pred_wakeup_time[n] >= 0) {
+      if (state == Router::power_on) {
+        if (_pred_power_on_time[n] < 0)
+          _pred_power_on_time[n] = _time;
+        if (_time <= _pred_arrival_time[n] + _wakeup_lookahead) {
+          // hold the router of a sleeping core on until it turns on
+          if (!core_states[n]) {
+            for (int subnet = 0; subnet < _subnets; ++subnet) {
+              _net[subnet]->GetRouters()[r]->WakeUp();
+            }
+          }
+          continue;
+        }
+      }
+      if (_pred_power_on_time[n] >= 0) {
+        // gated again or no packet in time, the prediction was wrong
+        _early_on_cycles += _time - _pred_power_on_time[n];
+        ++_pred_wasted;
+        _pred_wakeup_time[n] = -1;
+        _pred_power_on_time[n] = -1;
+        continue;
+      }
+    } else {
+      if (state != Router::power_off)
+        continue;
+      double next_arrival;
+      if (core_states[n]) {
+        if (_last_gen_time[n] < 0 || _avg_interarrival[n] < 0.0)
+          continue;
+        next_arrival = _last_gen_time[n] + _avg_interarrival[n];
+      } else {
+        if (_core_wake_time[n] >= 0 || _avg_off_period[n] < 0.0)
+          continue;
+        next_arrival = _core_off_time[n] + _avg_off_period[n];
+      }
+      if (next_arrival > _time + _wakeup_lookahead)
+        continue;
+      _pred_wakeup_time[n] = _time;
+      _pred_arrival_time[n] = max((int)next_arrival, _time);
+      ++_pred_wakeups;
+    }
+
+    // keep signalling until the router leaves the power-off state, a
+    // wakeup can be held back by draining/waking neighbors
+    if (state == Router::power_off || state == Router::draining) {
+      for (int subnet = 0; subnet < _subnets; ++subnet) {
+        _net[subnet]->GetRouters()[r]->WakeUp();
+      }
+    }
+  }
+}
+/* ==== Power Gate - End ==== */
+
 void FLOVTrafficManager::_ClearStats( )
 {
     _slowest_flit.assign(_classes, -1);
@@ -929,9 +1669,26 @@ void FLOVTrafficManager::_ClearStats( )
         _hop_stats[c]->Clear();
         /* ==== Power Gate - Begin ==== */
         _flov_hop_stats[c]->Clear();
+        _smart_cycle_stats[c]->Clear();
         /* ==== Power Gate - End ==== */
 
     }
+    _ClearPacketChains();
+
+    /* ==== Power Gate - Begin ==== */
+    for (int n = 0; n < _nodes; ++n) {
+        _idle_cycles[n].assign(_idle_hist_buckets, 0);
+    }
+    for (int subnet = 0; subnet < _subnets; ++subnet) {
+        const vector<Router *> & routers = _net[subnet]->GetRouters();
+        for (size_t r = 0; r < routers.size(); ++r) {
+            routers[r]->ClearBypassHops();
+        }
+    }
+    if (_oracle_analysis) {
+        _OracleReset();
+    }
+    /* ==== Power Gate - End ==== */
 
     _reset_time = _time;
 }
@@ -948,8 +1705,21 @@ void FLOVTrafficManager::_UpdateOverallStats() {
 
        /* ==== Power Gate - Begin ==== */
         _overall_flov_hop_stats[c] += _flov_hop_stats[c]->Average();
+        _overall_smart_cycle_stats[c] += _smart_cycle_stats[c]->Average();
         /* ==== Power Gate - End ==== */
     }
+
+    /* ==== Power Gate - Begin ==== */
+    for (int subnet = 0; subnet < _subnets; ++subnet) {
+        const vector<Router *> & routers = _net[subnet]->GetRouters();
+        for (size_t r = 0; r < routers.size(); ++r) {
+            const vector<long long> & hops = routers[r]->GetBypassHops();
+            for (int h = 1; h <= _smart_hpc_max; ++h) {
+                _overall_bypass_hops[h] += hops[h];
+            }
+        }
+    }
+    /* ==== Power Gate - End ==== */
 }
 
 void FLOVTrafficManager::WriteStats(ostream & os) const {
@@ -972,7 +1742,8 @@ void FLOVTrafficManager::WriteStats(ostream & os) const {
            << "frag_hist(" << c+1 << ",:) = " << *_frag_stats[c] << ";" << endl
            << "hops(" << c+1 << ",:) = " << *_hop_stats[c] << ";" << endl
            /* ==== Power Gate - Begin ==== */
-           << "flov hops(" << c+1 << ",:)" << *_flov_hop_stats[c] << ";" << endl;
+           << "flov hops(" << c+1 << ",:)" << *_flov_hop_stats[c] << ";" << endl
+           << "smart cycles(" << c+1 << ",:)" << *_smart_cycle_stats[c] << ";" << endl;
            /* ==== Power Gate - End ==== */
         if(_pair_stats){
             os<< "pair_sent(" << c+1 << ",:) = [ ";
@@ -1065,6 +1836,17 @@ void FLOVTrafficManager::WriteStats(ostream & os) const {
         os << "];" << endl;
 #endif
     }
+
+    /* ==== Power Gate - Begin ==== */
+    // bucket b > 0 holds idle periods of [2^(b-1), 2^b) cycles
+    for (int n = 0; n < _nodes; ++n) {
+        os << "idle_period_hist(" << n+1 << ",:) = [ ";
+        for (int b = 0; b < _idle_hist_buckets; ++b) {
+            os << _overall_idle_cycles[n][b] << " ";
+        }
+        os << "];" << endl;
+    }
+    /* ==== Power Gate - End ==== */
 }
 
 void FLOVTrafficManager::DisplayOverallStats( ostream & os ) const {
@@ -1146,6 +1928,13 @@ void FLOVTrafficManager::DisplayOverallStats( ostream & os ) const {
         os << "FLOV hops average = " << _overall_flov_hop_stats[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl;
 
+        if (_smart_hpc_max > 1) {
+            double saved = _overall_smart_cycle_stats[c] / (double)_total_sims;
+            // skipped link traversals only, not the queueing avoided
+            os << "Multi-hop bypass link cycles saved average = " << saved
+               << " (" << _total_sims << " samples)" << endl;
+        }
+
 #ifdef TRACK_STALLS
         os << "Buffer busy stall rate = " << (double)_overall_buffer_busy_stalls[c] / (double)_total_sims
            << " (" << _total_sims << " samples)" << endl
@@ -1161,5 +1950,92 @@ void FLOVTrafficManager::DisplayOverallStats( ostream & os ) const {
 
     }
 
+    _DisplayPacketChains(os);
+
+    /* ==== Power Gate - Begin ==== */
+    if (_smart_hpc_max > 1) {
+        long long bypasses = 0;
+        for (int h = 1; h <= _smart_hpc_max; ++h) {
+            bypasses += _overall_bypass_hops[h];
+        }
+        os << "====== Multi-hop Bypass (HPC_max = " << _smart_hpc_max
+           << ") ======" << endl;
+        os << "Latch traversals = " << bypasses << endl;
+        for (int h = 1; h <= _smart_hpc_max; ++h) {
+            os << "\t" << h << " hop" << (h > 1 ? "s" : " ") << " = "
+               << _overall_bypass_hops[h];
+            if (bypasses > 0) {
+                os << " (" << 100.0 * _overall_bypass_hops[h] / bypasses << "%)";
+            }
+            os << endl;
+        }
+    }
+    if (_predictive_wakeup) {
+        os << "====== Predictive Wakeup ======" << endl;
+        os << "Predicted wakeups = " << _pred_wakeups
+           << " (useful " << _pred_useful << ", wasted " << _pred_wasted
+           << ")" << endl;
+        os << "Lookahead wakeups = " << _lookahead_wakeups << endl;
+        os << "Hidden wakeup latency = " << _hidden_wakeup_cycles << " cycles";
+        if (_pred_useful > 0) {
+            os << " (" << (double)_hidden_wakeup_cycles / _pred_useful
+               << " per useful prediction)";
+        }
+        os << endl;
+        os << "Exposed wakeup stall cycles = " << _wakeup_stall_cycles << endl;
+        os << "Early power-on cycles = " << _early_on_cycles;
+        if (_router_leakage > 0.0) {
+            os << " (leakage energy " << _early_on_cycles * _router_leakage / _frequency
+               << " J)";
+        }
+        os << endl;
+    }
+    if (_powergate_type == "flov") {
+        const vector<Router *> & routers = _net[0]->GetRouters();
+        unsigned long long off_cycles = 0;
+        for (int n = 0; n < _num_routers; ++n) {
+            off_cycles += routers[n]->GetPowerOffCycles();
+        }
+        os << "Router power-off ratio = "
+           << (double)off_cycles / ((double)_num_routers * _time) << endl;
+    }
+    if (_pg_policy) {
+        _pg_policy->DisplayStats(os);
+    }
+    if (_oracle_analysis) {
+        _DisplayOracleAnalysis(os);
+    }
+    /* ==== Power Gate - End ==== */
+
+    _DisplaySampling(os);
+    _DisplayReplications(os);
+}
+
+void FLOVTrafficManager::_ReplicationMetrics( vector<pair<string, double> > & metrics ) const
+{
+    TrafficManager::_ReplicationMetrics(metrics);
+
+    /* ==== Power Gate - Begin ==== */
+    for (int c = 0; c < _classes; ++c) {
+        if (_measure_stats[c] == 0) {
+            continue;
+        }
+        ostringstream name;
+        if (_classes > 1) {
+            name << "Class " << c << " ";
+        }
+        name << "FLOV hops average";
+        metrics.push_back(make_pair(name.str(), _overall_flov_hop_stats[c] / (double)_total_sims));
+    }
+    if (_powergate_type == "flov") {
+        const vector<Router *> & routers = _net[0]->GetRouters();
+        unsigned long long off_cycles = 0;
+        for (int n = 0; n < _num_routers; ++n) {
+            off_cycles += routers[n]->GetPowerOffCycles();
+        }
+        metrics.push_back(make_pair(string("Router power-off ratio"),
+                                    (double)off_cycles / ((double)_num_routers * _time)));
+    }
+    /* ==== Power Gate - End ==== */
 }
 
@@ -13,6 +13,7 @@
 #include "config_utils.hpp"
 #include "stats.hpp"
 #include "trafficmanager.hpp"
+#include "power_gating_policy.hpp"
 
 class FLOVTrafficManager : public TrafficManager {
 
@@ -27,20 +28,88 @@ private:
   /* ==== Power Gate - Begin ==== */
   vector<Stats *> _flov_hop_stats;
   vector<double> _overall_flov_hop_stats;
+  // multi-hop bypass, link cycles saved per packet and links per bypass
+  int _smart_hpc_max;
+  vector<Stats *> _smart_cycle_stats;
+  vector<double> _overall_smart_cycle_stats;
+  vector<long long> _overall_bypass_hops;
   double _plat_high_watermark;
   double _plat_low_watermark;
   int _monitor_counter;
   int _monitor_epoch;
-  vector<Stats *> _per_node_plat;
+  int _num_routers;  // concentrated networks attach several nodes each
+  vector<Stats *> _per_node_plat;  // voting state is kept per router
   vector<int> _power_state_votes;
   string _powergate_type;
+  // hierarchical region-based voting
+  enum eVotePolicy { row_col_vote, region_vote, local_vote };
+  eVotePolicy _vote_policy;
+  int _region_size;
+  int _regions_per_dim;
+  vector<double> _region_plat_sum;
+  vector<int> _region_plat_samples;
+  vector<int> _region_votes;
+  // local voting, each router asks the policy engine about itself
+  PowerGatingPolicy * _pg_policy;
+  int _buffer_capacity;
+  vector<int> _epoch_idle_cycles;
+  vector<unsigned long long> _epoch_off_cycles;
   /* ==== Power Gate - End ==== */
 
   /* ==== Power Gate - Begin ==== */
+  // log2-bucketed idle period histograms, bucket 0 counts busy cycles
+  // that end an idle period, bucket b counts periods in [2^(b-1), 2^b)
+  static const int _idle_hist_buckets = 32;
   vector<vector<int> > _idle_cycles;
   vector<int> _router_idle_periods;
-  vector<vector<int> > _overall_idle_cycles;
+  vector<vector<long long> > _overall_idle_cycles;
+  // idleness is derived from injection and ejection events
+  vector<int> _inj_pending_flits;
+  vector<int> _last_eject_time;
   vector<bool> _wakeup_handshake_latency;
+  // runtime core schedule, a router is gated once its cores are off and
+  // no flit from or to them is left
+  int _core_period;
+  int _core_on_cycles;
+  vector<int> _scheduled_cores;
+  vector<bool> _scheduled_routers;
+  vector<int> _dest_pending_flits;
+  // predictive wakeup
+  bool _predictive_wakeup;
+  int _wakeup_lookahead;
+  vector<int> _last_gen_time;
+  vector<double> _avg_interarrival;
+  vector<int> _pred_wakeup_time;  // -1: no outstanding prediction
+  vector<int> _pred_power_on_time;
+  vector<int> _pred_arrival_time;
+  // a sleeping core's next turn-on, from its past off periods
+  vector<int> _core_off_time;
+  vector<int> _core_wake_time;  // turned on, waiting for its router
+  vector<double> _avg_off_period;
+  // lookahead wakeups of destination routers, on-cycles until the first flit
+  vector<int> _lookahead_wakeup_time;  // -1: none outstanding
+  vector<int> _lookahead_power_on_time;
+  double _router_leakage;  // W per powered-on router, 0 without DSENT
+  double _frequency;
+  long long _wakeup_stall_cycles;
+  long long _pred_wakeups;
+  long long _pred_useful;
+  long long _pred_wasted;
+  long long _lookahead_wakeups;
+  long long _hidden_wakeup_cycles;
+  long long _early_on_cycles;
+  // oracle idle-period analysis, exact router idle period lengths over
+  // the measurement window and the policy's counters at its start
+  bool _oracle_analysis;
+  double _oracle_latency_budget;
+  int _idle_threshold;
+  int _bet_threshold;
+  int _wakeup_latency;
+  vector<int> _oracle_idle_run;
+  vector<map<int, long long> > _oracle_idle_periods;
+  vector<unsigned long long> _oracle_base_off_cycles;
+  vector<double> _oracle_base_overhead_cycles;
+  long long _oracle_base_stall_cycles;
   /* ==== Power Gate - End ==== */
   // ============ Internal methods ============
 protected:
@@ -56,6 +125,27 @@ protected:
 
   virtual void _UpdateOverallStats();
 
+  virtual void _ReplicationMetrics( vector<pair<string, double> > & metrics ) const;
+
+  // the power-state machines and votes keep running while fast-forwarding
+  virtual void _FastForwardStep( ) { _Step( ); }
+  virtual void _FastForwardPacket( int source, int dest, int cl, int latency );
+
+  /* ==== Power Gate - Begin ==== */
+  void _RowColumnVote( );
+  void _RegionVote( );
+  void _LocalVote( );
+  int _Region( int node ) const;
+  void _DetectIdleNodes( );
+  void _CoreSchedule( );
+  void _PredictWakeUp( );
+  void _WakeUpDemand( int node );
+  void _SettlePrediction( int node );
+  static int _IdleHistBucket( int idle_cycles );
+  void _OracleReset( );
+  void _DisplayOracleAnalysis( ostream & os ) const;
+  /* ==== Power Gate - End ==== */
+
 public:
 
   FLOVTrafficManager( const Configuration &config, const vector<Network *> & net );
@@ -0,0 +1,53 @@
+/*
+ * globals.cpp
+ * - Per-simulation context that holds the simulator state formerly kept
+ *   in process-wide globals, one context current per thread
+ */
+
+#include "booksim.hpp"
+#include "globals.hpp"
+#include "flit.hpp"
+#include "credit.hpp"
+#include "handshake.hpp"
+#include "packet_reply_info.hpp"
+#include "random_utils.hpp"
+
+thread_local SimContext * gSimContext = NULL;
+
+// read-only markers of an unseeded generator, see rng.c and rng-double.c
+extern long ran_arr_dummy;
+extern double ranf_arr_dummy;
+
+SimContext::SimContext()
+  : traffic_manager(NULL), print_activity(false), profile(false),
+    k(0), n(0), c(0), nodes(0), trace(false), watch_out(NULL),
+    routing_deadlock_timeout_threshold(0), miss_route_threshold(0),
+    num_vcs(0), read_req_begin_vc(0), read_req_end_vc(0),
+    write_req_begin_vc(0), write_req_end_vc(0),
+    read_reply_begin_vc(0), read_reply_end_vc(0),
+    write_reply_begin_vc(0), write_reply_end_vc(0),
+    dragonfly_p(0), dragonfly_a(0), dragonfly_g(0),
+    anynet_routing_table(NULL), cmesh_cx(0), cmesh_cy(0),
+    cmesh_node_shift_x(0), cmesh_node_shift_y(0), cmesh_port_shift_y(0),
+    flatfly_xcount(0), flatfly_ycount(0), flatfly_xrouter(0), flatfly_yrouter(0),
+    ran_arr_ptr(&ran_arr_dummy), ranf_arr_ptr(&ranf_arr_dummy),
+    random_streams(false), random_seed(0),
+    profile_current(NULL), profile_phase(0),
+    profile_start_ticks(0), profile_start_time(0.0)
+{
+}
+
+SimContext::~SimContext()
+{
+  // the free lists of this context, whichever one is current
+  SimContext * const current = gSimContext;
+  gSimContext = this;
+  PacketReplyInfo::FreeAll();
+  Flit::FreeAll();
+  Credit::FreeAll();
+  Handshake::FreeAll();
+  gSimContext = current;
+  for (size_t i = 0; i < source_random.size(); ++i) {
+    delete source_random[i];
+  }
+}
@@ -29,6 +29,8 @@
 #define _GLOBALS_HPP_
 #include <string>
 #include <vector>
+#include <map>
+#include <stack>
 #include <iostream>
 
 /*all declared in main.cpp*/
@@ -38,16 +40,107 @@ int GetSimTime();
 class Stats;
 Stats * GetStats(const std::string & name);
 
-extern bool gPrintActivity;
+class TrafficManager;
+class Router;
+class Flit;
+class Credit;
+class Handshake;
+class PacketReplyInfo;
+class OutputSet;
+class ProfileScope;
+class RandomStream;
 
-extern int gK;
-extern int gN;
-extern int gC;
+typedef void (*tRoutingFunction)( const Router *, const Flit *, int in_channel, OutputSet *, bool );
 
-extern int gNodes;
+/*
+ * Everything a simulation keeps outside its networks and traffic manager.
+ * Each thread runs the simulation of the context in gSimContext, so
+ * several simulations can run in one process; the g* names below and in
+ * routefunc.hpp resolve through it.
+ */
+class SimContext {
+
+public:
+
+  SimContext();
+  ~SimContext();
+
+  TrafficManager * traffic_manager;
+
+  bool print_activity;
+  bool profile;
+  int k;
+  int n;
+  int c;
+  int nodes;
+  bool trace;
+  std::ostream * watch_out;
+
+  // routing functions, see routefunc.cpp
+  std::map<std::string, tRoutingFunction> routing_function_map;
+  int routing_deadlock_timeout_threshold;
+  int miss_route_threshold;
+  int num_vcs;
+  int read_req_begin_vc, read_req_end_vc;
+  int write_req_begin_vc, write_req_end_vc;
+  int read_reply_begin_vc, read_reply_end_vc;
+  int write_reply_begin_vc, write_reply_end_vc;
+
+  // topology parameters the routing functions need
+  int dragonfly_p, dragonfly_a, dragonfly_g;
+  std::map<int, int> * anynet_routing_table;
+  int cmesh_cx, cmesh_cy;
+  int cmesh_node_shift_x, cmesh_node_shift_y, cmesh_port_shift_y;
+  int flatfly_xcount, flatfly_ycount, flatfly_xrouter, flatfly_yrouter;
+
+  // free lists of the flit, credit, handshake and reply objects
+  std::stack<Flit *> flits, free_flits;
+  std::stack<Credit *> credits, free_credits;
+  std::stack<Handshake *> handshakes, free_handshakes;
+  std::stack<PacketReplyInfo *> reply_infos, free_reply_infos;
+
+  // Knuth's generators, see rng.c and rng-double.c
+  long ran_x[100];
+  long ran_arr_buf[1009];
+  long * ran_arr_ptr;
+  double ran_u[100];
+  double ranf_arr_buf[1009];
+  double * ranf_arr_ptr;
+
+  // counter-based streams instead, see random_utils.hpp
+  bool random_streams;
+  long random_seed;
+  std::vector<RandomStream *> source_random;
+
+  // see profiler.hpp
+  std::vector<std::string> profile_owners;
+  std::vector<unsigned long long> profile_ticks;
+  std::vector<unsigned long long> profile_calls;
+  ProfileScope * profile_current;
+  int profile_phase;
+  unsigned long long profile_start_ticks;
+  double profile_start_time;
+
+private:
+
+  SimContext( const SimContext & );
+  SimContext & operator=( const SimContext & );
+
+};
+
+extern thread_local SimContext * gSimContext;
+
+#define gPrintActivity (gSimContext->print_activity)
+#define gProfile (gSimContext->profile)
+
+#define gK (gSimContext->k)
+#define gN (gSimContext->n)
+#define gC (gSimContext->c)
+
+#define gNodes (gSimContext->nodes)
 
-extern bool gTrace;
+#define gTrace (gSimContext->trace)
 
-extern std::ostream * gWatchOut;
+#define gWatchOut (gSimContext->watch_out)
 
 #endif
@@ -7,11 +7,9 @@
 
 #include "booksim.hpp"
 #include "handshake.hpp"
+#include "globals.hpp"
 #include "routers/router.hpp"
 
-stack<Handshake *> Handshake::_all;
-stack<Handshake *> Handshake::_free;
-
 ostream& operator<<(ostream& os, const Handshake& h)
 {
   os << "  Handshake ID: " << h.hid << " (" << &h << ") from router: " << h.id;
@@ -43,30 +41,33 @@ void Handshake::Reset()
 }
 
 Handshake * Handshake::New() {
+  stack<Handshake *> & free_list = gSimContext->free_handshakes;
   Handshake * hs;
-  if(_free.empty()) {
+  if(free_list.empty()) {
     hs = new Handshake();
-    _all.push(hs);
+    gSimContext->handshakes.push(hs);
   } else {
-    hs = _free.top();
+    hs = free_list.top();
     hs->Reset();
-    _free.pop();
+    free_list.pop();
   }
   return hs;
 }
 
 void Handshake::Free() {
-  _free.push(this);
+  gSimContext->free_handshakes.push(this);
 }
 
 void Handshake::FreeAll() {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
+  stack<Handshake *> & all = gSimContext->handshakes;
+  while(!all.empty()) {
+    delete all.top();
+    all.pop();
   }
+  gSimContext->free_handshakes = stack<Handshake *>();
 }
 
 
 int Handshake::OutStanding(){
-  return _all.size()-_free.size();
+  return gSimContext->handshakes.size()-gSimContext->free_handshakes.size();
 }
@@ -32,8 +32,6 @@ public:
   static int OutStanding();
 private:
 
-  static stack<Handshake *> _all;
-  static stack<Handshake *> _free;
 
   Handshake();
   ~Handshake() {}
@@ -34,7 +34,7 @@
 
 using namespace std;
 
-InjectionProcess::InjectionProcess(int nodes, double rate)
+InjectionProcess::InjectionProcess(int nodes, double rate, int cl)
   : _nodes(nodes), _rate(rate)
 {
   if(nodes <= 0) {
@@ -46,16 +46,58 @@ InjectionProcess::InjectionProcess(int nodes, double rate)
 	 << endl;
     exit(-1);
   }
+  // one stream per source and traffic class
+  _random.resize(nodes);
+  for(int n = 0; n < nodes; ++n) {
+    _random[n].Key(RandomStream::injection, cl * nodes + n);
+  }
+  _ahead_fail.resize(nodes, 0);
+  _ahead_success.resize(nodes, false);
 }
 
 void InjectionProcess::reset()
 {
+  _ahead_fail.assign(_nodes, 0);
+  _ahead_success.assign(_nodes, false);
+}
+
+bool InjectionProcess::test(int source)
+{
+  if(_ahead_fail[source] > 0) {
+    --_ahead_fail[source];
+    return false;
+  }
+  if(_ahead_success[source]) {
+    _ahead_success[source] = false;
+    return true;
+  }
+  return _test(source);
+}
+
+int InjectionProcess::lookahead(int source, int limit)
+{
+  assert((source >= 0) && (source < _nodes));
+  while(!_ahead_success[source] && (_ahead_fail[source] < limit)) {
+    if(_test(source)) {
+      _ahead_success[source] = true;
+    } else {
+      ++_ahead_fail[source];
+    }
+  }
+  return (_ahead_success[source] && (_ahead_fail[source] < limit)) ?
+    _ahead_fail[source] : -1;
+}
 
+void InjectionProcess::skip(int source, int n)
+{
+  assert(_ahead_fail[source] >= n);
+  _ahead_fail[source] -= n;
 }
 
 InjectionProcess * InjectionProcess::New(string const & inject, int nodes, 
 					 double load, 
-					 Configuration const * const config)
+					 Configuration const * const config,
+					 int cl)
 {
   string process_name;
   string param_str;
@@ -75,7 +117,7 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
 
   InjectionProcess * result = NULL;
   if(process_name == "bernoulli") {
-    result = new BernoulliInjectionProcess(nodes, load);
+    result = new BernoulliInjectionProcess(nodes, load, cl);
   } else if(process_name == "on_off") {
     bool missing_params = false;
     double alpha = numeric_limits<double>::quiet_NaN();
@@ -115,16 +157,13 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
       cout << "Invalid parameters for injection process: " << inject << endl;
       exit(-1);
     }
-    vector<int> initial(nodes);
+    vector<int> initial;
     if(params.size() > 3) {
       initial = tokenize_int(params[2]);
       initial.resize(nodes, initial.back());
-    } else {
-      for(int n = 0; n < nodes; ++n) {
-	initial[n] = RandomInt(1);
-      }
     }
-    result = new OnOffInjectionProcess(nodes, load, alpha, beta, r1, initial);
+    result = new OnOffInjectionProcess(nodes, load, alpha, beta, r1, initial, 
+				       cl);
   } else {
     cout << "Invalid injection process: " << inject << endl;
     exit(-1);
@@ -134,24 +173,26 @@ InjectionProcess * InjectionProcess::New(string const & inject, int nodes,
 
 //=============================================================
 
-BernoulliInjectionProcess::BernoulliInjectionProcess(int nodes, double rate)
-  : InjectionProcess(nodes, rate)
+BernoulliInjectionProcess::BernoulliInjectionProcess(int nodes, double rate, 
+						     int cl)
+  : InjectionProcess(nodes, rate, cl)
 {
 
 }
 
-bool BernoulliInjectionProcess::test(int source)
+bool BernoulliInjectionProcess::_test(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  return (RandomFloat() < _rate);
+  return (_random[source].Float() < _rate);
 }
 
 //=============================================================
 
 OnOffInjectionProcess::OnOffInjectionProcess(int nodes, double rate, 
 					     double alpha, double beta, 
-					     double r1, vector<int> initial)
-  : InjectionProcess(nodes, rate), 
+					     double r1, vector<int> initial, 
+					     int cl)
+  : InjectionProcess(nodes, rate, cl), 
     _alpha(alpha), _beta(beta), _r1(r1), _initial(initial)
 {
   assert(alpha <= 1.0);
@@ -169,22 +210,31 @@ OnOffInjectionProcess::OnOffInjectionProcess(int nodes, double rate,
     assert(r1 < 0.0);
     _r1 = rate * (alpha + beta) / alpha;
   }
+  if(_initial.empty()) {
+    _initial.resize(nodes);
+    for(int n = 0; n < nodes; ++n) {
+      _initial[n] = _random[n].Int(1);
+    }
+  }
   reset();
 }
 
 void OnOffInjectionProcess::reset()
 {
+  InjectionProcess::reset();
   _state = _initial;
 }
 
-bool OnOffInjectionProcess::test(int source)
+bool OnOffInjectionProcess::_test(int source)
 {
   assert((source >= 0) && (source < _nodes));
 
+  RandomStream & random = _random[source];
+
   // advance state
   _state[source] = 
-    _state[source] ? (RandomFloat() >= _beta) : (RandomFloat() < _alpha);
+    _state[source] ? (random.Float() >= _beta) : (random.Float() < _alpha);
 
   // generate packet
-  return _state[source] && (RandomFloat() < _r1);
+  return _state[source] && (random.Float() < _r1);
 }
@@ -29,26 +29,42 @@
 #define _INJECTION_HPP_
 
 #include "config_utils.hpp"
+#include "random_utils.hpp"
 
 using namespace std;
 
 class InjectionProcess {
+private:
+  // outcomes drawn ahead by lookahead(), consumed by test() first: the
+  // failures before the next success, if that was drawn as well
+  vector<int> _ahead_fail;
+  vector<bool> _ahead_success;
 protected:
   int _nodes;
   double _rate;
-  InjectionProcess(int nodes, double rate);
+  vector<RandomStream> _random;
+  InjectionProcess(int nodes, double rate, int cl = 0);
+  virtual bool _test(int source) = 0;
 public:
   virtual ~InjectionProcess() {}
-  virtual bool test(int source) = 0;
+  bool test(int source);
+  // failing tests of source before its next success, -1 if there is none
+  // among the next limit; the outcomes are kept for test(), so with
+  // independent streams per source the run does not change
+  int lookahead(int source, int limit);
+  // the next n tests of source, which lookahead() has seen fail
+  void skip(int source, int n);
   virtual void reset();
   static InjectionProcess * New(string const & inject, int nodes, double load, 
-				Configuration const * const config = NULL);
+				Configuration const * const config = NULL,
+				int cl = 0);
 };
 
 class BernoulliInjectionProcess : public InjectionProcess {
 public:
-  BernoulliInjectionProcess(int nodes, double rate);
-  virtual bool test(int source);
+  BernoulliInjectionProcess(int nodes, double rate, int cl = 0);
+protected:
+  virtual bool _test(int source);
 };
 
 class OnOffInjectionProcess : public InjectionProcess {
@@ -60,9 +76,10 @@ private:
   vector<int> _state;
 public:
   OnOffInjectionProcess(int nodes, double rate, double alpha, double beta, 
-			double r1, vector<int> initial);
+			double r1, vector<int> initial, int cl = 0);
   virtual void reset();
-  virtual bool test(int source);
+protected:
+  virtual bool _test(int source);
 };
 
 #endif 
@@ -0,0 +1,81 @@
+/* Local hand-written stand-in for the flex-generated scanner (flex is not
+ * installed in this sandbox).  Not part of the repository. */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "y.tab.h"
+
+extern int config_input(char *, int);
+void config_error(char * msg, int lineno);
+
+static char *buf = 0;
+static int len = 0, pos = 0, loaded = 0;
+static unsigned int lineno = 1;
+
+static void load(void) {
+  int cap = 4096, r;
+  buf = malloc(cap); len = 0;
+  for (;;) {
+    if (cap - len < 1024) { cap *= 2; buf = realloc(buf, cap); }
+    r = config_input(buf + len, cap - len - 1);
+    if (r <= 0) break;
+    len += r;
+  }
+  buf[len] = 0; pos = 0; loaded = 1;
+}
+static int isdig(char c) { return c >= '0' && c <= '9'; }
+static int islist(char c) { return isalnum((unsigned char)c) || c=='_'||c=='-'||c=='.'||c=='('||c=='{'||c==','||c==')'||c=='}'; }
+static int isstr0(char c) { return isalpha((unsigned char)c)||c=='_'||c=='-'||c=='/'||c=='.'; }
+static int isstr(char c) { return isalnum((unsigned char)c)||c=='_'||c=='-'||c=='/'||c=='.'||c=='+'||c=='('||c=='{'||c==','||c==')'||c=='}'; }
+
+static int m_list(const char *s) {
+  int i = 1, last = 0;
+  if (s[0] != '{') return 0;
+  while (s[i] && islist(s[i])) { if (s[i] == '}' && i >= 2) last = i + 1; i++; }
+  return last;
+}
+static int m_num(const char *s) {
+  int i = (s[0] == '-'); int st = i;
+  while (isdig(s[i])) i++;
+  return i > st ? i : 0;
+}
+static int m_dbl(const char *s) {
+  int best = 0, i = (s[0] == '-'), st = i, j, k;
+  /* ([0-9]*\.)?[0-9]+ */
+  j = st; while (isdig(s[j])) j++;
+  if (j > st) best = j;
+  if (s[j] == '.') { k = j + 1; while (isdig(s[k])) k++; if (k > j + 1) best = k; }
+  if (best && (s[best] == 'e' || s[best] == 'E')) {
+    k = best + 1; if (s[k] == '+' || s[k] == '-') k++;
+    j = k; while (isdig(s[j])) j++;
+    if (j > k) best = j;
+  }
+  return best;
+}
+static int m_str(const char *s) {
+  int i = 1;
+  if (!isstr0(s[0])) return 0;
+  while (s[i] && isstr(s[i])) i++;
+  return i;
+}
+
+int yylex(void) {
+  if (!loaded) load();
+  for (;;) {
+    const char *s;
+    int l, n, d, t;
+    if (pos >= len) { free(buf); buf = 0; loaded = 0; return 0; }
+    s = buf + pos;
+    if (s[0] == '/' && s[1] == '/') { while (pos < len && buf[pos] != '\n') pos++; continue; }
+    if (s[0] == ' ' || s[0] == '\t' || s[0] == '\r') { pos++; continue; }
+    if (s[0] == '\n') { lineno++; pos++; continue; }
+    l = m_list(s); n = m_num(s); d = m_dbl(s); t = m_str(s);
+    if (l && l >= n && l >= d && l >= t) { yylval.name = strndup(s, l); pos += l; return STR; }
+    if (n && n >= d && n >= t) { yylval.num = atoi(s); pos += n; return NUM; }
+    if (d && d >= t) { yylval.fnum = atof(s); pos += d; return FNUM; }
+    if (t) { yylval.name = strndup(s, t); pos += t; return STR; }
+    pos++; return s[0];
+  }
+}
+void yyerror(char * msg) { config_error(msg, lineno); }
+int yywrap() { return 1; }
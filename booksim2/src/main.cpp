@@ -35,6 +35,7 @@
  *
  */
 #include <sys/time.h>
+#include <sys/resource.h>
 
 #include <string>
 #include <cstdlib>
@@ -54,6 +55,9 @@
 #include "injection.hpp"
 #include "power_module.hpp"
 #include "dsent_power_module.hpp"
+#include "dsent_evaluator.hpp"
+#include "profiler.hpp"
+#include "analytical_model.hpp"
 
 
 
@@ -61,35 +65,27 @@
 //Global declarations
 //////////////////////
 
- /* the current traffic manager instance */
-TrafficManager * trafficManager = NULL;
+/* the simulation state is kept in the context of the calling thread,
+ * see globals.hpp
+ */
 
+// cycle 0 before the traffic manager exists (analytical model)
 int GetSimTime() {
-  return trafficManager->getTime();
+  TrafficManager * const tm = gSimContext->traffic_manager;
+  return tm ? tm->getTime() : 0;
 }
 
 class Stats;
 Stats * GetStats(const std::string & name) {
-  Stats* test =  trafficManager->getStats(name);
+  Stats* test =  gSimContext->traffic_manager->getStats(name);
   if(test == 0){
     cout<<"warning statistics "<<name<<" not found"<<endl;
   }
   return test;
 }
 
-/* printing activity factor*/
-bool gPrintActivity;
-
-int gK;//radix
-int gN;//dimension
-int gC;//concentration
-
-int gNodes;
-
-//generate nocviewer trace
-bool gTrace;
-
-ostream * gWatchOut;
+// process start, the startup time runs from here to the first cycle
+static struct timeval gProgramStart;
 
 
 
@@ -97,6 +93,24 @@ ostream * gWatchOut;
 
 bool Simulate( BookSimConfig const & config )
 {
+  /*initialize routing, traffic, injection functions
+   */
+  InitializeRoutingMap( config );
+
+  gPrintActivity = (config.GetInt("print_activity") > 0);
+  gProfile = (config.GetInt("profile") > 0);
+  gTrace = (config.GetInt("viewer_trace") > 0);
+  gSimContext->random_streams = (config.GetInt("random_streams") > 0);
+
+  string watch_out_file = config.GetStr( "watch_out" );
+  if(watch_out_file == "") {
+    gWatchOut = NULL;
+  } else if(watch_out_file == "-") {
+    gWatchOut = &cout;
+  } else {
+    gWatchOut = new ofstream(watch_out_file.c_str());
+  }
+
   vector<Network *> net;
 
   int subnets = config.GetInt("subnets");
@@ -114,6 +128,26 @@ bool Simulate( BookSimConfig const & config )
    *not sure how to use them
    */
 
+  int const analytical = config.GetInt("analytical_model");
+  AnalyticalModel * model = NULL;
+  if (analytical > 0) {
+    model = new AnalyticalModel(config, net);
+    model->Run();
+    model->Display(cout);
+    if (analytical == 1) {
+      delete model;
+      for (int i = 0; i < subnets; ++i) {
+        delete net[i];
+      }
+      if(gWatchOut && (gWatchOut != &cout)) {
+        delete gWatchOut;
+      }
+      gWatchOut = NULL;
+      return true;
+    }
+  }
+
+  TrafficManager * & trafficManager = gSimContext->traffic_manager;
   assert(trafficManager == NULL);
   trafficManager = TrafficManager::New( config, net ) ;
 
@@ -124,6 +158,7 @@ bool Simulate( BookSimConfig const & config )
   struct timeval start_time, end_time; /* Time before/after user code */
   total_time = 0.0;
   gettimeofday(&start_time, NULL);
+  Profiler::Start();
 
   bool result = trafficManager->Run() ;
 
@@ -134,6 +169,55 @@ bool Simulate( BookSimConfig const & config )
 
   cout<<"Total run time "<<total_time<<endl;
 
+  // simulator throughput, flit hops are all network channel traversals
+  // including bypasses
+  long long sim_cycles = trafficManager->getTime();
+  long long flit_hops = 0;
+  for (int i = 0; i < subnets; ++i) {
+    const vector<FlitChannel *> & chan = net[i]->GetChannels();
+    for (size_t c = 0; c < chan.size(); ++c) {
+      const vector<int> & active = chan[c]->GetActivity();
+      for (size_t cl = 0; cl < active.size(); ++cl) {
+        flit_hops += active[cl];
+      }
+    }
+  }
+  double startup_time = ((double)(start_time.tv_sec) + (double)(start_time.tv_usec)/1000000.0)
+                      - ((double)(gProgramStart.tv_sec) + (double)(gProgramStart.tv_usec)/1000000.0);
+  // ru_maxrss survives exec on Linux and would report the parent's peak
+  long peak_rss = 0;
+  ifstream status("/proc/self/status");
+  string line;
+  while (getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      peak_rss = atol(line.c_str() + 6);
+    }
+  }
+  if (peak_rss == 0) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    peak_rss = usage.ru_maxrss / 1024;
+#else
+    peak_rss = usage.ru_maxrss;
+#endif
+  }
+  cout<<"Simulated cycles = "<<sim_cycles<<endl;
+  cout<<"Flit hops = "<<flit_hops<<endl;
+  cout<<"Simulation speed = "<<sim_cycles / total_time<<" cycles/s, "
+      <<flit_hops / total_time<<" flit-hops/s"<<endl;
+  cout<<"Startup time "<<startup_time<<endl;
+  cout<<"Peak RSS = "<<peak_rss<<" KB"<<endl;
+
+  if (gProfile) {
+    Profiler::Display(cout);
+  }
+
+  if (model) {
+    model->Validate(trafficManager, cout);
+    delete model;
+  }
+
   for (int i=0; i<subnets; ++i) {
 
     ///Power analysis
@@ -152,8 +236,10 @@ bool Simulate( BookSimConfig const & config )
     delete net[i];
   }
 
+  // the traffic manager closes the watch stream
   delete trafficManager;
   trafficManager = NULL;
+  gWatchOut = NULL;
 
   return result;
 }
@@ -162,6 +248,11 @@ bool Simulate( BookSimConfig const & config )
 int main( int argc, char **argv )
 {
 
+  gettimeofday(&gProgramStart, NULL);
+
+  SimContext context;
+  gSimContext = &context;
+
   BookSimConfig config;
 
 
@@ -171,22 +262,13 @@ int main( int argc, char **argv )
  }
 
 
-  /*initialize routing, traffic, injection functions
-   */
-  InitializeRoutingMap( config );
-
-  gPrintActivity = (config.GetInt("print_activity") > 0);
-  gTrace = (config.GetInt("viewer_trace") > 0);
-
-  string watch_out_file = config.GetStr( "watch_out" );
-  if(watch_out_file == "") {
-    gWatchOut = NULL;
-  } else if(watch_out_file == "-") {
-    gWatchOut = &cout;
-  } else {
-    gWatchOut = new ofstream(watch_out_file.c_str());
+  /* ==== DSENT power model - Begin ==== */
+  if (config.GetInt("sim_power") > 0 && config.GetInt("dsent_model") &&
+      config.GetInt("dsent_eval")) {
+    DSENT_Evaluator dsent(config);
+    dsent.run(config);
   }
-
+  /* ==== DSENT power model - End ==== */
 
   /*configure and run the simulator
    */
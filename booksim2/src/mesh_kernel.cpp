@@ -0,0 +1,271 @@
+/*
+ * mesh_kernel.cpp
+ * - Allocation kernel of the baseline mesh (mesh_kernel = 1): the
+ *   iSLIP VC and switch allocators of all IQ routers of a DOR mesh keep
+ *   their requests, round-robin pointers and priorities in flat arrays
+ *   of the network, one bit per port, and match with word operations
+ *   instead of walking request maps; grants are the same as iSLIP_Sparse
+ */
+
+#include <cassert>
+#include <iostream>
+
+#include "mesh_kernel.hpp"
+
+bool MeshKernel::Matches( Configuration const & config, int ports )
+{
+  // every port of an allocator is one bit of a word
+  int const vcs = config.GetInt( "num_vcs" );
+  return ( config.GetInt( "mesh_kernel" ) > 0 ) &&
+    ( config.GetStr( "router" ) == "iq" ) &&
+    ( config.GetStr( "routing_function" ) == "dor" ) &&
+    ( config.GetStr( "buffer_policy" ) == "private" ) &&
+    ( config.GetStr( "powergate_type" ) == "no_pg" ) &&
+    ( config.GetStr( "vc_allocator" ) == "islip" ) &&
+    ( config.GetStr( "sw_allocator" ) == "islip" ) &&
+    ( vcs * ports <= 64 ) &&
+    ( config.GetInt( "input_speedup" ) * ports <= 64 ) &&
+    ( config.GetInt( "output_speedup" ) * ports <= 64 );
+}
+
+Allocator * MeshKernel::NewAllocator( Module * parent, string const & name,
+                                      int inputs, int outputs, int iters )
+{
+  assert( ( inputs <= 64 ) && ( outputs <= 64 ) );
+  int const id = _inputs.size( );
+  _inputs.push_back( inputs );
+  _outputs.push_back( outputs );
+  _iters.push_back( iters );
+  _in_base.push_back( _in_req.size( ) );
+  _out_base.push_back( _out_req.size( ) );
+  _req_base.push_back( _label.size( ) );
+  _in_occ.push_back( 0 );
+
+  _in_req.resize( _in_req.size( ) + inputs, 0 );
+  _aptrs.resize( _aptrs.size( ) + inputs, 0 );
+  _out_req.resize( _out_req.size( ) + outputs, 0 );
+  _gptrs.resize( _gptrs.size( ) + outputs, 0 );
+  _label.resize( _label.size( ) + inputs * outputs, -1 );
+  if ( !_in_pri.empty( ) ) {
+    _in_pri.resize( _label.size( ), 0 );
+    _out_pri.resize( _label.size( ), 0 );
+  }
+
+  return new MeshAllocator( this, id, parent, name, inputs, outputs );
+}
+
+MeshAllocator::MeshAllocator( MeshKernel * kernel, int id, Module * parent,
+                              string const & name, int inputs, int outputs )
+  : Allocator( parent, name, inputs, outputs ), _kernel( kernel ), _id( id ),
+    _in_base( kernel->_in_base[id] ), _out_base( kernel->_out_base[id] ),
+    _req_base( kernel->_req_base[id] )
+{
+}
+
+void MeshAllocator::Clear( )
+{
+  unsigned long long & occ = _kernel->_in_occ[_id];
+  unsigned long long * const in_req = &_kernel->_in_req[_in_base];
+  unsigned long long * const out_req = &_kernel->_out_req[_out_base];
+  while ( occ ) {
+    int const in = __builtin_ctzll( occ );
+    occ &= occ - 1;
+    unsigned long long outs = in_req[in];
+    while ( outs ) {
+      out_req[__builtin_ctzll( outs )] = 0;
+      outs &= outs - 1;
+    }
+    in_req[in] = 0;
+  }
+
+  Allocator::Clear( );
+}
+
+int MeshAllocator::ReadRequest( int in, int out ) const
+{
+  sRequest r;
+
+  if ( ! ReadRequest( r, in, out ) ) {
+    r.label = -1;
+  }
+
+  return r.label;
+}
+
+bool MeshAllocator::ReadRequest( sRequest & req, int in, int out ) const
+{
+  assert( ( in >= 0 ) && ( in < _inputs ) );
+  assert( ( out >= 0 ) && ( out < _outputs ) );
+
+  if ( !( ( _kernel->_in_req[_in_base + in] >> out ) & 1 ) ) {
+    return false;
+  }
+  int const r = _req_base + in * _outputs + out;
+  req.port    = out;
+  req.label   = _kernel->_label[r];
+  req.in_pri  = _kernel->_InPri( r );
+  req.out_pri = _kernel->_OutPri( r );
+  return true;
+}
+
+void MeshAllocator::AddRequest( int in, int out, int label,
+                                int in_pri, int out_pri )
+{
+  Allocator::AddRequest( in, out, label, in_pri, out_pri );
+  unsigned long long & in_req = _kernel->_in_req[_in_base + in];
+  unsigned long long & out_req = _kernel->_out_req[_out_base + out];
+  assert( !( ( in_req >> out ) & 1 ) );
+  assert( !( ( out_req >> in ) & 1 ) );
+
+  in_req |= 1ULL << out;
+  out_req |= 1ULL << in;
+  _kernel->_in_occ[_id] |= 1ULL << in;
+
+  int const r = _req_base + in * _outputs + out;
+  _kernel->_label[r] = label;
+  if ( ( in_pri || out_pri ) && _kernel->_in_pri.empty( ) ) {
+    _kernel->_in_pri.resize( _kernel->_label.size( ), 0 );
+    _kernel->_out_pri.resize( _kernel->_label.size( ), 0 );
+  }
+  if ( !_kernel->_in_pri.empty( ) ) {
+    _kernel->_in_pri[r]  = in_pri;
+    _kernel->_out_pri[r] = out_pri;
+  }
+}
+
+void MeshAllocator::RemoveRequest( int in, int out, int label )
+{
+  assert( ( in >= 0 ) && ( in < _inputs ) );
+  assert( ( out >= 0 ) && ( out < _outputs ) );
+
+  unsigned long long & in_req = _kernel->_in_req[_in_base + in];
+  unsigned long long & out_req = _kernel->_out_req[_out_base + out];
+  assert( ( in_req >> out ) & 1 );
+  assert( _kernel->_label[_req_base + in * _outputs + out] == label );
+
+  in_req &= ~( 1ULL << out );
+  out_req &= ~( 1ULL << in );
+  if ( !in_req ) {
+    _kernel->_in_occ[_id] &= ~( 1ULL << in );
+  }
+}
+
+// iSLIP_Sparse::Allocate with the request lists as words: the round-robin
+// search from a pointer is the lowest set bit at or above it, wrapping
+// around to the lowest set bit overall
+void MeshAllocator::Allocate( )
+{
+  unsigned long long const occ = _kernel->_in_occ[_id];
+  if ( !occ ) {
+    return;
+  }
+
+  unsigned long long const * const in_req = &_kernel->_in_req[_in_base];
+  unsigned long long const * const out_req = &_kernel->_out_req[_out_base];
+  int * const gptrs = &_kernel->_gptrs[_out_base];
+  int * const aptrs = &_kernel->_aptrs[_in_base];
+  int const iters = _kernel->_iters[_id];
+
+  unsigned long long requested = 0;
+  for ( unsigned long long ins = occ; ins; ins &= ins - 1 ) {
+    requested |= in_req[__builtin_ctzll( ins )];
+  }
+
+  unsigned long long in_free = ~0ULL;
+  unsigned long long out_free = ~0ULL;
+  unsigned long long grants[64];
+
+  for ( int iter = 0; iter < iters; ++iter ) {
+
+    // Grant phase
+    for ( unsigned long long ins = occ; ins; ins &= ins - 1 ) {
+      grants[__builtin_ctzll( ins )] = 0;
+    }
+    for ( unsigned long long outs = requested & out_free; outs; outs &= outs - 1 ) {
+      int const output = __builtin_ctzll( outs );
+      unsigned long long const cand = out_req[output] & in_free;
+      if ( !cand ) {
+        continue;
+      }
+      unsigned long long const ahead = cand & ( ~0ULL << gptrs[output] );
+      int const input = __builtin_ctzll( ahead ? ahead : cand );
+      grants[input] |= 1ULL << output;
+    }
+
+    // Accept phase
+    for ( unsigned long long ins = occ & in_free; ins; ins &= ins - 1 ) {
+      int const input = __builtin_ctzll( ins );
+      unsigned long long const cand = grants[input];
+      if ( !cand ) {
+        continue;
+      }
+      unsigned long long const ahead = cand & ( ~0ULL << aptrs[input] );
+      int const output = __builtin_ctzll( ahead ? ahead : cand );
+
+      _inmatch[input]   = output;
+      _outmatch[output] = input;
+      in_free &= ~( 1ULL << input );
+      out_free &= ~( 1ULL << output );
+
+      // Only update pointers if accepted during the 1st iteration
+      if ( iter == 0 ) {
+        gptrs[output] = ( input + 1 ) % _inputs;
+        aptrs[input]  = ( output + 1 ) % _outputs;
+      }
+    }
+  }
+}
+
+bool MeshAllocator::OutputHasRequests( int out ) const
+{
+  return _kernel->_out_req[_out_base + out] != 0;
+}
+
+bool MeshAllocator::InputHasRequests( int in ) const
+{
+  return _kernel->_in_req[_in_base + in] != 0;
+}
+
+int MeshAllocator::NumOutputRequests( int out ) const
+{
+  return __builtin_popcountll( _kernel->_out_req[_out_base + out] );
+}
+
+int MeshAllocator::NumInputRequests( int in ) const
+{
+  return __builtin_popcountll( _kernel->_in_req[_in_base + in] );
+}
+
+void MeshAllocator::PrintRequests( ostream * os ) const
+{
+  if(!os) os = &cout;
+
+  *os << "Input requests = [ ";
+  for ( int input = 0; input < _inputs; ++input ) {
+    unsigned long long outs = _kernel->_in_req[_in_base + input];
+    if ( outs ) {
+      *os << input << " -> [ ";
+      for ( ; outs; outs &= outs - 1 ) {
+        int const output = __builtin_ctzll( outs );
+        *os << output << "@"
+            << _kernel->_InPri( _req_base + input * _outputs + output ) << " ";
+      }
+      *os << "]  ";
+    }
+  }
+  *os << "], output requests = [ ";
+  for ( int output = 0; output < _outputs; ++output ) {
+    unsigned long long ins = _kernel->_out_req[_out_base + output];
+    if ( ins ) {
+      *os << output << " -> ";
+      *os << "[ ";
+      for ( ; ins; ins &= ins - 1 ) {
+        int const input = __builtin_ctzll( ins );
+        *os << input << "@"
+            << _kernel->_OutPri( _req_base + input * _outputs + output ) << " ";
+      }
+      *os << "]  ";
+    }
+  }
+  *os << "]." << endl;
+}
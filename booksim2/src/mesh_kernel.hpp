@@ -0,0 +1,99 @@
+/*
+ * mesh_kernel.hpp
+ * - Allocation kernel of the baseline mesh (mesh_kernel = 1): the
+ *   iSLIP VC and switch allocators of all IQ routers of a DOR mesh keep
+ *   their requests, round-robin pointers and priorities in flat arrays
+ *   of the network, one bit per port, and match with word operations
+ *   instead of walking request maps; grants are the same as iSLIP_Sparse
+ */
+
+#ifndef _MESH_KERNEL_HPP_
+#define _MESH_KERNEL_HPP_
+
+#include <string>
+#include <vector>
+
+#include "allocator.hpp"
+#include "config_utils.hpp"
+
+using namespace std;
+
+class MeshKernel {
+
+  // per allocator
+  vector<int> _inputs;
+  vector<int> _outputs;
+  vector<int> _iters;
+  vector<int> _in_base;
+  vector<int> _out_base;
+  vector<int> _req_base;
+  vector<unsigned long long> _in_occ;
+
+  // per allocator input: requested outputs and accept pointer
+  vector<unsigned long long> _in_req;
+  vector<int> _aptrs;
+
+  // per allocator output: requesting inputs and grant pointer
+  vector<unsigned long long> _out_req;
+  vector<int> _gptrs;
+
+  // per allocator input and output; the priorities are only allocated
+  // once a request has one, runs without packet priorities never do
+  vector<int> _label;
+  vector<int> _in_pri;
+  vector<int> _out_pri;
+
+  inline int _InPri( int r ) const { return _in_pri.empty( ) ? 0 : _in_pri[r]; }
+  inline int _OutPri( int r ) const { return _out_pri.empty( ) ? 0 : _out_pri[r]; }
+
+  friend class MeshAllocator;
+
+public:
+
+  // the baseline the kernel covers: IQ routers with iSLIP allocators,
+  // DOR routing, private buffers and no power gating, ports routers
+  // ports wide
+  static bool Matches( Configuration const & config, int ports );
+
+  // an iSLIP allocator on the arrays of the kernel, owned by the caller
+  Allocator * NewAllocator( Module * parent, string const & name,
+                            int inputs, int outputs, int iters );
+
+};
+
+class MeshAllocator : public Allocator {
+
+  MeshKernel * _kernel;
+  int _id;
+
+  int _in_base;
+  int _out_base;
+  int _req_base;
+
+public:
+
+  MeshAllocator( MeshKernel * kernel, int id, Module * parent,
+                 string const & name, int inputs, int outputs );
+
+  void Clear( );
+
+  int  ReadRequest( int in, int out ) const;
+  bool ReadRequest( sRequest & req, int in, int out ) const;
+
+  void AddRequest( int in, int out, int label = 1,
+                   int in_pri = 0, int out_pri = 0 );
+  void RemoveRequest( int in, int out, int label = 1 );
+
+  void Allocate( );
+
+  bool OutputHasRequests( int out ) const;
+  bool InputHasRequests( int in ) const;
+
+  int NumOutputRequests( int out ) const;
+  int NumInputRequests( int in ) const;
+
+  void PrintRequests( ostream * os = NULL ) const;
+
+};
+
+#endif
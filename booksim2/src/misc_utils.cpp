@@ -25,6 +25,8 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cmath>
+
 #include "booksim.hpp"
 #include "misc_utils.hpp"
 
@@ -50,3 +52,45 @@ int log_two( int x )
 
   return r;
 }
+
+// P(|T| < t) for integer degrees of freedom, Abramowitz & Stegun 26.7.3/4
+static double student_t_central( double t, int dof )
+{
+  double const theta = atan( t / sqrt( (double)dof ) );
+  double const c2 = cos( theta ) * cos( theta );
+  double sum, term;
+  if ( dof % 2 ) {
+    if ( dof == 1 ) {
+      return 2.0 * theta / M_PI;
+    }
+    sum = term = cos( theta );
+    for ( int i = 3; i <= dof - 2; i += 2 ) {
+      term *= c2 * ( i - 1 ) / i;
+      sum += term;
+    }
+    return 2.0 * ( theta + sin( theta ) * sum ) / M_PI;
+  }
+  sum = term = 1.0;
+  for ( int i = 2; i <= dof - 2; i += 2 ) {
+    term *= c2 * ( i - 1 ) / i;
+    sum += term;
+  }
+  return sin( theta ) * sum;
+}
+
+double student_t_critical( double confidence, int dof )
+{
+  double lo = 0.0, hi = 1.0;
+  while ( student_t_central( hi, dof ) < confidence ) {
+    hi *= 2.0;
+  }
+  for ( int i = 0; i < 100; ++i ) {
+    double const mid = 0.5 * ( lo + hi );
+    if ( student_t_central( mid, dof ) < confidence ) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return 0.5 * ( lo + hi );
+}
@@ -31,4 +31,7 @@
 int log_two( int x );
 int powi( int x, int y );
 
+// two-sided critical value of Student's t distribution
+double student_t_critical( double confidence, int dof );
+
 #endif 
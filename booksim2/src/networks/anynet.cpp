@@ -56,7 +56,7 @@
 #include <limits>
 #include <algorithm>
 //this is a hack, I can't easily get the routing talbe out of the network
-map<int, int>* global_routing_table;
+#define global_routing_table (gSimContext->anynet_routing_table)
 
 AnyNet::AnyNet( const Configuration &config, const string & name )
   :  Network( config, name ){
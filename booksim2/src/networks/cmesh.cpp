@@ -47,11 +47,12 @@
 #include "misc_utils.hpp"
 #include "cmesh.hpp"
 
-int CMesh::_cX = 0 ;
-int CMesh::_cY = 0 ;
-int CMesh::_memo_NodeShiftX = 0 ;
-int CMesh::_memo_NodeShiftY = 0 ;
-int CMesh::_memo_PortShiftY = 0 ;
+// shared with the static routing helpers through the simulation context
+#define _cX (gSimContext->cmesh_cx)
+#define _cY (gSimContext->cmesh_cy)
+#define _memo_NodeShiftX (gSimContext->cmesh_node_shift_x)
+#define _memo_NodeShiftY (gSimContext->cmesh_node_shift_y)
+#define _memo_PortShiftY (gSimContext->cmesh_port_shift_y)
 
 CMesh::CMesh( const Configuration& config, const string & name ) 
   : Network(config, name) 
@@ -104,6 +105,17 @@ void CMesh::_ComputeSize( const Configuration &config ) {
   _memo_NodeShiftY = log_two(gK * _cX) + ( _cY >> 1 ) ;
   _memo_PortShiftY = log_two(gK * _cX)  ;
 
+  /* ==== Power Gate - Begin ==== */
+  string const router = config.GetStr("router");
+  _flov_ports = (router == "flov");
+  if (_powergate_type != "no_pg" && _powergate_type != "flov") {
+    Error("power-gating type " + _powergate_type + " does not support cmesh");
+  }
+  if (router == "gflov" || router == "rflov" || router == "nord" ||
+      router == "rp") {
+    Error("router " + router + " does not support cmesh, use router = flov");
+  }
+  /* ==== Power Gate - End ==== */
 }
 
 void CMesh::_BuildNet( const Configuration& config ) {
@@ -155,25 +167,13 @@ void CMesh::_BuildNet( const Configuration& config ) {
     //  each new channel
     //
 
-    //
-    // Processing node channels
-    //
-    for (int y = 0; y < _cY ; y++) {
-      for (int x = 0; x < _cX ; x++) {
-	int link = (_k * _cX) * (_cY * y_index + y) + (_cX * x_index + x) ;
-	assert( link >= 0 ) ;
-	assert( link < _nodes ) ;
-	assert( channel_vector[ link ] == false ) ;
-	channel_vector[link] = true ;
-	// Ingress Ports
-	_routers[node]->AddInputChannel(_inject[link], _inject_cred[link]);
-	// Egress Ports
-	_routers[node]->AddOutputChannel(_eject[link], _eject_cred[link]);
-	//injeciton ejection latency is 1
-	_inject[link]->SetLatency( 1 );
-	_eject[link]->SetLatency( 1 );
-      }
+    /* ==== Power Gate - Begin ==== */
+    if (_router_states[node] == false) {
+      _routers[node]->SetRouterState(false);
     }
+    if (!_flov_ports)
+      _AddNodeChannels(node, channel_vector);
+    /* ==== Power Gate - End ==== */
 
     //
     // router to router channels
@@ -242,6 +242,11 @@ void CMesh::_BuildNet( const Configuration& config ) {
     }
     _routers[node]->AddOutputChannel( _chan[px_out], _chan_cred[px_out] );
     _routers[node]->AddInputChannel( _chan[px_in], _chan_cred[px_in] );
+    /* ==== Power Gate - Begin ==== */
+    _chan_handshake[px_out]->SetLatency( _chan[px_out]->GetLatency() );
+    _routers[node]->AddOutputHandshake( _chan_handshake[px_out] );
+    _routers[node]->AddInputHandshake( _chan_handshake[px_in] );
+    /* ==== Power Gate - End ==== */
     
     if(gTrace) {
       cout<<"Link "<<" "<<px_out<<" "<<px_in<<" "<<node<<" "<<_chan[px_out]->GetLatency()<<endl;
@@ -258,6 +263,11 @@ void CMesh::_BuildNet( const Configuration& config ) {
     }
     _routers[node]->AddOutputChannel( _chan[nx_out], _chan_cred[nx_out] );
     _routers[node]->AddInputChannel( _chan[nx_in], _chan_cred[nx_in] );
+    /* ==== Power Gate - Begin ==== */
+    _chan_handshake[nx_out]->SetLatency( _chan[nx_out]->GetLatency() );
+    _routers[node]->AddOutputHandshake( _chan_handshake[nx_out] );
+    _routers[node]->AddInputHandshake( _chan_handshake[nx_in] );
+    /* ==== Power Gate - End ==== */
 
     if(gTrace){
       cout<<"Link "<<" "<<nx_out<<" "<<nx_in<<" "<<node<<" "<<_chan[nx_out]->GetLatency()<<endl;
@@ -274,6 +284,11 @@ void CMesh::_BuildNet( const Configuration& config ) {
     }
     _routers[node]->AddOutputChannel( _chan[py_out], _chan_cred[py_out] );
     _routers[node]->AddInputChannel( _chan[py_in], _chan_cred[py_in] );
+    /* ==== Power Gate - Begin ==== */
+    _chan_handshake[py_out]->SetLatency( _chan[py_out]->GetLatency() );
+    _routers[node]->AddOutputHandshake( _chan_handshake[py_out] );
+    _routers[node]->AddInputHandshake( _chan_handshake[py_in] );
+    /* ==== Power Gate - End ==== */
     
     if(gTrace){
       cout<<"Link "<<" "<<py_out<<" "<<py_in<<" "<<node<<" "<<_chan[py_out]->GetLatency()<<endl;
@@ -290,10 +305,20 @@ void CMesh::_BuildNet( const Configuration& config ) {
     }
     _routers[node]->AddOutputChannel( _chan[ny_out], _chan_cred[ny_out] );
     _routers[node]->AddInputChannel( _chan[ny_in], _chan_cred[ny_in] );    
+    /* ==== Power Gate - Begin ==== */
+    _chan_handshake[ny_out]->SetLatency( _chan[ny_out]->GetLatency() );
+    _routers[node]->AddOutputHandshake( _chan_handshake[ny_out] );
+    _routers[node]->AddInputHandshake( _chan_handshake[ny_in] );
+    /* ==== Power Gate - End ==== */
 
     if(gTrace){
       cout<<"Link "<<" "<<ny_out<<" "<<ny_in<<" "<<node<<" "<<_chan[ny_out]->GetLatency()<<endl;
     }
+
+    /* ==== Power Gate - Begin ==== */
+    if (_flov_ports)
+      _AddNodeChannels(node, channel_vector);
+    /* ==== Power Gate - End ==== */
     
   }    
 
@@ -304,6 +329,43 @@ void CMesh::_BuildNet( const Configuration& config ) {
   if(gTrace){
     cout<<"Setup Finished Link"<<endl;
   }
+
+  /* ==== Power Gate - Begin ==== */
+  for (int c = 0; c < _nodes; ++c) {
+    if (_core_states[c] && !_router_states[NodeToRouter(c)]) {
+      ostringstream err;
+      err << "router " << NodeToRouter(c) << " is off but its core " << c
+          << " is on";
+      Error(err.str());
+    }
+  }
+  /* ==== Power Gate - End ==== */
+}
+
+//
+// Processing node channels
+//
+void CMesh::_AddNodeChannels( int node, vector<bool> & channel_vector ) {
+
+  int y_index = node / _k ;
+  int x_index = node % _k ;
+
+  for (int y = 0; y < _cY ; y++) {
+    for (int x = 0; x < _cX ; x++) {
+      int link = (_k * _cX) * (_cY * y_index + y) + (_cX * x_index + x) ;
+      assert( link >= 0 ) ;
+      assert( link < _nodes ) ;
+      assert( channel_vector[ link ] == false ) ;
+      channel_vector[link] = true ;
+      // Ingress Ports
+      _routers[node]->AddInputChannel(_inject[link], _inject_cred[link]);
+      // Egress Ports
+      _routers[node]->AddOutputChannel(_eject[link], _eject_cred[link]);
+      //injeciton ejection latency is 1
+      _inject[link]->SetLatency( 1 );
+      _eject[link]->SetLatency( 1 );
+    }
+  }
 }
 
 
@@ -502,7 +564,7 @@ void xy_yx_cmesh( const Router *r, const Flit *f, int in_channel,
 
       // randomly select dimension order at first hop
       bool x_then_y = ((in_channel < gC) ?
-		       (RandomInt(1) > 0) :
+		       (RoutingRandom(r, f).Int(1) > 0) :
 		       (f->vc < (vcBegin + available_vcs)));
 
       if(x_then_y) {
@@ -642,7 +704,7 @@ void xy_yx_no_express_cmesh( const Router *r, const Flit *f, int in_channel,
 
       // randomly select dimension order at first hop
       bool x_then_y = ((in_channel < gC) ?
-		       (RandomInt(1) > 0) :
+		       (RoutingRandom(r, f).Int(1) > 0) :
 		       (f->vc < (vcBegin + available_vcs)));
 
       if(x_then_y) {
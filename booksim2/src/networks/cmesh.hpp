@@ -55,17 +55,15 @@ public:
 
   static void RegisterRoutingFunctions() ;
 
-private:
-
-  static int _cX ;
-  static int _cY ;
+  /* ==== Power Gate - Begin ==== */
+  int CoreRouter( int core ) const { return NodeToRouter(core); }
+  /* ==== Power Gate - End ==== */
 
-  static int _memo_NodeShiftX ;
-  static int _memo_NodeShiftY ;
-  static int _memo_PortShiftY ;
+private:
 
   void _ComputeSize( const Configuration &config );
   void _BuildNet( const Configuration& config );
+  void _AddNodeChannels( int node, vector<bool> & channel_vector );
 
   int _k ;
   int _n ;
@@ -75,6 +73,9 @@ private:
   int _xrouter;
   int _yrouter;
   bool _express_channels;
+  /* ==== Power Gate - Begin ==== */
+  bool _flov_ports;  // router-to-router ports first, as FLOV routers expect
+  /* ==== Power Gate - End ==== */
 };
 
 //
@@ -37,7 +37,10 @@
 
 #define DRAGON_LATENCY
 
-int gP, gA, gG;
+// group shape, kept in the simulation context for the routing functions
+#define gP (gSimContext->dragonfly_p)
+#define gA (gSimContext->dragonfly_a)
+#define gG (gSimContext->dragonfly_g)
 
 //calculate the hop count between src and estination
 int dragonflynew_hopcnt(int src, int dest) 
@@ -413,7 +416,7 @@ void min_dragonflynew( const Router *r, const Flit *f, int in_channel,
   outputs->Clear( );
 
   if(inject) {
-    int inject_vc= RandomInt(gNumVCs-1);
+    int inject_vc= RoutingRandom(r, f).Int(gNumVCs-1);
     outputs->AddRange(-1, inject_vc, inject_vc);
     return;
   }
@@ -463,7 +466,7 @@ void ugal_dragonflynew( const Router *r, const Flit *f, int in_channel,
   assert(gNumVCs==3);
   outputs->Clear( );
   if(inject) {
-    int inject_vc= RandomInt(gNumVCs-1);
+    int inject_vc= RoutingRandom(r, f).Int(gNumVCs-1);
     outputs->AddRange(-1, inject_vc, inject_vc);
     return;
   }
@@ -502,7 +505,7 @@ void ugal_dragonflynew( const Router *r, const Flit *f, int in_channel,
       f->ph = 2;
     } else {
       //select a random node
-      f->intm =RandomInt(_network_size - 1);
+      f->intm =RoutingRandom(r, f).Int(_network_size - 1);
       intm_grp_ID = (int)(f->intm/_grp_num_nodes);
       if (debug){
 	cout<<"Intermediate node "<<f->intm<<" grp id "<<intm_grp_ID<<endl;
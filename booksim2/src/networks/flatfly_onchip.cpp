@@ -60,10 +60,10 @@
 
 //#define DEBUG_FLATFLY
 
-static int _xcount;
-static int _ycount;
-static int _xrouter;
-static int _yrouter;
+#define _xcount (gSimContext->flatfly_xcount)
+#define _ycount (gSimContext->flatfly_ycount)
+#define _xrouter (gSimContext->flatfly_xrouter)
+#define _yrouter (gSimContext->flatfly_yrouter)
 
 FlatFlyOnChip::FlatFlyOnChip( const Configuration &config, const string & name ) :
   Network( config, name )
@@ -383,7 +383,7 @@ void adaptive_xyyx_flatfly( const Router *r, const Flit *f, int in_channel,
 	} else if(credit_xy < credit_yx) {
 	  x_then_y = true;
 	} else {
-	  x_then_y = (RandomInt(1) > 0);
+	  x_then_y = (RoutingRandom(r, f).Int(1) > 0);
 	}
       } else {
 	x_then_y =  (f->vc < (vcBegin + available_vcs));
@@ -448,7 +448,7 @@ void xyyx_flatfly( const Router *r, const Flit *f, int in_channel,
 
       // randomly select dimension order at first hop
       bool x_then_y = ((in_channel < gC) ?
-		       (RandomInt(1) > 0) : 
+		       (RoutingRandom(r, f).Int(1) > 0) : 
 		       (f->vc < (vcBegin + available_vcs)));
 
       if(x_then_y) {
@@ -529,7 +529,7 @@ void valiant_flatfly( const Router *r, const Flit *f, int in_channel,
 
     if ( in_channel < gC ){
       f->ph = 0;
-      f->intm = RandomInt( powi( gK, gN )*gC-1);
+      f->intm = RoutingRandom(r, f).Int( powi( gK, gN )*gC-1);
     }
 
     int intm = flatfly_transformation(f->intm);
@@ -711,7 +711,7 @@ void ugal_xyyx_flatfly_onchip( const Router *r, const Flit *f, int in_channel,
 
       // randomly select dimension order at first hop
       bool x_then_y = ((in_channel < gC) ?
-		       (RandomInt(1) > 0) : 
+		       (RoutingRandom(r, f).Int(1) > 0) : 
 		       (f->vc < (vcBegin + xy_available_vcs)));
 
       if (f->ph == 0) {
@@ -729,7 +729,7 @@ void ugal_xyyx_flatfly_onchip( const Router *r, const Flit *f, int in_channel,
 	_min_queucnt =   r->GetUsedCredit(tmp_out_port);
 
 	//find the nonmin router, nonmin port, nonmin count
-	_ran_intm = find_ran_intm(flatfly_transformation(f->src), dest);
+	_ran_intm = find_ran_intm(RoutingRandom(r, f), flatfly_transformation(f->src), dest);
 	_nonmin_hop = find_distance(flatfly_transformation(f->src),_ran_intm) +    find_distance(_ran_intm, dest);
 	if(x_then_y){
 	  tmp_out_port =  flatfly_outport(_ran_intm, rID);
@@ -908,7 +908,7 @@ void ugal_flatfly_onchip( const Router *r, const Flit *f, int in_channel,
 
       if (f->ph == 0) {
 	_min_hop = find_distance(flatfly_transformation(f->src),dest);
-	_ran_intm = find_ran_intm(flatfly_transformation(f->src), dest);
+	_ran_intm = find_ran_intm(RoutingRandom(r, f), flatfly_transformation(f->src), dest);
 	tmp_out_port =  flatfly_outport(dest, rID);
 	if (f->watch){
 	  *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
@@ -1081,7 +1081,7 @@ void ugal_pni_flatfly_onchip( const Router *r, const Flit *f, int in_channel,
 
       if (f->ph == 0) {
 	_min_hop = find_distance(flatfly_transformation(f->src),dest);
-	_ran_intm = find_ran_intm(flatfly_transformation(f->src), dest);
+	_ran_intm = find_ran_intm(RoutingRandom(r, f), flatfly_transformation(f->src), dest);
 	tmp_out_port =  flatfly_outport(dest, rID);
 	if (f->watch){
 	  *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
@@ -1229,7 +1229,7 @@ int find_distance (int src, int dest) {
 //=============================================================^M
 // UGAL : find random node for load balancing
 //=============================================================^M
-int find_ran_intm (int src, int dest) {
+int find_ran_intm (RandomStream & random, int src, int dest) {
   int _dim   = gN;
   int _dim_size;
   int _ran_dest = 0;
@@ -1241,7 +1241,7 @@ int find_ran_intm (int src, int dest) {
   src = (int) (src / gC);
   dest = (int) (dest / gC);
   
-  _ran_dest = RandomInt(gC - 1);
+  _ran_dest = random.Int(gC - 1);
   if (debug) cout << " ............ _ran_dest : " << _ran_dest << endl;
   for (int d=0;d < _dim; d++) {
     
@@ -1253,7 +1253,7 @@ int find_ran_intm (int src, int dest) {
     } else {
       // src and dest are in the same dimension "d" + 1
       // ==> thus generate a random destination within
-      _ran_dest += RandomInt(gK - 1) * _dim_size;
+      _ran_dest += random.Int(gK - 1) * _dim_size;
       if (debug) 
 	cout << "    different  dimension : " << d << " int node : " << _ran_dest << " _dim_size: " << _dim_size << endl;
     }
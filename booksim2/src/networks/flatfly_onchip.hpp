@@ -80,7 +80,7 @@ void valiant_flatfly( const Router *r, const Flit *f, int in_channel,
 			  OutputSet *outputs, bool inject );
 
 int find_distance (int src, int dest);
-int find_ran_intm (int src, int dest);
+int find_ran_intm (RandomStream & random, int src, int dest);
 int flatfly_outport(int dest, int rID);
 int flatfly_transformation(int dest);
 int flatfly_outport_yx(int dest, int rID);
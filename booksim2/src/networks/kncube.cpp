@@ -39,6 +39,7 @@
 #include "kncube.hpp"
 #include "random_utils.hpp"
 #include "misc_utils.hpp"
+#include "mesh_kernel.hpp"
 /* ==== Power Gate - Begin ==== */
 #include "routetbl.hpp"
 /* ==== Power Gate - End ==== */
@@ -51,6 +52,9 @@ KNCube::KNCube( const Configuration &config, const string & name, bool mesh ) :
 
   _ComputeSize( config );
   _Alloc( );
+  if ( _mesh && MeshKernel::Matches( config, 2*_n + 1 ) ) {
+    _mesh_kernel = new MeshKernel;
+  }
   _BuildNet( config );
 }
 
@@ -308,6 +312,8 @@ void KNCube::InsertRandomFaults( const Configuration &config )
       fail_seed = config.GetInt( "fail_seed" );
     }
     RandomSeed( fail_seed );
+    RandomStream random;
+    random.Key( RandomStream::fail, 0, fail_seed );
 
     vector<bool> fail_nodes(_size);
 
@@ -332,7 +338,7 @@ void KNCube::InsertRandomFaults( const Configuration &config )
     }
 
     for ( int i = 0; i < num_fails; ++i ) {
-      int j = RandomInt( _size - 1 );
+      int j = random.Int( _size - 1 );
       bool available = false;
       int node = -1;
       int chan = -1;
@@ -343,7 +349,7 @@ void KNCube::InsertRandomFaults( const Configuration &config )
 
         if ( !fail_nodes[node] ) {
           // check neighbors
-          int c = RandomInt( 2*_n - 1 );
+          int c = random.Int( 2*_n - 1 );
 
           for ( int n = 0; ( n < 2*_n ) && (!available); ++n ) {
             chan = ( n + c ) % 2*_n;
@@ -39,6 +39,9 @@
 #include "booksim.hpp"
 #include "network.hpp"
 #include "random_utils.hpp"
+#include "misc_utils.hpp"
+#include "event_wheel.hpp"
+#include "mesh_kernel.hpp"
 
 #include "kncube.hpp"
 #include "fly.hpp"
@@ -133,6 +136,11 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+  _channel_modules = 0;
+  _event_wheel = NULL;
+  _mesh_kernel = NULL;
+  _channel_profile_owner = Profiler::Owner("channels");
+  _router_profile_owner = Profiler::Owner(config.GetStr("router") + " router");
   /* ==== DSENT power model - Begin ==== */
   _net_energy_stats.Reset();
   /* ==== DSENT power model - End ==== */
@@ -151,9 +159,11 @@ Network::Network( const Configuration &config, const string & name ) :
 
 Network::~Network( )
 {
+  delete _event_wheel;
   for ( int r = 0; r < _size; ++r ) {
     if ( _routers[r] ) delete _routers[r];
   }
+  delete _mesh_kernel;
   for ( int s = 0; s < _nodes; ++s ) {
     if ( _inject[s] ) delete _inject[s];
     if ( _inject_cred[s] ) delete _inject_cred[s];
@@ -228,14 +238,16 @@ void Network::_Alloc( )
   gNodes = _nodes;
 
   /* ==== Power Gate - Begin ==== */
-  _core_states.resize(_size, true);
+  _core_states.resize(_nodes, true);
   _router_states.resize(_size, true);
   if (_powergate_auto_config) {
     _off_cores.clear();
     _off_routers.clear();
     // random off core id generation for core parking
     unsigned num_off_cores = _nodes * _powergate_percentile / 100;
-    if (num_off_cores + gK > _nodes) {
+    // cores of the last row (plane for 3D) stay on, they are numbered last
+    int const always_on = powi(gK, gN - 1) * (_nodes / _size);
+    if (num_off_cores + always_on > _nodes) {
       ostringstream err;
       err << "percentile of power-gating is too high, should keep one row active" << endl;
       Error(err.str());
@@ -245,11 +257,12 @@ void Network::_Alloc( )
     }
     assert(_fabric_manager < _size);
     RandomSeed(_powergate_seed);
+    _powergate_random.Key(RandomStream::power_gate, 0, _powergate_seed);
     for (unsigned i = 0; i < num_off_cores; ++i) {
-      int cid = RandomInt(_nodes - 1 - gK);
+      int cid = _powergate_random.Int(_nodes - 1 - always_on);
       while (find(_off_cores.begin(), _off_cores.end(), cid) != _off_cores.end() ||
           cid == _fabric_manager) {
-        cid = RandomInt(_nodes - 1 - gK);
+        cid = _powergate_random.Int(_nodes - 1 - always_on);
       }
       _off_cores.push_back(cid);
     }
@@ -271,198 +284,16 @@ void Network::_Alloc( )
         _powergate_type == "rflov" ||
         _powergate_type == "flov" ||
         _powergate_type == "nord") {
-      _router_states = _core_states;
-    } else if (_powergate_type == "rpa") {  // aggressive RP
-      _router_states = _core_states;
-      // initialize adjacent matrix
-      vector<vector<int> > adj_mat;
-      adj_mat.resize(_size);
-      for (int i = 0; i < _size; ++i) {
-        adj_mat[i].resize(_size, -1);
-
-        int ix = i % gK;
-        int iy = i / gK;
-        for (int j = 0; j < _size; ++j) {
-          if (_router_states[i] == false || _router_states[j] == false)
-            continue;
-
-          int jx = j % gK;
-          int jy = j / gK;
-
-          if (i == j) {
-            adj_mat[i][j] = 0;
-          } else if ( (abs(ix - jx) == 1 && iy == jy) ||
-              (abs(iy - jy) == 1 && ix == jx) ) {
-            adj_mat[i][j] = 1;
-          }
-        }
-      }
-#ifdef DEBUG_POWERGATE_CONFIG
-      cout << "Adjacent List: " << endl;
-      for (int i = 0; i < _size; ++i) {
-        cout << "\t" << i << ": ";
-        for (int j = 0; j < _size; ++j) {
-          if (adj_mat[i][j] > 0) cout << j << " ";
-        }
-        cout << endl;
-      }
-#endif
-      // measure network connectivity
-      vector<vector<int> > strong_cnctd_comps;
-      vector<int> new_component;
-      vector<bool> visited(_size, false);
-      for (int r = 0; r < _size; ++r) {
-        if (_router_states[r] == false) continue;
-        if (visited[r] == true) continue;
-
-        deque<int> bfs_q;
-        bfs_q.push_back(r);
-        visited[r] = true;
-        new_component.clear();
-
-        while (!bfs_q.empty()) {
-          int n = bfs_q.front();
-          bfs_q.pop_front();
-          new_component.push_back(n);
-          for (int i = 0; i < _size; ++i) {
-            if (adj_mat[n][i] == 1 && visited[i] == false) {
-              visited[i] = true;
-              bfs_q.push_back(i);
-            }
-          }
-        }
-        sort(new_component.begin(), new_component.end());
-#ifdef DEBUG_POWERGATE_CONFIG
-        cout << "component " << strong_cnctd_comps.size() << ": ";
-        for (unsigned k = 0; k < new_component.size(); ++k) {
-          cout << new_component[k] << ", ";
-        }
-        cout << endl;
-#endif
-        strong_cnctd_comps.push_back(new_component);
-      }
-      if (strong_cnctd_comps.size() == 1) {
-#ifdef DEBUG_POWERGATE_CONFIG
-        cout << "network is connected" << endl;
-#endif
-      } else {
-#ifdef DEBUG_POWERGATE_CONFIG
-        cout << "network is disjoint with " << strong_cnctd_comps.size() << " partitions" << endl;
-#endif
-        vector<bool> is_edge_router(_size, false);
-        for (int rid = 0; rid < _size; ++rid) {
-          int num_neighbors = 0;
-          for (int j = 0; j < _size; ++j) {
-            if (adj_mat[rid][j] == 1)
-              ++num_neighbors;
-          }
-          if ( ((rid == 0 || rid == gK - 1 || rid == _size - 1 || rid == _size - gK) && num_neighbors < 2) ||
-              ((rid / gK == 0 || rid % gK == 0 || rid / gK == gK - 1 || rid % gK == gK - 1) && num_neighbors < 3) ||
-              ((rid / gK > 0 && rid % gK > 0 && rid / gK < gK - 1 && rid % gK < gK - 1) && num_neighbors < 4) )
-            is_edge_router[rid] = true;
-        }
-        for (unsigned i = 0; i < strong_cnctd_comps.size(); ++i) {
-          vector<int> component = strong_cnctd_comps[i];
-          if (find(component.begin(), component.end(), _fabric_manager) != component.end())
-            continue;
-
-          vector<int> connected_routers;
-          unsigned num_off_routers_on_path = _size;
-          int fx = _fabric_manager % gK;
-          int fy = _fabric_manager / gK;
-          for (int k = 0; k < 8; ++k) {
-            int j = RandomInt(component.size() - 1);
-            int edge_rid = component[j];
-            while (is_edge_router[edge_rid] == false) {
-              j = RandomInt(component.size() - 1);
-              edge_rid = component[j];
-            }
-            int rx = edge_rid % gK;
-            int ry = edge_rid / gK;
-            int r = edge_rid;
-            vector<int> off_routers_on_path;
-            // x dimention
-            if (rx > fx) {
-              for (int d = 1; d <= rx - fx; ++d) {
-                --r;
-                if (_router_states[r] == false) off_routers_on_path.push_back(r);
-              }
-            } else {
-              for (int d = 1; d <= fx - rx; ++d) {
-                ++r;
-                if (_router_states[r] == false) off_routers_on_path.push_back(r);
-              }
-            }
-            assert(r % gK == fx);
-            // y dimension
-            if (ry > fy) {
-              for (int d = 1; d <= ry - fy; ++d) {
-                r = r - gK;
-                if (_router_states[r] == false) off_routers_on_path.push_back(r);
-              }
-            } else {
-              for (int d = 1; d <= fy - ry; ++d) {
-                r = r + gK;
-                if (_router_states[r] == false) off_routers_on_path.push_back(r);
-              }
-            }
-            assert(r == _fabric_manager);
-            if (off_routers_on_path.size() < num_off_routers_on_path) {
-              num_off_routers_on_path = off_routers_on_path.size();
-              connected_routers.clear();
-              connected_routers = off_routers_on_path;
-            }
-          }
-          for (unsigned i = 0; i < connected_routers.size(); ++i) {
-            int rid = connected_routers[i];
-            _router_states[rid] = true;
-          }
-        }
+      // a router is gated only when all of its cores are off
+      _router_states.assign(_size, false);
+      for (int c = 0; c < _nodes; ++c) {
+        if (_core_states[c])
+          _router_states[CoreRouter(c)] = true;
       }
+    } else if (_powergate_type == "rpa") {  // aggressive RP
+      _ParkRoutersAggressive(_router_states);
     } else if (_powergate_type == "rpc") {  // conservative RP
-      for (unsigned i = 0; i < _off_cores.size(); ++i) {
-        int cid = _off_cores[i];
-        int cx = cid % gK;
-        int cy = cid / gK;
-        bool neighbors_parked = false;
-        // direct neighbors
-        if (cx - 1 >= 0) {
-          int nid = cid - 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cx + 1 < gK) {
-          int nid = cid + 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cy - 1 >= 0) {
-          int nid = cid - gK;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cy + 1 < gK) {
-          int nid = cid + gK;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        // indirect neighbors (diagonal)
-        if (cx - 1 >= 0 && cy - 1 >= 0) {
-          int nid = cid - gK - 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cx - 1 >= 0 && cy + 1 < gK) {
-          int nid = cid + gK - 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cx + 1 < gK && cy - 1 >= 0) {
-          int nid = cid - gK + 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (cx + 1 < gK && cy + 1 < gK) {
-          int nid = cid + gK + 1;
-          if (_router_states[nid] == false) neighbors_parked = true;
-        }
-        if (neighbors_parked == false) {
-          _router_states[cid] = false;  // park the router
-        }
-      }
+      _ParkRoutersConservative(_router_states);
     } else if (_powergate_type != "no_pg") {
       ostringstream err;
       err << "Unknown power-gating type: " << _powergate_type << endl;
@@ -551,13 +382,276 @@ void Network::_Alloc( )
     _timed_modules.push_back(_chan_handshake[c]);
     /* ==== Power Gate - End ==== */
   }
+  _channel_modules = _timed_modules.size();
+}
+
+/* ==== Power Gate - Begin ==== */
+void Network::_ParkRoutersAggressive( vector<bool> & router_states )
+{
+  router_states = _core_states;
+  // initialize adjacent matrix
+  vector<vector<int> > adj_mat;
+  adj_mat.resize(_size);
+  for (int i = 0; i < _size; ++i) {
+    adj_mat[i].resize(_size, -1);
+
+    int ix = i % gK;
+    int iy = i / gK;
+    for (int j = 0; j < _size; ++j) {
+      if (router_states[i] == false || router_states[j] == false)
+        continue;
+
+      int jx = j % gK;
+      int jy = j / gK;
+
+      if (i == j) {
+        adj_mat[i][j] = 0;
+      } else if ( (abs(ix - jx) == 1 && iy == jy) ||
+          (abs(iy - jy) == 1 && ix == jx) ) {
+        adj_mat[i][j] = 1;
+      }
+    }
+  }
+#ifdef DEBUG_POWERGATE_CONFIG
+  cout << "Adjacent List: " << endl;
+  for (int i = 0; i < _size; ++i) {
+    cout << "\t" << i << ": ";
+    for (int j = 0; j < _size; ++j) {
+      if (adj_mat[i][j] > 0) cout << j << " ";
+    }
+    cout << endl;
+  }
+#endif
+  // measure network connectivity
+  vector<vector<int> > strong_cnctd_comps;
+  vector<int> new_component;
+  vector<bool> visited(_size, false);
+  for (int r = 0; r < _size; ++r) {
+    if (router_states[r] == false) continue;
+    if (visited[r] == true) continue;
+
+    deque<int> bfs_q;
+    bfs_q.push_back(r);
+    visited[r] = true;
+    new_component.clear();
+
+    while (!bfs_q.empty()) {
+      int n = bfs_q.front();
+      bfs_q.pop_front();
+      new_component.push_back(n);
+      for (int i = 0; i < _size; ++i) {
+        if (adj_mat[n][i] == 1 && visited[i] == false) {
+          visited[i] = true;
+          bfs_q.push_back(i);
+        }
+      }
+    }
+    sort(new_component.begin(), new_component.end());
+#ifdef DEBUG_POWERGATE_CONFIG
+    cout << "component " << strong_cnctd_comps.size() << ": ";
+    for (unsigned k = 0; k < new_component.size(); ++k) {
+      cout << new_component[k] << ", ";
+    }
+    cout << endl;
+#endif
+    strong_cnctd_comps.push_back(new_component);
+  }
+  if (strong_cnctd_comps.size() == 1) {
+#ifdef DEBUG_POWERGATE_CONFIG
+    cout << "network is connected" << endl;
+#endif
+  } else {
+#ifdef DEBUG_POWERGATE_CONFIG
+    cout << "network is disjoint with " << strong_cnctd_comps.size() << " partitions" << endl;
+#endif
+    vector<bool> is_edge_router(_size, false);
+    for (int rid = 0; rid < _size; ++rid) {
+      int num_neighbors = 0;
+      for (int j = 0; j < _size; ++j) {
+        if (adj_mat[rid][j] == 1)
+          ++num_neighbors;
+      }
+      if ( ((rid == 0 || rid == gK - 1 || rid == _size - 1 || rid == _size - gK) && num_neighbors < 2) ||
+          ((rid / gK == 0 || rid % gK == 0 || rid / gK == gK - 1 || rid % gK == gK - 1) && num_neighbors < 3) ||
+          ((rid / gK > 0 && rid % gK > 0 && rid / gK < gK - 1 && rid % gK < gK - 1) && num_neighbors < 4) )
+        is_edge_router[rid] = true;
+    }
+    for (unsigned i = 0; i < strong_cnctd_comps.size(); ++i) {
+      vector<int> component = strong_cnctd_comps[i];
+      if (find(component.begin(), component.end(), _fabric_manager) != component.end())
+        continue;
+
+      vector<int> connected_routers;
+      unsigned num_off_routers_on_path = _size;
+      int fx = _fabric_manager % gK;
+      int fy = _fabric_manager / gK;
+      for (int k = 0; k < 8; ++k) {
+        int j = _powergate_random.Int(component.size() - 1);
+        int edge_rid = component[j];
+        while (is_edge_router[edge_rid] == false) {
+          j = _powergate_random.Int(component.size() - 1);
+          edge_rid = component[j];
+        }
+        int rx = edge_rid % gK;
+        int ry = edge_rid / gK;
+        int r = edge_rid;
+        vector<int> off_routers_on_path;
+        // x dimention
+        if (rx > fx) {
+          for (int d = 1; d <= rx - fx; ++d) {
+            --r;
+            if (router_states[r] == false) off_routers_on_path.push_back(r);
+          }
+        } else {
+          for (int d = 1; d <= fx - rx; ++d) {
+            ++r;
+            if (router_states[r] == false) off_routers_on_path.push_back(r);
+          }
+        }
+        assert(r % gK == fx);
+        // y dimension
+        if (ry > fy) {
+          for (int d = 1; d <= ry - fy; ++d) {
+            r = r - gK;
+            if (router_states[r] == false) off_routers_on_path.push_back(r);
+          }
+        } else {
+          for (int d = 1; d <= fy - ry; ++d) {
+            r = r + gK;
+            if (router_states[r] == false) off_routers_on_path.push_back(r);
+          }
+        }
+        assert(r == _fabric_manager);
+        if (off_routers_on_path.size() < num_off_routers_on_path) {
+          num_off_routers_on_path = off_routers_on_path.size();
+          connected_routers.clear();
+          connected_routers = off_routers_on_path;
+        }
+      }
+      for (unsigned i = 0; i < connected_routers.size(); ++i) {
+        int rid = connected_routers[i];
+        router_states[rid] = true;
+      }
+    }
+  }
+}
+
+void Network::_ParkRoutersConservative( vector<bool> & router_states )
+{
+  router_states.assign(_size, true);
+  for (unsigned i = 0; i < _off_cores.size(); ++i) {
+    int cid = _off_cores[i];
+    int cx = cid % gK;
+    int cy = cid / gK;
+    bool neighbors_parked = false;
+    // direct neighbors
+    if (cx - 1 >= 0) {
+      int nid = cid - 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cx + 1 < gK) {
+      int nid = cid + 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cy - 1 >= 0) {
+      int nid = cid - gK;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cy + 1 < gK) {
+      int nid = cid + gK;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    // indirect neighbors (diagonal)
+    if (cx - 1 >= 0 && cy - 1 >= 0) {
+      int nid = cid - gK - 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cx - 1 >= 0 && cy + 1 < gK) {
+      int nid = cid + gK - 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cx + 1 < gK && cy - 1 >= 0) {
+      int nid = cid - gK + 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (cx + 1 < gK && cy + 1 < gK) {
+      int nid = cid + gK + 1;
+      if (router_states[nid] == false) neighbors_parked = true;
+    }
+    if (neighbors_parked == false) {
+      router_states[cid] = false;  // park the router
+    }
+  }
+}
+
+vector<bool> Network::RouterParkingStates( const string & type )
+{
+  vector<bool> router_states;
+
+  // the path selection of aggressive parking draws random numbers, use a
+  // private stream with a fixed seed for a reproducible map, the traffic
+  // keeps drawing from the generator untouched
+  _powergate_random.KeyPrivate(RandomStream::power_gate, 1, _powergate_seed);
+  if (type == "rpa") {
+    _ParkRoutersAggressive(router_states);
+  } else if (type == "rpc") {
+    _ParkRoutersConservative(router_states);
+  } else {
+    ostringstream err;
+    err << "Unknown router parking type: " << type << endl;
+    Error(err.str());
+  }
+
+  return router_states;
+}
+/* ==== Power Gate - End ==== */
+
+// every module starts out due at the current cycle, channel latencies
+// bound how far ahead the modules wake each other
+void Network::EnableEventKernel( )
+{
+  int horizon = 1;
+  for ( int s = 0; s < _nodes; ++s ) {
+    horizon = max( horizon, _inject[s]->GetLatency( ) );
+    horizon = max( horizon, _inject_cred[s]->GetLatency( ) );
+    horizon = max( horizon, _eject[s]->GetLatency( ) );
+    horizon = max( horizon, _eject_cred[s]->GetLatency( ) );
+  }
+  for ( int c = 0; c < _channels; ++c ) {
+    horizon = max( horizon, _chan[c]->GetLatency( ) );
+    horizon = max( horizon, _chan_cred[c]->GetLatency( ) );
+  }
+  delete _event_wheel;
+  _event_wheel = new EventWheel( _timed_modules, _channel_modules,
+                                 horizon + 1, GetSimTime( ) );
+}
+
+int Network::NextEventTime( ) const
+{
+  return _event_wheel ? _event_wheel->NextTime( ) : GetSimTime( ) + 1;
 }
 
 void Network::ReadInputs( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
+  if ( _event_wheel ) {
+    vector<TimedModule *> const & due = _event_wheel->Advance( GetSimTime( ) );
+    ProfileScope profile(_channel_profile_owner, Profiler::read_inputs);
+    for ( size_t i = 0; i < due.size( ); ++i ) {
+      if ( (int)i == _event_wheel->DueChannels( ) ) {
+        profile.Start(_router_profile_owner, Profiler::read_inputs);
+      }
+      due[i]->ReadInputs( );
+    }
+    return;
+  }
+  deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+  deque<TimedModule *>::const_iterator const routers = iter + _channel_modules;
+  ProfileScope profile(_channel_profile_owner, Profiler::read_inputs);
+  for( ; iter != routers; ++iter) {
+    (*iter)->ReadInputs( );
+  }
+  profile.Start(_router_profile_owner, Profiler::read_inputs);
+  for( ; iter != _timed_modules.end(); ++iter) {
     (*iter)->ReadInputs( );
   }
 }
@@ -565,6 +659,7 @@ void Network::ReadInputs( )
 /* ==== Power Gate - Begin ==== */
 void Network::PowerStateEvaluate( )
 {
+  PROFILE_SCOPE(_router_profile_owner, power_state);
   for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
       iter != _timed_modules.end();
       ++iter) {
@@ -575,18 +670,49 @@ void Network::PowerStateEvaluate( )
 
 void Network::Evaluate( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
+  if ( _event_wheel ) {
+    vector<TimedModule *> const & due = _event_wheel->Due( );
+    PROFILE_SCOPE(_router_profile_owner, evaluate);
+    // channels have nothing to evaluate
+    for ( size_t i = _event_wheel->DueChannels( ); i < due.size( ); ++i ) {
+      due[i]->Evaluate( );
+    }
+    return;
+  }
+  deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+  deque<TimedModule *>::const_iterator const routers = iter + _channel_modules;
+  ProfileScope profile(_channel_profile_owner, Profiler::evaluate);
+  for( ; iter != routers; ++iter) {
+    (*iter)->Evaluate( );
+  }
+  profile.Start(_router_profile_owner, Profiler::evaluate);
+  for( ; iter != _timed_modules.end(); ++iter) {
     (*iter)->Evaluate( );
   }
 }
 
 void Network::WriteOutputs( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
+  if ( _event_wheel ) {
+    vector<TimedModule *> const & due = _event_wheel->Due( );
+    ProfileScope profile(_channel_profile_owner, Profiler::write_outputs);
+    for ( size_t i = 0; i < due.size( ); ++i ) {
+      if ( (int)i == _event_wheel->DueChannels( ) ) {
+        profile.Start(_router_profile_owner, Profiler::write_outputs);
+      }
+      due[i]->WriteOutputs( );
+    }
+    _event_wheel->Reschedule( );
+    return;
+  }
+  deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
+  deque<TimedModule *>::const_iterator const routers = iter + _channel_modules;
+  ProfileScope profile(_channel_profile_owner, Profiler::write_outputs);
+  for( ; iter != routers; ++iter) {
+    (*iter)->WriteOutputs( );
+  }
+  profile.Start(_router_profile_owner, Profiler::write_outputs);
+  for( ; iter != _timed_modules.end(); ++iter) {
     (*iter)->WriteOutputs( );
   }
 }
@@ -44,6 +44,10 @@
 #include "channel.hpp"
 #include "config_utils.hpp"
 #include "globals.hpp"
+#include "profiler.hpp"
+#include "random_utils.hpp"
+
+class MeshKernel;
 
 /* ==== DSENT power model - Begin ==== */
 class netEnergyStats {
@@ -120,6 +124,7 @@ protected:
   int _fabric_manager;  // RP
   bool _powergate_auto_config;
   int _powergate_seed;
+  RandomStream _powergate_random;
   int _powergate_percentile;
   string _powergate_type;
   vector<bool> _core_states;
@@ -130,12 +135,25 @@ protected:
   /* ==== Power Gate - End ==== */
 
   deque<TimedModule *> _timed_modules;
+  // channels come first in _timed_modules, the routers follow
+  int _channel_modules;
+  int _channel_profile_owner;
+  int _router_profile_owner;
+  // event kernel, NULL when every module is evaluated every cycle
+  EventWheel * _event_wheel;
+  // allocation kernel of a baseline mesh, NULL for other configurations
+  MeshKernel * _mesh_kernel;
 
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
   void _Alloc( );
 
+  /* ==== Power Gate - Begin ==== */
+  void _ParkRoutersAggressive( vector<bool> & router_states );
+  void _ParkRoutersConservative( vector<bool> & router_states );
+  /* ==== Power Gate - End ==== */
+
 public:
   Network( const Configuration &config, const string & name );
   virtual ~Network( );
@@ -162,6 +180,12 @@ public:
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // evaluate only the modules with work in a cycle (event_kernel = 1)
+  void EnableEventKernel( );
+  virtual int NextEventTime( ) const;
+
+  inline MeshKernel * GetMeshKernel( ) const { return _mesh_kernel; }
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
@@ -189,6 +213,10 @@ public:
   /* ==== Power Gate - Begin ==== */
   vector<bool> & GetCoreStates(){return _core_states;}
   vector<bool> & GetRouterStates(){return _router_states;}
+  inline int GetFabricManager() const {return _fabric_manager;}
+  // router a core is attached to, concentrated networks override it
+  virtual int CoreRouter( int core ) const {return core;}
+  vector<bool> RouterParkingStates( const string & type );
   /* ==== Power Gate - End ==== */
 };
 
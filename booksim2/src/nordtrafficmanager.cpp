@@ -161,7 +161,7 @@ void NoRDTrafficManager::_GeneratePacket( int source, int stype,
     /* ==== Power Gate - End ==== */
 
     Flit::FlitType packet_type = Flit::ANY_TYPE;
-    int size = _GetNextPacketSize(cl); //input size
+    int size = _GetNextPacketSize(cl, source); //input size
     int pid = _cur_pid++;
     assert(_cur_pid);
     int packet_destination = _traffic_pattern[cl]->dest(source);
@@ -223,7 +223,7 @@ void NoRDTrafficManager::_GeneratePacket( int source, int stype,
     }
 
     int subnetwork = ((packet_type == Flit::ANY_TYPE) ?
-                      RandomInt(_subnets-1) :
+                      _packet_random[cl * _nodes + source].Int(_subnets-1) :
                       _subnet[packet_type]);
 
     if ( watch ) {
@@ -346,6 +346,10 @@ void NoRDTrafficManager::_Inject()
 
 void NoRDTrafficManager::_Step( )
 {
+  PROFILE_SCOPE(_profile_owner, step);
+  ProfileScope profile;
+  _ProfilePhase();
+
   bool flits_in_flight = false;
   for(int c = 0; c < _classes; ++c) {
     flits_in_flight |= !_total_in_flight_flits[c].empty();
@@ -401,6 +405,7 @@ void NoRDTrafficManager::_Step( )
 
   vector<map<int, Flit *> > flits(_subnets);
 
+  profile.Start(_profile_owner, Profiler::eject);
   for ( int subnet = 0; subnet < _subnets; ++subnet ) {
     for ( int n = 0; n < _nodes; ++n ) {
       Flit * const f = _net[subnet]->ReadFlit( n );
@@ -451,6 +456,7 @@ void NoRDTrafficManager::_Step( )
     _net[subnet]->ReadInputs( );
   }
 
+  profile.Start(_profile_owner, Profiler::inject);
   if ( !_empty_network ) {
     _Inject();
   }
@@ -881,6 +887,7 @@ void NoRDTrafficManager::_Step( )
     }
   }
 
+  profile.Start(_profile_owner, Profiler::retire);
   for(int subnet = 0; subnet < _subnets; ++subnet) {
     for(int n = 0; n < _nodes; ++n) {
       map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
@@ -947,8 +954,13 @@ void NoRDTrafficManager::_Step( )
     _net[subnet]->WriteOutputs( );
   }
 
+  profile.Stop();
+
   ++_time;
   assert(_time);
+  /* ==== DSENT power model - Begin ==== */
+  _PowerTraceStep();
+  /* ==== DSENT power model - End ==== */
   if(gTrace){
     cout<<"TIME "<<_time<<endl;
   }
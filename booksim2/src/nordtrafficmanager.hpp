@@ -41,6 +41,9 @@ protected:
 
   virtual void _GeneratePacket( int source, int size, int cl, int time );
 
+  // the power-state machines keep running while fast-forwarding
+  virtual void _FastForwardStep( ) { _Step( ); }
+
 public:
 
   NoRDTrafficManager( const Configuration &config, const vector<Network *> & net );
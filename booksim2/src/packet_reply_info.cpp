@@ -26,32 +26,33 @@
 */
 
 #include "packet_reply_info.hpp"
-
-stack<PacketReplyInfo*> PacketReplyInfo::_all;
-stack<PacketReplyInfo*> PacketReplyInfo::_free;
+#include "globals.hpp"
 
 PacketReplyInfo * PacketReplyInfo::New()
 {
+  stack<PacketReplyInfo *> & free_list = gSimContext->free_reply_infos;
   PacketReplyInfo * pr;
-  if(_free.empty()) {
+  if(free_list.empty()) {
     pr = new PacketReplyInfo();
-    _all.push(pr);
+    gSimContext->reply_infos.push(pr);
   } else {
-    pr = _free.top();
-    _free.pop();
+    pr = free_list.top();
+    free_list.pop();
   }
   return pr;
 }
 
 void PacketReplyInfo::Free()
 {
-  _free.push(this);
+  gSimContext->free_reply_infos.push(this);
 }
 
 void PacketReplyInfo::FreeAll()
 {
-  while(!_all.empty()) {
-    delete _all.top();
-    _all.pop();
+  stack<PacketReplyInfo *> & all = gSimContext->reply_infos;
+  while(!all.empty()) {
+    delete all.top();
+    all.pop();
   }
+  gSimContext->free_reply_infos = stack<PacketReplyInfo *>();
 }
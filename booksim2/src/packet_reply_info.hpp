@@ -47,8 +47,6 @@ public:
 
 private:
 
-  static stack<PacketReplyInfo*> _all;
-  static stack<PacketReplyInfo*> _free;
 
   PacketReplyInfo() {}
   ~PacketReplyInfo() {}
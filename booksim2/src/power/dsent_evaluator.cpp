@@ -0,0 +1,237 @@
+/*
+ * dsent_evaluator.cpp
+ * - Evaluate DSENT router/link energy parameters at startup, with an
+ *   on-disk cache keyed by a hash of the microarchitecture parameters
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dsent_evaluator.hpp"
+
+#ifdef BOOKSIM_DSENT
+#include "DSENT.h"
+#endif
+
+// DSENT result names, same as the fields of the DSENT power model
+static const char *const DSENT_ROUTER_QUERIES[][2] = {
+    {"energy_per_buffwrite", "Energy>>Router:WriteBuffer"},
+    {"energy_per_buffread", "Energy>>Router:ReadBuffer"},
+    {"energy_traverse_xbar", "Energy>>Router:TraverseCrossbar->Multicast1"},
+    {"energy_per_arbitratestage1",
+     "Energy>>Router:ArbitrateSwitch->ArbitrateStage1"},
+    {"energy_per_arbitratestage2",
+     "Energy>>Router:ArbitrateSwitch->ArbitrateStage2"},
+    {"energy_distribute_clk", "Energy>>Router:DistributeClock"},
+    {"input_leak", "NddPower>>Router->InputPort:Leakage"},
+    {"switch_leak", "NddPower>>Router->SwitchAllocator:Leakage"},
+    {"xbar_leak", "NddPower>>Router->Crossbar:Leakage"},
+    {"xbar_sel_dff_leak", "NddPower>>Router->Crossbar_Sel_DFF:Leakage"},
+    {"clk_tree_leak", "NddPower>>Router->ClockTree:Leakage"},
+    {"pipeline_reg0_leak", "NddPower>>Router->PipelineReg0:Leakage"},
+    {"pipeline_reg1_leak", "NddPower>>Router->PipelineReg1:Leakage"},
+    {"pipeline_reg2_part_leak", "NddPower>>Router->PipelineReg2_0:Leakage"}};
+static const int DSENT_NUM_ROUTER_QUERIES =
+    sizeof(DSENT_ROUTER_QUERIES) / sizeof(DSENT_ROUTER_QUERIES[0]);
+
+DSENT_Evaluator::DSENT_Evaluator(const Configuration &config)
+    : Module(0, "dsent_evaluator") {
+  num_ports = config.GetInt("dsent_router_ports");
+  if (num_ports <= 0) {
+    string topology = config.GetStr("topology");
+    if (topology == "mesh" || topology == "torus") {
+      num_ports = 2 * config.GetInt("n") + 1;
+    } else if (topology == "cmesh") {
+      num_ports = 4 + config.GetInt("c");
+    } else {
+      cerr << "Error: dsent_router_ports must be set for topology "
+           << topology << endl;
+      exit(-1);
+    }
+  }
+  channel_width = config.GetInt("channel_width");
+  num_vcs = config.GetInt("num_vcs");
+  vc_buf_size = config.GetInt("vc_buf_size");
+  frequency = config.GetFloat("frequency");
+  rr_link_length = config.GetFloat("dsent_rr_link_length");
+  rs_link_length = config.GetFloat("dsent_rs_link_length");
+  tech_model = config.GetStr("dsent_tech_model");
+  cache_dir = config.GetStr("dsent_cache_dir");
+}
+
+DSENT_Evaluator::~DSENT_Evaluator() {}
+
+// everything DSENT sees, the cache is reused only for identical inputs
+string DSENT_Evaluator::CacheKey() const {
+  ostringstream key;
+  key << "router ports=" << num_ports << " flit=" << channel_width
+      << " vcs=" << num_vcs << " bufs=" << vc_buf_size
+      << " freq=" << frequency << " rr_link=" << rr_link_length
+      << " rs_link=" << rs_link_length << " tech=" << tech_model;
+  return key.str();
+}
+
+string DSENT_Evaluator::CacheFile() const {
+  // 64-bit FNV-1a
+  unsigned long long hash = 14695981039346656037ULL;
+  string key = CacheKey();
+  for (size_t i = 0; i < key.size(); ++i) {
+    hash ^= (unsigned char)key[i];
+    hash *= 1099511628211ULL;
+  }
+  ostringstream file;
+  file << cache_dir << "/dsent_" << hex << hash << ".cfg";
+  return file.str();
+}
+
+bool DSENT_Evaluator::ReadCache(const string &file,
+                                map<string, double> &params) const {
+  ifstream in(file.c_str());
+  if (!in) return false;
+
+  string line;
+  getline(in, line);
+  // first line records the key, guards against hash collisions
+  if (line != "// " + CacheKey()) return false;
+  while (getline(in, line)) {
+    char name[64];
+    double value;
+    if (sscanf(line.c_str(), "%63s = %lf;", name, &value) == 2) {
+      params[name] = value;
+    }
+  }
+  return params.size() == (size_t)DSENT_NUM_ROUTER_QUERIES + 4;
+}
+
+void DSENT_Evaluator::WriteCache(const string &file,
+                                 const map<string, double> &params) const {
+  mkdir(cache_dir.c_str(), 0755);
+  // write to a temporary file so concurrent sweeps never read a partial one
+  ostringstream tmp_file;
+  tmp_file << file << "." << getpid();
+  ofstream out(tmp_file.str().c_str());
+  if (!out) {
+    cerr << "Warning: cannot write DSENT cache " << file << endl;
+    return;
+  }
+  out.precision(12);
+  out << "// " << CacheKey() << endl;
+  for (map<string, double>::const_iterator iter = params.begin();
+       iter != params.end(); ++iter) {
+    out << iter->first << " = " << iter->second << ";" << endl;
+  }
+  out.close();
+  rename(tmp_file.str().c_str(), file.c_str());
+}
+
+#ifdef BOOKSIM_DSENT
+// build one DSENT model from a generated config file and evaluate queries
+static void RunDSENT(const string &cfg_file, const string &cfg,
+                     map<string, double> &outputs) {
+  ofstream out(cfg_file.c_str());
+  out << cfg;
+  out.close();
+
+  map<LibUtil::String, LibUtil::String> params;
+  DSENT::Model *model = DSENT::initialize(cfg_file.c_str(), params);
+  DSENT::run(params, model, outputs);
+  DSENT::finalize(params, model);
+  remove(cfg_file.c_str());
+}
+#endif
+
+void DSENT_Evaluator::Evaluate(map<string, double> &params) const {
+#ifdef BOOKSIM_DSENT
+  ostringstream cfg_file;
+  cfg_file << cache_dir << "/dsent_input." << getpid();
+  mkdir(cache_dir.c_str(), 0755);
+
+  // router, same microarchitecture as booksim2/utils/dsent_models.cfg
+  ostringstream router;
+  router << "ModelName = Router" << endl
+         << "ElectricalTechModelFilename = " << tech_model << endl
+         << "IsPerformTimingOptimization = true" << endl
+         << "TimingOptimization->StartNetNames = [*]" << endl
+         << "Frequency = " << frequency << endl
+         << "NumberInputPorts = " << num_ports << endl
+         << "NumberOutputPorts = " << num_ports << endl
+         << "NumberBitsPerFlit = " << channel_width << endl
+         << "NumberVirtualNetworks = 1" << endl
+         << "NumberVirtualChannelsPerVirtualNetwork = [" << num_vcs << "]"
+         << endl
+         << "NumberBuffersPerVirtualChannel = [" << vc_buf_size << "]" << endl
+         << "InputPort->BufferModel = DFFRAM" << endl
+         << "CrossbarModel = MultiplexerCrossbar" << endl
+         << "SwitchAllocator->ArbiterModel = MatrixArbiter" << endl
+         << "ClockTreeModel = BroadcastHTree" << endl
+         << "ClockTree->NumberLevels = 5" << endl
+         << "ClockTree->WireLayer = Global" << endl
+         << "ClockTree->WireWidthMultiplier = 1.0" << endl
+         << "EvaluateString = ";
+  for (int i = 0; i < DSENT_NUM_ROUTER_QUERIES; ++i) {
+    router << "print \"" << DSENT_ROUTER_QUERIES[i][0] << "\" $("
+           << DSENT_ROUTER_QUERIES[i][1] << "); ";
+  }
+  router << endl;
+  map<string, double> outputs;
+  RunDSENT(cfg_file.str(), router.str(), outputs);
+  for (int i = 0; i < DSENT_NUM_ROUTER_QUERIES; ++i) {
+    params[DSENT_ROUTER_QUERIES[i][0]] = outputs[DSENT_ROUTER_QUERIES[i][0]];
+  }
+  // the query returns one select flop, the router has log2(ports) per output
+  int num_selects = 0;
+  while ((1 << num_selects) < num_ports) ++num_selects;
+  params["xbar_sel_dff_leak"] *= num_ports * num_selects;
+
+  // router-to-router and router-to-site links
+  const double lengths[2] = {rr_link_length, rs_link_length};
+  const char *const prefixes[2] = {"rr", "rs"};
+  for (int l = 0; l < 2; ++l) {
+    ostringstream link;
+    link << "ModelName = RepeatedLink" << endl
+         << "ElectricalTechModelFilename = " << tech_model << endl
+         << "IsPerformTimingOptimization = false" << endl
+         << "TimingOptimization->StartNetNames = []" << endl
+         << "Frequency = " << frequency << endl
+         << "NumberBits = " << channel_width << endl
+         << "WireLayer = Global" << endl
+         << "WireWidthMultiplier = 1.0" << endl
+         << "WireSpacingMultiplier = 1.0" << endl
+         << "WireLength = " << lengths[l] << endl
+         << "Delay = " << 1.0 / frequency << endl
+         << "EvaluateString = print \"energy\" $(Energy>>RepeatedLink:Send); "
+         << "print \"leak\" $(NddPower>>RepeatedLink:Leakage);" << endl;
+    outputs.clear();
+    RunDSENT(cfg_file.str(), link.str(), outputs);
+    params[string("energy_") + prefixes[l] + "_link_traversal"] =
+        outputs["energy"];
+    params[string(prefixes[l]) + "_link_leak"] = outputs["leak"];
+  }
+#else
+  // runs before the simulation exists, so Module::Error is not available
+  cerr << "Error: no cached DSENT results for \"" << CacheKey()
+       << "\" and booksim was built without DSENT (make DSENT=1)" << endl;
+  exit(-1);
+#endif
+}
+
+void DSENT_Evaluator::run(Configuration &config) {
+  string file = CacheFile();
+  map<string, double> params;
+  if (ReadCache(file, params)) {
+    cout << "DSENT parameters loaded from " << file << endl;
+  } else {
+    params.clear();
+    Evaluate(params);
+    WriteCache(file, params);
+    cout << "DSENT parameters evaluated and cached in " << file << endl;
+  }
+
+  for (map<string, double>::const_iterator iter = params.begin();
+       iter != params.end(); ++iter) {
+    config.Assign(iter->first, iter->second);
+  }
+}
@@ -0,0 +1,44 @@
+/*
+ * dsent_evaluator.hpp
+ * - Evaluate DSENT router/link energy parameters at startup, with an
+ *   on-disk cache keyed by a hash of the microarchitecture parameters
+ */
+
+#ifndef _DSENT_EVALUATOR_HPP_
+#define _DSENT_EVALUATOR_HPP_
+
+#include <map>
+#include <string>
+
+#include "config_utils.hpp"
+#include "module.hpp"
+
+class DSENT_Evaluator : public Module {
+ protected:
+  // router microarchitecture
+  int num_ports;
+  int channel_width;
+  int num_vcs;
+  int vc_buf_size;
+  double frequency;
+  // links, lengths in meters
+  double rr_link_length;
+  double rs_link_length;
+
+  string tech_model;
+  string cache_dir;
+
+  string CacheKey() const;
+  string CacheFile() const;
+  bool ReadCache(const string &file, map<string, double> &params) const;
+  void WriteCache(const string &file, const map<string, double> &params) const;
+  void Evaluate(map<string, double> &params) const;
+
+ public:
+  DSENT_Evaluator(const Configuration &config);
+  ~DSENT_Evaluator();
+
+  // fill the DSENT power model energy/leakage parameters in config
+  void run(Configuration &config);
+};
+#endif
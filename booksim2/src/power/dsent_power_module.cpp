@@ -36,10 +36,142 @@ DSENT_Power_Module::DSENT_Power_Module(Network *n, const Configuration &config)
   rs_link_leak = config.GetFloat("rs_link_leak");
 
   frequency = config.GetFloat("frequency");
+
+  trace_last_time = 0;
+  trace_energy = 0;
+  trace_last_link_energy = 0;
+  trace_last_router_energy.resize(net->NumRouters(), 0);
+  trace_last_power_off_cycles.resize(net->NumRouters(), 0);
+  trace_last_pg_overhead_cycles.resize(net->NumRouters(), 0);
 }
 
 DSENT_Power_Module::~DSENT_Power_Module() {}
 
+double DSENT_Power_Module::LinkDynamicEnergy() const {
+  double energy = 0;
+
+  vector<FlitChannel *> inject = net->GetInject();
+  vector<FlitChannel *> eject = net->GetEject();
+  for (int i = 0; i < net->NumNodes(); ++i) {
+    const vector<int> temp_inject = inject[i]->GetActivity();
+    const vector<int> temp_eject = eject[i]->GetActivity();
+    for (int j = 0; j < classes; ++j) {
+      energy += ((double)temp_inject[j] + (double)temp_eject[j]) *
+                energy_rs_link_traversal;
+    }
+  }
+
+  vector<FlitChannel *> chan = net->GetChannels();
+  for (int i = 0; i < net->NumChannels(); ++i) {
+    const vector<int> temp = chan[i]->GetActivity();
+    for (int j = 0; j < classes; ++j) {
+      energy += (double)temp[j] * energy_rr_link_traversal;
+    }
+  }
+  return energy;
+}
+
+double DSENT_Power_Module::RouterDynamicEnergy(const Router *router) const {
+  double energy = 0;
+  const IQRouter *temp = dynamic_cast<const IQRouter *>(router);
+
+  const BufferMonitor *bm = temp->GetBufferMonitor();
+  const vector<int> reads = bm->GetReads();
+  const vector<int> writes = bm->GetWrites();
+  for (int i = 0; i < bm->NumInputs() * classes; ++i) {
+    energy += (double)reads[i] * energy_per_buffread +
+              (double)writes[i] * energy_per_buffwrite;
+  }
+
+  const SwitchMonitor *sm = temp->GetSwitchMonitor();
+  const vector<int> activity = sm->GetActivity();
+  for (int i = 0; i < sm->NumOutputs() * sm->NumInputs() * classes; ++i) {
+    energy += (double)activity[i] *
+              (energy_per_arbitratestage1 + energy_per_arbitratestage2 +
+               energy_traverse_xbar);
+  }
+  return energy;
+}
+
+void DSENT_Power_Module::TraceHeader(ostream &os) const {
+  os << "# " << net->Name() << ": cycle network_power";
+  for (int r = 0; r < net->NumRouters(); ++r) {
+    os << " router_" << r;
+  }
+  os << endl;
+}
+
+void DSENT_Power_Module::TraceStart() {
+  trace_last_time = 0;
+  trace_energy = 0;
+  trace_last_link_energy = LinkDynamicEnergy();
+  vector<Router *> routers = net->GetRouters();
+  for (size_t r = 0; r < routers.size(); ++r) {
+    const IQRouter *temp = dynamic_cast<IQRouter *>(routers[r]);
+    trace_last_router_energy[r] = RouterDynamicEnergy(temp);
+    trace_last_power_off_cycles[r] = temp->GetPowerOffCycles();
+    trace_last_pg_overhead_cycles[r] = temp->GetPowerGateOverheadCycles();
+  }
+}
+
+void DSENT_Power_Module::TraceStep(ostream &os) {
+  int now = GetSimTime();
+  int cycles = now - trace_last_time;
+  if (cycles <= 0) return;
+  double interval = cycles / frequency;
+
+  // links are accounted to the network only
+  double link_energy = LinkDynamicEnergy();
+  double net_energy = link_energy - trace_last_link_energy;
+  net_energy += (2 * net->NumNodes() * rs_link_leak +
+                 net->NumChannels() * rr_link_leak) *
+                interval;
+  trace_last_link_energy = link_energy;
+
+  vector<double> router_power(net->NumRouters(), 0);
+  vector<Router *> routers = net->GetRouters();
+  for (size_t r = 0; r < routers.size(); ++r) {
+    const IQRouter *temp = dynamic_cast<IQRouter *>(routers[r]);
+
+    double dynamic_energy = RouterDynamicEnergy(temp);
+    double energy = dynamic_energy - trace_last_router_energy[r];
+    trace_last_router_energy[r] = dynamic_energy;
+
+    uint64_t power_off_cycles = temp->GetPowerOffCycles();
+    double on_interval =
+        (cycles - (double)(power_off_cycles - trace_last_power_off_cycles[r])) /
+        frequency;
+    trace_last_power_off_cycles[r] = power_off_cycles;
+    double pg_overhead_cycles = temp->GetPowerGateOverheadCycles();
+    double pg_cycles = pg_overhead_cycles - trace_last_pg_overhead_cycles[r];
+    trace_last_pg_overhead_cycles[r] = pg_overhead_cycles;
+
+    // same leakage and power-gating overhead terms as run()
+    double input_leakage =
+        input_leak + (pipeline_reg0_leak + pipeline_reg1_leak) * channel_width;
+    int num_inputs = temp->GetBufferMonitor()->NumInputs();
+    int num_outputs = temp->GetSwitchMonitor()->NumOutputs();
+    energy += num_inputs * input_leakage * on_interval;
+    energy += num_inputs * input_leakage * pg_cycles / frequency;
+    energy += (switch_leak + xbar_leak + xbar_sel_dff_leak +
+               num_outputs * pipeline_reg2_part_leak * channel_width) *
+              on_interval;
+    energy += energy_distribute_clk * cycles + clk_tree_leak * interval;
+
+    router_power[r] = energy / interval;
+    net_energy += energy;
+  }
+
+  trace_energy += net_energy;
+  trace_last_time = now;
+
+  os << now << " " << net_energy / interval;
+  for (size_t r = 0; r < router_power.size(); ++r) {
+    os << " " << router_power[r];
+  }
+  os << endl;
+}
+
 void DSENT_Power_Module::run() {
   // link power
   double link_dynamic_energy = 0;
@@ -49,10 +49,32 @@ class DSENT_Power_Module : public Module {
   // freq
   double frequency;
 
+  // power trace: cumulative values at the previous sample
+  int trace_last_time;
+  double trace_energy;
+  double trace_last_link_energy;
+  vector<double> trace_last_router_energy;
+  vector<uint64_t> trace_last_power_off_cycles;
+  vector<double> trace_last_pg_overhead_cycles;
+
+  double LinkDynamicEnergy() const;
+  double RouterDynamicEnergy(const Router *router) const;
+
  public:
   DSENT_Power_Module(Network *net, const Configuration &config);
   ~DSENT_Power_Module();
 
   void run();
+
+  // restart the trace at cycle 0 of a new run, activity counters keep
+  // counting across runs so the current values become the baseline
+  void TraceStart();
+  // integrate energy from activity deltas since the previous sample and
+  // write one line of per-network and per-router average power
+  void TraceStep(ostream &os);
+  void TraceHeader(ostream &os) const;
+  inline double GetTraceEnergy() const { return trace_energy; }
+  inline int GetTraceTime() const { return trace_last_time; }
+  inline double GetFrequency() const { return frequency; }
 };
 #endif
@@ -0,0 +1,219 @@
+/*
+ * power_gating_policy.cpp
+ * - Per-router FLOV power-gating decision engines behind the adaptive
+ *   voting hook: latency watermarks and table-based Q-learning
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "power_gating_policy.hpp"
+
+PowerGatingPolicy::PowerGatingPolicy(const Configuration &config,
+                                     Module *parent, const string &name)
+    : Module(parent, name) {
+  double zeroload_latency = config.GetFloat("zeroload_latency");
+  _plat_low_watermark = zeroload_latency * config.GetFloat("low_watermark");
+  _plat_high_watermark = zeroload_latency * config.GetFloat("high_watermark");
+}
+
+PowerGatingPolicy *PowerGatingPolicy::New(const Configuration &config,
+                                          Module *parent, const string &name,
+                                          int routers) {
+  string policy = config.GetStr("flov_pg_policy");
+  if (policy == "watermark") {
+    return new WatermarkPowerGatingPolicy(config, parent, name);
+  } else if (policy == "qlearn") {
+    return new QLearningPowerGatingPolicy(config, parent, name, routers);
+  }
+  cerr << "Error: unknown FLOV power-gating policy " << policy << endl;
+  exit(-1);
+}
+
+WatermarkPowerGatingPolicy::WatermarkPowerGatingPolicy(
+    const Configuration &config, Module *parent, const string &name)
+    : PowerGatingPolicy(config, parent, name) {}
+
+int WatermarkPowerGatingPolicy::Vote(int router, const PGObservation &obs) {
+  if (obs.plat < 0.0) return 0;
+  if (obs.plat < _plat_low_watermark) return 1;
+  if (obs.plat > _plat_high_watermark) return -1;
+  return 0;
+}
+
+QLearningPowerGatingPolicy::QLearningPowerGatingPolicy(
+    const Configuration &config, Module *parent, const string &name,
+    int routers)
+    : PowerGatingPolicy(config, parent, name),
+      _decisions(0),
+      _explorations(0),
+      _updates(0),
+      _reward_sum(0.0) {
+  _alpha = config.GetFloat("flov_rl_alpha");
+  _gamma = config.GetFloat("flov_rl_gamma");
+  _epsilon = config.GetFloat("flov_rl_epsilon");
+  _latency_weight = config.GetFloat("flov_rl_latency_weight");
+  _leakage_weight = config.GetFloat("flov_rl_leakage_weight");
+  _zeroload_latency = config.GetFloat("zeroload_latency");
+  _train = (config.GetInt("flov_rl_train") > 0);
+  _qtable_file = config.GetStr("flov_rl_qtable");
+  // own generator, exploration never perturbs the traffic random stream
+  _rng_state = 0x9E3779B97F4A7C15ULL * (config.GetInt("flov_rl_seed") + 1);
+
+  _q.resize(_num_states * _num_actions, 0.0);
+  _last_state.resize(routers, -1);
+  _last_action.resize(routers, -1);
+  _actions.resize(_num_actions, 0);
+
+  // runs before the simulation exists, so Module::Error is not available
+  if (!_Load() && !_train) {
+    cerr << "Error: flov_rl_train = 0 needs a Q-table in flov_rl_qtable"
+         << endl;
+    exit(-1);
+  }
+}
+
+QLearningPowerGatingPolicy::~QLearningPowerGatingPolicy() {
+  if (_train) _Save();
+}
+
+// latency against the watermarks, buffer occupancy, idleness, gated
+// neighbors and the current FLOV mode
+int QLearningPowerGatingPolicy::_State(const PGObservation &obs) const {
+  int plat = 0;
+  if (obs.plat >= _plat_low_watermark) {
+    if (obs.plat < _plat_high_watermark) {
+      plat = 1;
+    } else if (obs.plat < 2.0 * _plat_high_watermark) {
+      plat = 2;
+    } else {
+      plat = 3;
+    }
+  }
+  int occupancy = obs.occupancy <= 0.0 ? 0 : (obs.occupancy < 0.25 ? 1 : 2);
+  int idle = obs.idle < 0.5 ? 0 : (obs.idle < 0.9 ? 1 : 2);
+  int neighbors = obs.neighbors_off < 2 ? obs.neighbors_off : 2;
+  return (((plat * 3 + occupancy) * 3 + idle) * 3 + neighbors) * 3 +
+         obs.level;
+}
+
+double QLearningPowerGatingPolicy::_Reward(const PGObservation &obs) const {
+  double plat = obs.plat < 0.0 ? 0.0 : obs.plat / _zeroload_latency;
+  return -(_latency_weight * plat + _leakage_weight * obs.on);
+}
+
+// splitmix64
+double QLearningPowerGatingPolicy::_Random() {
+  unsigned long long z = (_rng_state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int QLearningPowerGatingPolicy::Vote(int router, const PGObservation &obs) {
+  int const state = _State(obs);
+
+  // the reward of the last action is what this epoch looked like
+  int const last_state = _last_state[router];
+  if (_train && last_state >= 0) {
+    double const reward = _Reward(obs);
+    double best = _q[state * _num_actions];
+    for (int a = 1; a < _num_actions; ++a) {
+      if (_q[state * _num_actions + a] > best)
+        best = _q[state * _num_actions + a];
+    }
+    double &q = _q[last_state * _num_actions + _last_action[router]];
+    q += _alpha * (reward + _gamma * best - q);
+    _reward_sum += reward;
+    ++_updates;
+  }
+
+  // action a votes a - 1, ties keep the current mode
+  int action = 1;
+  if (_train && _Random() < _epsilon) {
+    action = (int)(_Random() * _num_actions);
+    if (action >= _num_actions) action = _num_actions - 1;
+    ++_explorations;
+  } else {
+    static const int order[_num_actions] = {1, 2, 0};
+    for (int i = 1; i < _num_actions; ++i) {
+      if (_q[state * _num_actions + order[i]] >
+          _q[state * _num_actions + action])
+        action = order[i];
+    }
+  }
+
+  _last_state[router] = state;
+  _last_action[router] = action;
+  ++_decisions;
+  ++_actions[action];
+  return action - 1;
+}
+
+bool QLearningPowerGatingPolicy::_Load() {
+  if (_qtable_file.empty()) return false;
+  ifstream in(_qtable_file.c_str());
+  if (!in) return false;
+
+  string line;
+  getline(in, line);
+  ostringstream header;
+  header << "// qlearn states=" << _num_states << " actions=" << _num_actions;
+  if (line != header.str()) {
+    cerr << "Error: Q-table " << _qtable_file
+         << " does not match this state space" << endl;
+    exit(-1);
+  }
+  for (size_t i = 0; i < _q.size(); ++i) {
+    if (!(in >> _q[i])) {
+      cerr << "Error: Q-table " << _qtable_file << " is truncated" << endl;
+      exit(-1);
+    }
+  }
+  cout << "Q-table loaded from " << _qtable_file << endl;
+  return true;
+}
+
+void QLearningPowerGatingPolicy::_Save() const {
+  if (_qtable_file.empty()) return;
+  ofstream out(_qtable_file.c_str());
+  if (!out) {
+    cerr << "Warning: cannot write Q-table " << _qtable_file << endl;
+    return;
+  }
+  out.precision(12);
+  out << "// qlearn states=" << _num_states << " actions=" << _num_actions
+      << endl;
+  for (int s = 0; s < _num_states; ++s) {
+    for (int a = 0; a < _num_actions; ++a) {
+      out << (a ? " " : "") << _q[s * _num_actions + a];
+    }
+    out << endl;
+  }
+}
+
+void QLearningPowerGatingPolicy::DisplayStats(ostream &os) const {
+  os << "====== Q-learning Power Gating ("
+     << (_train ? "training" : "evaluation") << ") ======" << endl;
+  os << "Decisions = " << _decisions << " (explored " << _explorations << ")"
+     << endl;
+  os << "\tregress = " << _actions[0] << ", keep = " << _actions[1]
+     << ", aggress = " << _actions[2] << endl;
+  if (_updates > 0) {
+    os << "Reward average = " << _reward_sum / _updates << endl;
+  }
+  int visited = 0;
+  for (int s = 0; s < _num_states; ++s) {
+    for (int a = 0; a < _num_actions; ++a) {
+      if (_q[s * _num_actions + a] != 0.0) {
+        ++visited;
+        break;
+      }
+    }
+  }
+  os << "Q-table states visited = " << visited << " / " << _num_states
+     << endl;
+}
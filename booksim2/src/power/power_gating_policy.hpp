@@ -0,0 +1,95 @@
+/*
+ * power_gating_policy.hpp
+ * - Per-router FLOV power-gating decision engines behind the adaptive
+ *   voting hook: latency watermarks and table-based Q-learning
+ */
+
+#ifndef _POWER_GATING_POLICY_HPP_
+#define _POWER_GATING_POLICY_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "config_utils.hpp"
+#include "module.hpp"
+
+// what a router looked like over the last monitor epoch
+struct PGObservation {
+  double plat;       // packet latency around the router, < 0 without samples
+  double occupancy;  // input buffer occupancy, fraction of capacity
+  double idle;       // fraction of the epoch its nodes were idle
+  int neighbors_off; // neighbors not powered on
+  int level;         // FLOV mode, 0 No-FLOV, 1 R-FLOV, 2 G-FLOV
+  double on;         // fraction of the epoch the router was not gated
+};
+
+class PowerGatingPolicy : public Module {
+ protected:
+  double _plat_low_watermark;
+  double _plat_high_watermark;
+
+ public:
+  PowerGatingPolicy(const Configuration &config, Module *parent,
+                    const string &name);
+  virtual ~PowerGatingPolicy() {}
+
+  // +1 toward more aggressive gating, -1 back toward performance, 0 keep
+  virtual int Vote(int router, const PGObservation &obs) = 0;
+  virtual void DisplayStats(ostream &os = cout) const {}
+
+  static PowerGatingPolicy *New(const Configuration &config, Module *parent,
+                                const string &name, int routers);
+};
+
+// the fixed zero-load latency watermarks of the original adaptive FLOV
+class WatermarkPowerGatingPolicy : public PowerGatingPolicy {
+ public:
+  WatermarkPowerGatingPolicy(const Configuration &config, Module *parent,
+                             const string &name);
+  virtual int Vote(int router, const PGObservation &obs);
+};
+
+// one Q-table shared by all routers, the reward trades the latency around
+// a router against the cycles it stays powered on
+class QLearningPowerGatingPolicy : public PowerGatingPolicy {
+ protected:
+  static const int _num_actions = 3;
+  static const int _num_states = 4 * 3 * 3 * 3 * 3;
+
+  double _alpha;
+  double _gamma;
+  double _epsilon;
+  double _latency_weight;
+  double _leakage_weight;
+  double _zeroload_latency;
+  bool _train;
+  string _qtable_file;
+  unsigned long long _rng_state;
+
+  vector<double> _q;  // [state * _num_actions + action]
+  vector<int> _last_state;
+  vector<int> _last_action;
+
+  long long _decisions;
+  long long _explorations;
+  long long _updates;
+  vector<long long> _actions;
+  double _reward_sum;
+
+  int _State(const PGObservation &obs) const;
+  double _Reward(const PGObservation &obs) const;
+  double _Random();
+  bool _Load();
+  void _Save() const;
+
+ public:
+  QLearningPowerGatingPolicy(const Configuration &config, Module *parent,
+                             const string &name, int routers);
+  ~QLearningPowerGatingPolicy();
+
+  virtual int Vote(int router, const PGObservation &obs);
+  virtual void DisplayStats(ostream &os = cout) const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * profiler.cpp
+ * - Opt-in self-profile of the simulator (profile = 1): scoped cycle
+ *   counters around the router pipeline stages, channel phases,
+ *   injection, retirement and power-state evaluation, aggregated per
+ *   owner (router type, channels, traffic manager) and per phase
+ */
+
+#include <sys/time.h>
+
+#include <iomanip>
+
+#include "profiler.hpp"
+
+const char * const Profiler::STAGE[] = {
+  "read_inputs", "handshake", "power_state", "input_queuing",
+  "route_evaluate", "vc_alloc_evaluate", "sw_hold_evaluate",
+  "sw_alloc_evaluate", "switch_evaluate", "route_update", "vc_alloc_update",
+  "sw_hold_update", "sw_alloc_update", "switch_update", "flov_step",
+  "output_queuing", "write_outputs", "evaluate", "eject", "inject",
+  "retire", "step"
+};
+const char * const Profiler::PHASE[] = {"warmup", "measure", "drain"};
+
+static double WallTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+int Profiler::Owner(const string & name) {
+  vector<string> & owners = gSimContext->profile_owners;
+  for (size_t i = 0; i < owners.size(); ++i) {
+    if (owners[i] == name) return i;
+  }
+  owners.push_back(name);
+  gSimContext->profile_ticks.resize(owners.size() * phase_count * stage_count, 0);
+  gSimContext->profile_calls.resize(owners.size() * phase_count * stage_count, 0);
+  return owners.size() - 1;
+}
+
+void Profiler::Start() {
+  SimContext * const context = gSimContext;
+  context->profile_ticks.assign(context->profile_ticks.size(), 0);
+  context->profile_calls.assign(context->profile_calls.size(), 0);
+  context->profile_phase = warmup;
+  context->profile_start_time = WallTime();
+  context->profile_start_ticks = Now();
+}
+
+// seconds are estimated from the counter rate over the whole run, times
+// are exclusive of nested scopes so the shares add up
+void Profiler::Display(ostream & os) {
+  SimContext const * const context = gSimContext;
+  vector<string> const & owners = context->profile_owners;
+  vector<unsigned long long> const & ticks = context->profile_ticks;
+  vector<unsigned long long> const & calls_of = context->profile_calls;
+  double const elapsed = WallTime() - context->profile_start_time;
+  double const ticks_per_sec =
+      elapsed > 0.0 ? (Now() - context->profile_start_ticks) / elapsed : 0.0;
+  if (ticks_per_sec <= 0.0) return;
+
+  os << "====== Simulator Profile ======" << endl;
+  os << "Profiled run time = " << elapsed << " s" << endl;
+  double profiled = 0.0;
+  for (size_t owner = 0; owner < owners.size(); ++owner) {
+    for (int phase = 0; phase < phase_count; ++phase) {
+      int const base = (owner * phase_count + phase) * stage_count;
+      unsigned long long total = 0;
+      for (int s = 0; s < stage_count; ++s) {
+        total += ticks[base + s];
+      }
+      if (total == 0) continue;
+      os << owners[owner] << " (" << PHASE[phase] << "):" << endl;
+      for (int s = 0; s < stage_count; ++s) {
+        unsigned long long const calls = calls_of[base + s];
+        if (calls == 0) continue;
+        double const sec = ticks[base + s] / ticks_per_sec;
+        profiled += sec;
+        os << "\t" << left << setw(18) << STAGE[s] << right << fixed
+           << " calls = " << setw(10) << calls
+           << "  time = " << setw(9) << setprecision(4) << sec << " s"
+           << "  (" << setw(5) << setprecision(1) << 100.0 * sec / elapsed
+           << "%)  " << setw(8) << 1e9 * sec / calls << " ns/call" << endl;
+        os.unsetf(ios::fixed);
+        os << setprecision(6);
+      }
+    }
+  }
+  os << "Profiled total = " << profiled << " s ("
+     << 100.0 * profiled / elapsed << "% of run time)" << endl;
+}
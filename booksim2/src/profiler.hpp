@@ -0,0 +1,109 @@
+/*
+ * profiler.hpp
+ * - Opt-in self-profile of the simulator (profile = 1): scoped cycle
+ *   counters around the router pipeline stages, channel phases,
+ *   injection, retirement and power-state evaluation, aggregated per
+ *   owner (router type, channels, traffic manager) and per phase
+ */
+
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "globals.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+using namespace std;
+
+class Profiler {
+ public:
+  enum eStage {
+    read_inputs, handshake, power_state, input_queuing,
+    route_evaluate, vc_alloc_evaluate, sw_hold_evaluate, sw_alloc_evaluate,
+    switch_evaluate, route_update, vc_alloc_update, sw_hold_update,
+    sw_alloc_update, switch_update, flov_step, output_queuing, write_outputs,
+    evaluate, eject, inject, retire, step, stage_count
+  };
+  enum ePhase { warmup, measure, drain, phase_count };
+  static const char * const STAGE[];
+  static const char * const PHASE[];
+
+  // ticks of the cycle counter, nanoseconds without one
+  static inline unsigned long long Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+  // the counters are kept in the simulation context
+  static int Owner(const string & name);
+  static inline void SetPhase(int phase) { gSimContext->profile_phase = phase; }
+  static inline void Add(int owner, int stage, unsigned long long ticks) {
+    SimContext * const context = gSimContext;
+    int const i =
+        (owner * phase_count + context->profile_phase) * stage_count + stage;
+    context->profile_ticks[i] += ticks;
+    ++context->profile_calls[i];
+  }
+
+  static void Start();
+  static void Display(ostream & os = cout);
+};
+
+// times its enclosing block or a Start() / Stop() section, a single branch
+// when profiling is off; time spent in nested scopes is charged to them only
+class ProfileScope {
+  int _owner;
+  int _stage;
+  unsigned long long _start;
+  unsigned long long _nested;
+  ProfileScope * _outer;
+
+ public:
+  ProfileScope() : _start(0) {}
+  ProfileScope(int owner, int stage) : _start(0) { Start(owner, stage); }
+  ~ProfileScope() { Stop(); }
+
+  inline void Start(int owner, int stage) {
+    if (!gProfile) return;
+    Stop();
+    _owner = owner;
+    _stage = stage;
+    _nested = 0;
+    _outer = gSimContext->profile_current;
+    gSimContext->profile_current = this;
+    _start = Profiler::Now();
+  }
+  inline void Stop() {
+    if (!_start) return;
+    unsigned long long const ticks = Profiler::Now() - _start;
+    Profiler::Add(_owner, _stage, ticks - _nested);
+    if (_outer) _outer->_nested += ticks;
+    gSimContext->profile_current = _outer;
+    _start = 0;
+  }
+};
+
+#define PROFILE_SCOPE(owner, stage) \
+  ProfileScope _profile_scope((owner), Profiler::stage)
+
+// one pipeline stage call of a router or traffic manager
+#define PROFILE_CALL(stage, call)                                 \
+  do {                                                            \
+    ProfileScope _profile_scope(_profile_owner, Profiler::stage); \
+    call;                                                         \
+  } while (0)
+
+#endif
@@ -26,21 +26,171 @@
 */
 
 #include "random_utils.hpp"
+#include "globals.hpp"
 #include <algorithm>
 #include <cassert>
 
-extern long ran_x[];
-extern double ran_u[];
 #define KK 100
 
 void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u ) {
-  save_x.assign(ran_x, ran_x + KK);
-  save_u.assign(ran_u, ran_u + KK);
+  save_x.assign(gSimContext->ran_x, gSimContext->ran_x + KK);
+  save_u.assign(gSimContext->ran_u, gSimContext->ran_u + KK);
 }
 
 void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> const & save_u) {
   assert(save_x.size() == KK);
-  std::copy(save_x.begin(), save_x.end(), ran_x);
+  std::copy(save_x.begin(), save_x.end(), gSimContext->ran_x);
   assert(save_u.size() == KK);
-  std::copy(save_u.begin(), save_u.end(), ran_u);
+  std::copy(save_u.begin(), save_u.end(), gSimContext->ran_u);
+}
+
+void PhiloxBlocks( unsigned int k0, unsigned int k1, unsigned long long first,
+                   unsigned int id, unsigned int component, int n,
+                   unsigned int * out ) {
+  const int L = 8;
+  for ( int b = 0; b < n; b += L ) {
+    unsigned int c0[L], c1[L], c2[L], c3[L];
+    for ( int l = 0; l < L; ++l ) {
+      unsigned long long const ctr = first + b + l;
+      c0[l] = (unsigned int)ctr;
+      c1[l] = (unsigned int)(ctr >> 32);
+      c2[l] = id;
+      c3[l] = component;
+    }
+    unsigned int key0 = k0;
+    unsigned int key1 = k1;
+    for ( int r = 0; r < 10; ++r ) {
+      // kept as a loop, unrolled it is left to the less eager block
+      // vectorizer
+#pragma GCC unroll 1
+      for ( int l = 0; l < L; ++l ) {
+        unsigned long long const p0 = (unsigned long long)PHILOX_M0 * c0[l];
+        unsigned long long const p1 = (unsigned long long)PHILOX_M1 * c2[l];
+        unsigned int const n0 = (unsigned int)(p1 >> 32) ^ c1[l] ^ key0;
+        unsigned int const n2 = (unsigned int)(p0 >> 32) ^ c3[l] ^ key1;
+        c1[l] = (unsigned int)p1;
+        c3[l] = (unsigned int)p0;
+        c0[l] = n0;
+        c2[l] = n2;
+      }
+      key0 += PHILOX_W0;
+      key1 += PHILOX_W1;
+    }
+    int const lanes = std::min( L, n - b );
+    for ( int l = 0; l < lanes; ++l ) {
+      unsigned int * const block = out + 4 * ( b + l );
+      block[0] = c0[l];
+      block[1] = c1[l];
+      block[2] = c2[l];
+      block[3] = c3[l];
+    }
+  }
+}
+
+void RandomStream::Key( int component, unsigned int id ) {
+  Key( component, id, 0 );
+  _fixed_seed = false;
+}
+
+void RandomStream::Key( int component, unsigned int id, long seed ) {
+  _legacy = !gSimContext->random_streams;
+  _fixed_seed = true;
+  _seed = seed;
+  _component = component;
+  _id = id;
+  _counter = 0;
+  _used = 4;
+}
+
+void RandomStream::KeyPrivate( int component, unsigned int id, long seed ) {
+  Key( component, id, seed );
+  _legacy = false;
+}
+
+// the simulation seed is read on every block, so a replication that
+// reseeds the simulation reseeds its streams as well
+void RandomStream::_Refill( ) {
+  unsigned long long const seed = _fixed_seed ? _seed : gSimContext->random_seed;
+  unsigned int ctr[4] = { (unsigned int)_counter, (unsigned int)(_counter >> 32),
+                          _id, _component };
+  Philox4x32( ctr, (unsigned int)seed, (unsigned int)(seed >> 32) );
+  std::copy( ctr, ctr + 4, _block );
+  ++_counter;
+  _used = 0;
+}
+
+void RandomStream::Fill( unsigned int * out, int n ) {
+  int i = 0;
+  if ( !_legacy ) {
+    for ( ; ( i < n ) && ( _used < 4 ); ++i ) {
+      out[i] = _block[_used++];
+    }
+    int const blocks = ( n - i ) / 4;
+    if ( blocks > 0 ) {
+      unsigned long long const seed = _fixed_seed ? _seed : gSimContext->random_seed;
+      PhiloxBlocks( (unsigned int)seed, (unsigned int)(seed >> 32), _counter,
+                    _id, _component, blocks, out + i );
+      _counter += blocks;
+      i += 4 * blocks;
+    }
+  }
+  for ( ; i < n; ++i ) {
+    out[i] = Next( );
+  }
+}
+
+void RandomStream::Fill( double * out, int n ) {
+  if ( _legacy ) {
+    for ( int i = 0; i < n; ++i ) {
+      out[i] = Float( );
+    }
+    return;
+  }
+  const int chunk = 256;
+  unsigned int words[2 * chunk];
+  for ( int b = 0; b < n; b += chunk ) {
+    int const m = std::min( chunk, n - b );
+    Fill( words, 2 * m );
+    for ( int i = 0; i < m; ++i ) {
+      unsigned long long const hi = words[2 * i] >> 5;
+      unsigned long long const lo = words[2 * i + 1] >> 6;
+      out[b + i] = ( hi * 67108864.0 + lo ) * ( 1.0 / 9007199254740992.0 );
+    }
+  }
+}
+
+void RandomStream::Skip( unsigned long long n ) {
+  if ( _legacy ) {
+    for ( ; n > 0; --n ) {
+      Next( );
+    }
+    return;
+  }
+  unsigned long long const position = 4 * _counter - ( 4 - _used ) + n;
+  _counter = position / 4;
+  _used = 4;
+  if ( position % 4 ) {
+    _Refill( );
+    _used = position % 4;
+  }
+}
+
+// FNV-1a
+unsigned int RandomStreamId( std::string const & name ) {
+  unsigned int hash = 2166136261u;
+  for ( size_t i = 0; i < name.size(); ++i ) {
+    hash = ( hash ^ (unsigned char)name[i] ) * 16777619u;
+  }
+  return hash;
+}
+
+RandomStream & SourceRandom( int source ) {
+  std::vector<RandomStream *> & streams = gSimContext->source_random;
+  if ( (int)streams.size() <= source ) {
+    streams.resize( source + 1, NULL );
+  }
+  if ( !streams[source] ) {
+    streams[source] = new RandomStream( RandomStream::routing, source );
+  }
+  return *streams[source];
 }
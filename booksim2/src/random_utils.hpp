@@ -29,6 +29,9 @@
 #define _RANDOM_UTILS_HPP_
 
 #include <vector>
+#include <string>
+
+#include "globals.hpp"
 
 // interface to Knuth's RANARRAY RNG
 void   ran_start(long seed);
@@ -66,4 +69,113 @@ void SaveRandomState( std::vector<long> & save_x, std::vector<double> & save_u )
 // Restores the generator state from previously saved values
 void RestoreRandomState( std::vector<long> const & save_x, std::vector<double> const & save_u );
 
+/*
+ * Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+ * 3", SC'11): one block of four words for every counter value, so any
+ * draw of any stream can be computed without the draws before it.
+ */
+const unsigned int PHILOX_M0 = 0xD2511F53;
+const unsigned int PHILOX_M1 = 0xCD9E8D57;
+const unsigned int PHILOX_W0 = 0x9E3779B9;
+const unsigned int PHILOX_W1 = 0xBB67AE85;
+
+inline void Philox4x32( unsigned int ctr[4], unsigned int k0, unsigned int k1 ) {
+  for ( int r = 0; r < 10; ++r ) {
+    unsigned long long const p0 = (unsigned long long)PHILOX_M0 * ctr[0];
+    unsigned long long const p1 = (unsigned long long)PHILOX_M1 * ctr[2];
+    unsigned int const c0 = (unsigned int)(p1 >> 32) ^ ctr[1] ^ k0;
+    unsigned int const c2 = (unsigned int)(p0 >> 32) ^ ctr[3] ^ k1;
+    ctr[1] = (unsigned int)p1;
+    ctr[3] = (unsigned int)p0;
+    ctr[0] = c0;
+    ctr[2] = c2;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+
+// n consecutive blocks from counter first, eight at a time so the rounds
+// vectorize
+void PhiloxBlocks( unsigned int k0, unsigned int k1, unsigned long long first,
+                   unsigned int id, unsigned int component, int n,
+                   unsigned int * out );
+
+/*
+ * A random stream of its own for one component instance, keyed by the
+ * simulation seed, the component and an id (source node, router, ...):
+ * its draws do not depend on how many draws other components made or in
+ * which order they were evaluated. With random_streams = 0 every stream
+ * draws from the single Knuth generator in call order, as before.
+ */
+class RandomStream {
+
+public:
+
+  enum eComponent { injection = 1, traffic, hotspot, permutation, packet,
+                    routing, router, allocator, power_gate, fail };
+
+  RandomStream( ) : _legacy(true), _fixed_seed(false), _seed(0),
+                    _component(0), _id(0), _counter(0), _used(4) { }
+  RandomStream( int component, unsigned int id ) { Key( component, id ); }
+
+  // keyed by the simulation seed, unless the site has a seed of its own
+  void Key( int component, unsigned int id );
+  void Key( int component, unsigned int id, long seed );
+  // a stream of its own even with random_streams = 0, for draws made in
+  // the middle of a run that must not shift the Knuth generator
+  void KeyPrivate( int component, unsigned int id, long seed );
+
+  inline unsigned int Next( ) {
+    if ( _legacy ) {
+      return RandomIntLong( );
+    }
+    if ( _used == 4 ) {
+      _Refill( );
+    }
+    return _block[_used++];
+  }
+
+  // [0,max], as RandomInt
+  inline int Int( int max ) {
+    return _legacy ? RandomInt( max ) : ( Next( ) % (max+1) );
+  }
+
+  // [0,1), 53 bits
+  inline double Float( ) {
+    if ( _legacy ) {
+      return RandomFloat( );
+    }
+    unsigned long long const hi = Next( ) >> 5;
+    unsigned long long const lo = Next( ) >> 6;
+    return ( hi * 67108864.0 + lo ) * ( 1.0 / 9007199254740992.0 );
+  }
+
+  // bulk draws, the same values as n calls of Next or Float
+  void Fill( unsigned int * out, int n );
+  void Fill( double * out, int n );
+
+  // as if n values had been drawn with Next
+  void Skip( unsigned long long n );
+
+private:
+
+  bool _legacy;
+  bool _fixed_seed;
+  long _seed;
+  unsigned int _component;
+  unsigned int _id;
+  unsigned long long _counter;
+  unsigned int _block[4];
+  int _used;
+
+  void _Refill( );
+
+};
+
+// hash of a module name, the stream id of a component without a number
+unsigned int RandomStreamId( std::string const & name );
+
+// the stream of a source node for decisions made outside any router
+RandomStream & SourceRandom( int source );
+
 #endif
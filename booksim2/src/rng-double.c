@@ -21,7 +21,9 @@
 #define LL  37                     /* the short lag */
 #define mod_sum(x,y) (((x)+(y))-(int)((x)+(y)))   /* (x+y) mod 1.0 */
 
+#ifndef RAN_EXTERNAL_STATE    /* booksim keeps it per simulation */
 double ran_u[KK];           /* the generator state */
+#endif
 
 #ifdef __STDC__
 void ranf_array(double aa[], int n)
@@ -42,9 +44,13 @@ void ranf_array(aa,n)    /* put n new random fractions in aa */
 /* after calling ranf_start, get new randoms by, e.g., "x=ranf_arr_next()" */
 
 #define QUALITY 1009 /* recommended quality level for high-res use */
+#ifndef RAN_EXTERNAL_STATE
 double ranf_arr_buf[QUALITY];
+#endif
 double ranf_arr_dummy=-1.0, ranf_arr_started=-1.0;
+#ifndef RAN_EXTERNAL_STATE
 double *ranf_arr_ptr=&ranf_arr_dummy; /* the next random fraction, or -1 */
+#endif
 
 #define TT  70   /* guaranteed separation between streams */
 #define is_odd(s) ((s)&1)
@@ -25,6 +25,14 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include "globals.hpp"
+
+// the generator state lives in the simulation context
+#define RAN_EXTERNAL_STATE
+#define ran_u (gSimContext->ran_u)
+#define ranf_arr_buf (gSimContext->ranf_arr_buf)
+#define ranf_arr_ptr (gSimContext->ranf_arr_ptr)
+
 #define main rng_double_main
 #include "rng-double.c"
 
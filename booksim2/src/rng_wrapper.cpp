@@ -25,6 +25,14 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include "globals.hpp"
+
+// the generator state lives in the simulation context
+#define RAN_EXTERNAL_STATE
+#define ran_x (gSimContext->ran_x)
+#define ran_arr_buf (gSimContext->ran_arr_buf)
+#define ran_arr_ptr (gSimContext->ran_arr_ptr)
+
 #define main rng_main
 #include "rng.c"
 
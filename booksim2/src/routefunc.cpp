@@ -52,16 +52,9 @@
 
 
 
-map<string, tRoutingFunction> gRoutingFunctionMap;
-
-/* Global information used by routing functions */
-
-/* ==== Power Gate - Begin ==== */
-int gRoutingDeadlockTimeoutThreshold;
-int gMissRouteThreshold;
-/* ==== Power Gate - End ==== */
-
-int gNumVCs;
+/* Global information used by routing functions lives in the simulation
+ * context, see routefunc.hpp
+ */
 
 /* Add more functions here
  *
@@ -69,10 +62,6 @@ int gNumVCs;
 
 // ============================================================
 //  Balfour-Schultz
-int gReadReqBeginVC, gReadReqEndVC;
-int gWriteReqBeginVC, gWriteReqEndVC;
-int gReadReplyBeginVC, gReadReplyEndVC;
-int gWriteReplyBeginVC, gWriteReplyEndVC;
 
 // ============================================================
 //  QTree: Nearest Common Ancestor
@@ -166,7 +155,7 @@ void tree4_anca( const Router *r, const Flit *f,
 
     if ( rH == 0 ) {
       dest /= 16;
-      out_port = 2 * dest + RandomInt(1);
+      out_port = 2 * dest + RoutingRandom( r, f ).Int(1);
     } else if ( rH == 1 ) {
       dest /= 4;
       if ( dest / 4 == rP / 2 )
@@ -234,18 +223,18 @@ void tree4_nca( const Router *r, const Flit *f,
 
     if ( rH == 0 ) {
       dest /= 16;
-      out_port = 2 * dest + RandomInt(1);
+      out_port = 2 * dest + RoutingRandom( r, f ).Int(1);
     } else if ( rH == 1 ) {
       dest /= 4;
       if ( dest / 4 == rP / 2 )
 	out_port = dest % 4;
       else
-	out_port = gK + RandomInt(gK-1);
+	out_port = gK + RoutingRandom( r, f ).Int(gK-1);
     } else {
       if ( dest/4 == rP )
 	out_port = dest % 4;
       else
-	out_port = gK + RandomInt(1);
+	out_port = gK + RoutingRandom( r, f ).Int(1);
     }
 
     //  cout << "Router("<<rH<<","<<rP<<"): id= " << f->id << " dest= " << f->dest << " out_port = "
@@ -314,7 +303,7 @@ void fattree_nca( const Router *r, const Flit *f,
     } else {
       //up ports are numbered last
       assert(in_channel<gK);//came from a up channel
-      out_port = gK+RandomInt(gK-1);
+      out_port = gK+RoutingRandom( r, f ).Int(gK-1);
     }
   }
   outputs->Clear( );
@@ -382,8 +371,8 @@ void fattree_anca( const Router *r, const Flit *f,
       //up ports are numbered last
       assert(in_channel<gK);//came from a up channel
       out_port = gK;
-      int random1 = RandomInt(gK-1); // Chose two ports out of the possible at random, compare loads, choose one.
-      int random2 = RandomInt(gK-1);
+      int random1 = RoutingRandom( r, f ).Int(gK-1); // Chose two ports out of the possible at random, compare loads, choose one.
+      int random2 = RoutingRandom( r, f ).Int(gK-1);
       if (r->GetUsedCredit(out_port + random1) > r->GetUsedCredit(out_port + random2)){
 	out_port = out_port + random2;
       }else{
@@ -458,7 +447,7 @@ void adaptive_xy_yx_mesh( const Router *r, const Flit *f,
       } else if(credit_xy < credit_yx) {
 	x_then_y = true;
       } else {
-	x_then_y = (RandomInt(1) > 0);
+	x_then_y = (RoutingRandom( r, f ).Int(1) > 0);
       }
     }
 
@@ -518,7 +507,7 @@ void xy_yx_mesh( const Router *r, const Flit *f,
     //  into the network
     bool x_then_y = ((in_channel < 2*gN) ?
 		     (f->vc < (vcBegin + available_vcs)) :
-		     (RandomInt(1) > 0));
+		     (RoutingRandom( r, f ).Int(1) > 0));
 
     if(x_then_y) {
       out_port = dor_next_mesh( r->GetID(), f->dest, false );
@@ -575,7 +564,7 @@ int dor_next_mesh( int cur, int dest, bool descending )
 
 //=============================================================
 
-void dor_next_torus( int cur, int dest, int in_port,
+void dor_next_torus( RandomStream & random, int cur, int dest, int in_port,
 		     int *out_port, int *partition,
 		     bool balance = false )
 {
@@ -597,7 +586,7 @@ void dor_next_torus( int cur, int dest, int in_port,
       dist2 = gK - 2 * ( ( dest - cur + gK ) % gK );
 
       if ( ( dist2 > 0 ) ||
-	   ( ( dist2 == 0 ) && ( RandomInt( 1 ) ) ) ) {
+	   ( ( dist2 == 0 ) && ( random.Int( 1 ) ) ) ) {
 	*out_port = 2*dim_left;     // Right
 	dir = 0;
       } else {
@@ -619,7 +608,7 @@ void dor_next_torus( int cur, int dest, int in_port,
 		      ( ( dir == 1 ) && ( cur >  (gK-1)/2 ) && ( dest <= (gK-1)/2 ) ) ) {
 	    *partition = 0;
 	  } else {
-	    *partition = RandomInt( 1 ); // use either VC set
+	    *partition = random.Int( 1 ); // use either VC set
 	  }
 	} else {
 	  // Deterministic, fixed dateline between nodes k-1 and 0
@@ -791,7 +780,7 @@ void dim_order_pni_mesh( const Router *r, const Flit *f, int in_channel, OutputS
 
 // Random intermediate in the minimal quadrant defined
 // by the source and destination
-int rand_min_intr_mesh( int src, int dest )
+int rand_min_intr_mesh( RandomStream & random, int src, int dest )
 {
   int dist;
 
@@ -802,9 +791,9 @@ int rand_min_intr_mesh( int src, int dest )
     dist = ( dest % gK ) - ( src % gK );
 
     if ( dist > 0 ) {
-      intm += offset * ( ( src % gK ) + RandomInt( dist ) );
+      intm += offset * ( ( src % gK ) + random.Int( dist ) );
     } else {
-      intm += offset * ( ( dest % gK ) + RandomInt( -dist ) );
+      intm += offset * ( ( dest % gK ) + random.Int( -dist ) );
     }
 
     offset *= gK;
@@ -844,7 +833,7 @@ void romm_mesh( const Router *r, const Flit *f, int in_channel, OutputSet *outpu
 
     if ( in_channel == 2*gN ) {
       f->ph   = 0;  // Phase 0
-      f->intm = rand_min_intr_mesh( f->src, f->dest );
+      f->intm = rand_min_intr_mesh( RoutingRandom( r, f ), f->src, f->dest );
     }
 
     if ( ( f->ph == 0 ) && ( r->GetID( ) == f->intm ) ) {
@@ -916,7 +905,7 @@ void romm_ni_mesh( const Router *r, const Flit *f, int in_channel, OutputSet *ou
 
     if ( in_channel == 2*gN ) {
       f->ph   = 0;  // Phase 0
-      f->intm = rand_min_intr_mesh( f->src, f->dest );
+      f->intm = rand_min_intr_mesh( RoutingRandom( r, f ), f->src, f->dest );
     }
 
     if ( ( f->ph == 0 ) && ( r->GetID( ) == f->intm ) ) {
@@ -1277,7 +1266,7 @@ void planar_adapt_mesh( const Router *r, const Flit *f, int in_channel, OutputSe
         d1_min_c = 2*n + 1;
         atedge = true;
       } else {
-        d1_min_c = 2*n + RandomInt( 1 ); // random misroute
+        d1_min_c = 2*n + RoutingRandom( r, f ).Int( 1 ); // random misroute
 
         if ( d1_min_c  == in_channel ) { // don't 180
           d1_min_c = in_channel ^ 1;
@@ -1402,7 +1391,7 @@ void valiant_mesh( const Router *r, const Flit *f, int in_channel, OutputSet *ou
 
     if ( in_channel == 2*gN ) {
       f->ph   = 0;  // Phase 0
-      f->intm = RandomInt( gNodes - 1 );
+      f->intm = RoutingRandom( r, f ).Int( gNodes - 1 );
     }
 
     if ( ( f->ph == 0 ) && ( r->GetID( ) == f->intm ) ) {
@@ -1464,7 +1453,7 @@ void valiant_torus( const Router *r, const Flit *f, int in_channel, OutputSet *o
     int phase;
     if ( in_channel == 2*gN ) {
       phase   = 0;  // Phase 0
-      f->intm = RandomInt( gNodes - 1 );
+      f->intm = RoutingRandom( r, f ).Int( gNodes - 1 );
     } else {
       phase = f->ph / 2;
     }
@@ -1475,7 +1464,7 @@ void valiant_torus( const Router *r, const Flit *f, int in_channel, OutputSet *o
     }
 
     int ring_part;
-    dor_next_torus( r->GetID( ), (phase == 0) ? f->intm : f->dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), r->GetID( ), (phase == 0) ? f->intm : f->dest, in_channel,
         &out_port, &ring_part, false );
 
     f->ph = 2 * phase + ring_part;
@@ -1554,7 +1543,7 @@ void valiant_ni_torus( const Router *r, const Flit *f, int in_channel,
     int phase;
     if ( in_channel == 2*gN ) {
       phase   = 0;  // Phase 0
-      f->intm = RandomInt( gNodes - 1 );
+      f->intm = RoutingRandom( r, f ).Int( gNodes - 1 );
     } else {
       phase = f->ph / 2;
     }
@@ -1565,7 +1554,7 @@ void valiant_ni_torus( const Router *r, const Flit *f, int in_channel,
     }
 
     int ring_part;
-    dor_next_torus( r->GetID( ), (f->ph == 0) ? f->intm : f->dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), r->GetID( ), (f->ph == 0) ? f->intm : f->dest, in_channel,
         &out_port, &ring_part, false );
 
     f->ph = 2 * phase + ring_part;
@@ -1645,7 +1634,7 @@ void dim_order_torus( const Router *r, const Flit *f, int in_channel,
     int cur  = r->GetID( );
     int dest = f->dest;
 
-    dor_next_torus( cur, dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), cur, dest, in_channel,
         &out_port, &f->ph, false );
 
 
@@ -1713,7 +1702,7 @@ void dim_order_ni_torus( const Router *r, const Flit *f, int in_channel,
     int cur  = r->GetID( );
     int dest = f->dest;
 
-    dor_next_torus( cur, dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), cur, dest, in_channel,
         &out_port, NULL, false );
 
     // at the destination router, we don't need to separate VCs by destination
@@ -1778,7 +1767,7 @@ void dim_order_bal_torus( const Router *r, const Flit *f, int in_channel,
     int cur  = r->GetID( );
     int dest = f->dest;
 
-    dor_next_torus( cur, dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), cur, dest, in_channel,
         &out_port, &f->ph, true );
 
     // at the destination router, we don't need to separate VCs by ring partition
@@ -1879,11 +1868,11 @@ void min_adapt_torus( const Router *r, const Flit *f, int in_channel, OutputSet
     // DOR for the escape channel (VCs 0-1), low priority ---
     // trick the algorithm with the in channel.  want VC assignment
     // as if we had injected at this node
-    dor_next_torus( r->GetID( ), f->dest, 2*gN,
+    dor_next_torus( RoutingRandom( r, f ), r->GetID( ), f->dest, 2*gN,
         &out_port, &f->ph, false );
   } else {
     // DOR for the escape channel (VCs 0-1), low priority
-    dor_next_torus( cur, dest, in_channel,
+    dor_next_torus( RoutingRandom( r, f ), cur, dest, in_channel,
         &out_port, &f->ph, false );
   }
 
@@ -2016,8 +2005,50 @@ void chaos_mesh( const Router *r, const Flit *f,
 //=============================================================
 
 /* ==== Power Gate - Begin ==== */
-void flov_mesh( const Router *r, const Flit *f, int in_channel,
-    OutputSet *outputs, bool inject )
+// FLOV on k-ary n-cubes: the last row (plane for 3D) is always on and
+// carries the escape paths, the escape VC only uses the embedded mesh so
+// wrap links never close a cycle on it
+static int flov_coord( int node, int dim )
+{
+  return (node / powi(gK, dim)) % gK;
+}
+
+static bool flov_always_on( int node )
+{
+  return flov_coord(node, gN - 1) == gK - 1;
+}
+
+static int flov_diff_dims( int cur, int dest )
+{
+  int dims = 0;
+  for (int dim = 0; dim < gN; ++dim) {
+    if (flov_coord(cur, dim) != flov_coord(dest, dim))
+      ++dims;
+  }
+  return dims;
+}
+
+// hops from cur to dest going around the ring in the direction of out_port
+static int flov_ring_hops( int cur, int dest, int out_port )
+{
+  int const dim = out_port / 2;
+  int const diff = flov_coord(dest, dim) - flov_coord(cur, dim);
+  return (out_port % 2) ? (gK - diff) % gK : (gK + diff) % gK;
+}
+
+// dimension-order next hop, minimal direction on a torus
+static int flov_dor_next( int cur, int dest, bool descending, bool torus )
+{
+  int const out_port = dor_next_mesh(cur, dest, descending);
+  if (!torus || out_port == 2*gN)
+    return out_port;
+  int const dim = out_port / 2;
+  int const plus = 2*dim;
+  return (2 * flov_ring_hops(cur, dest, plus) <= gK) ? plus : plus + 1;
+}
+
+static void _flov( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject, bool torus )
 {
   int vcBegin = 0, vcEnd = gNumVCs-1;
   if ( f->type == Flit::READ_REQUEST ) {
@@ -2041,17 +2072,17 @@ void flov_mesh( const Router *r, const Flit *f, int in_channel,
     // injection can use all VCs
     outputs->AddRange(-1, vcBegin, vcEnd);
     return;
-  } else if(r->GetID() == f->dest) {
+  } else if(r->GetID() == r->NodeRouter(f->dest)) {
     // ejection can also use all VCs
-    outputs->AddRange(2*gN, vcBegin, vcEnd);
+    outputs->AddRange(r->EjectPort(f->dest), vcBegin, vcEnd);
     return;
   }
 
-  assert(!inject && r->GetID() != f->dest);
+  assert(!inject && r->GetID() != r->NodeRouter(f->dest));
 
   int in_vc;
 
-  if ( in_channel == 2*gN ) {
+  if ( in_channel >= 2*gN ) {
     in_vc = vcEnd; // ignore the injection VC
   } else {
     in_vc = f->vc;
@@ -2062,23 +2093,24 @@ void flov_mesh( const Router *r, const Flit *f, int in_channel,
     escape = true;
 
   int cur = r->GetID();
-  int dest = f->dest;
+  int dest = r->NodeRouter(f->dest);
 
-  int out_port = dor_next_mesh(r->GetID(), f->dest);  // XY
+  int out_port = flov_dor_next(cur, dest, false, torus);  // XY
 
   if(r->GetNeighborPowerState(out_port) != Router::power_on)
-    out_port = dor_next_mesh(r->GetID(), f->dest, true);  // YX
+    out_port = flov_dor_next(cur, dest, true, torus);  // YX
 
   if (GetSimTime() - f->rtime > 300)
     escape = true;
 
-  if ((cur % gK != dest % gK) && (cur / gK != dest / gK)
+  if (flov_diff_dims(cur, dest) > 1
       && r->GetNeighborPowerState(out_port) != Router::power_on) // not in same row/col
     escape = true;
 
   if (escape == true) {
-    if (cur < gNodes - gK && (cur % gK != dest % gK) && (cur / gK != dest / gK))
-      out_port = 2;
+    out_port = dor_next_mesh(cur, dest);
+    if (!flov_always_on(cur) && flov_diff_dims(cur, dest) > 1)
+      out_port = 2*(gN-1);
     vcEnd = vcBegin;
   } else
     ++vcBegin;
@@ -2099,6 +2131,18 @@ void flov_mesh( const Router *r, const Flit *f, int in_channel,
   outputs->AddRange(out_port, vcBegin, vcEnd);
 }
 
+void flov_mesh( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject )
+{
+  _flov(r, f, in_channel, outputs, inject, false);
+}
+
+void flov_torus( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject )
+{
+  _flov(r, f, in_channel, outputs, inject, true);
+}
+
 void opt_rflov_mesh( const Router *r, const Flit *f, int in_channel,
     OutputSet *outputs, bool inject )
 {
@@ -2295,8 +2339,12 @@ void opt_flov_mesh( const Router *r, const Flit *f, int in_channel,
   outputs->AddRange(out_port, vcBegin, vcEnd);
 }
 
-void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
-    OutputSet *outputs, bool inject )
+// with flov_regional_congestion, weigh the downstream congestion reported
+// over the side-band network on top of the local credits
+// torus: minimal direction for the adaptive VCs, the escape VC stays on
+// the embedded mesh
+static void _adaptive_flov( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject, bool torus )
 {
   int vcBegin = 0, vcEnd = gNumVCs-1;
   if ( f->type == Flit::READ_REQUEST ) {
@@ -2340,14 +2388,11 @@ void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
 
   int cur = r->GetID();
   int dest = f->dest;
-  int dest_x = dest % gK;
-  int dest_y = dest / gK;
 
   int escape_out_port = dor_next_mesh(r->GetID(), f->dest); // XY
-  if (cur < gNodes - gK &&
-      (cur % gK != dest % gK) && (cur / gK != dest / gK) &&
-      escape_out_port != 3)
-    escape_out_port = 2;
+  if (!flov_always_on(cur) && flov_diff_dims(cur, dest) > 1 &&
+      escape_out_port != 2*(gN-1) + 1)
+    escape_out_port = 2*(gN-1);
   outputs->AddRange(escape_out_port, vcBegin, vcBegin, 0);
   if ( f->watch ) {
     *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
@@ -2364,20 +2409,14 @@ void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
   if (!in_escape && !goto_escape) {
     vcBegin++;
 
-    vector<int> logical_neighbors_x(4, -1);
-    vector<int> logical_neighbors_y(4, -1);
-    for (int i = 0; i < 4; i++) {
-      int logical_neighbor = r->GetLogicalNeighbor(i);
-      if (logical_neighbor != -1) {
-        logical_neighbors_x[i] = logical_neighbor % gK;
-        logical_neighbors_y[i] = logical_neighbor / gK;
-      }
-    }
-
-    int xy_out_port = dor_next_mesh(r->GetID(), f->dest);  // XY
-    int yx_out_port = dor_next_mesh(r->GetID(), f->dest, true);  // YX
+    int xy_out_port = flov_dor_next(cur, dest, false, torus);  // XY
+    int yx_out_port = flov_dor_next(cur, dest, true, torus);  // YX
     int credit_xy = r->GetFreeCredit(xy_out_port);
     int credit_yx = r->GetFreeCredit(yx_out_port);
+    if (r->RegionalCongestion()) {
+      credit_xy = 2 * credit_xy - r->GetDownstreamCongestion(xy_out_port);
+      credit_yx = 2 * credit_yx - r->GetDownstreamCongestion(yx_out_port);
+    }
     int xy_pri, yx_pri;
     if (credit_xy >= credit_yx) {
       xy_pri = 2;
@@ -2387,7 +2426,7 @@ void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
       yx_pri = 2;
     }
 
-    if ((cur % gK == dest % gK) || (cur / gK == dest / gK)) {
+    if (flov_diff_dims(cur, dest) <= 1) {
       outputs->AddRange(xy_out_port, vcBegin, vcEnd, 1);
         if (f->watch) {
           *gWatchOut << GetSimTime() << " | " << r->FullName() << " | "
@@ -2399,14 +2438,31 @@ void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
     } else {
       bool xy_avaiable = (r->GetNeighborPowerState(xy_out_port) == Router::power_on);
       bool yx_avaiable = (r->GetNeighborPowerState(yx_out_port) == Router::power_on);
-      if ((r->GetNeighborPowerState(xy_out_port) == Router::power_off) &&
-          ((logical_neighbors_x[0] != -1 && dest_x >= logical_neighbors_x[0]) ||
-           (logical_neighbors_x[1] != -1 && dest_x <= logical_neighbors_x[1]))) {
-        xy_avaiable = true;
+      // a gated neighbor is fine if the next powered router behind it
+      // does not overshoot the destination
+      int const x = xy_out_port / 2;
+      int const y = yx_out_port / 2;
+      int const ln_xp = r->GetLogicalNeighbor(2*x);
+      int const ln_xm = r->GetLogicalNeighbor(2*x + 1);
+      int const ln_ym = r->GetLogicalNeighbor(2*y + 1);
+      if (r->GetNeighborPowerState(xy_out_port) == Router::power_off) {
+        if (torus) {
+          int const ln = r->GetLogicalNeighbor(xy_out_port);
+          xy_avaiable = (ln != -1 && flov_ring_hops(cur, ln, xy_out_port) <=
+              flov_ring_hops(cur, dest, xy_out_port));
+        } else if ((ln_xp != -1 && flov_coord(dest, x) >= flov_coord(ln_xp, x)) ||
+            (ln_xm != -1 && flov_coord(dest, x) <= flov_coord(ln_xm, x))) {
+          xy_avaiable = true;
+        }
       }
-      if ((r->GetNeighborPowerState(yx_out_port) == Router::power_off) &&
-         (logical_neighbors_y[3] != -1 && dest_y <= logical_neighbors_y[3])) {
-        yx_avaiable = true;
+      if (r->GetNeighborPowerState(yx_out_port) == Router::power_off) {
+        if (torus) {
+          int const ln = r->GetLogicalNeighbor(yx_out_port);
+          yx_avaiable = (ln != -1 && flov_ring_hops(cur, ln, yx_out_port) <=
+              flov_ring_hops(cur, dest, yx_out_port));
+        } else if (ln_ym != -1 && flov_coord(dest, y) <= flov_coord(ln_ym, y)) {
+          yx_avaiable = true;
+        }
       }
       if (xy_avaiable && xy_out_port != in_channel) {
         outputs->AddRange(xy_out_port, vcBegin, vcEnd, xy_pri);
@@ -2443,6 +2499,18 @@ void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
   }
 }
 
+void adaptive_flov_mesh( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject )
+{
+  _adaptive_flov(r, f, in_channel, outputs, inject, false);
+}
+
+void adaptive_flov_torus( const Router *r, const Flit *f, int in_channel,
+    OutputSet *outputs, bool inject )
+{
+  _adaptive_flov(r, f, in_channel, outputs, inject, true);
+}
+
 
 void rp_mesh( const Router *r, const Flit *f, int in_channel,
     OutputSet *outputs, bool inject )
@@ -2886,6 +2954,9 @@ void InitializeRoutingMap( const Configuration & config )
   gRoutingFunctionMap["opt_rflov_mesh"] = &opt_rflov_mesh; // optimzed rflov_routing
   gRoutingFunctionMap["opt_flov_mesh"] = &opt_flov_mesh; // optimized flov routing
   gRoutingFunctionMap["adaptive_flov_mesh"] = &adaptive_flov_mesh;
+  gRoutingFunctionMap["flov_torus"] = &flov_torus;
+  gRoutingFunctionMap["adaptive_flov_torus"] = &adaptive_flov_torus;
+  gRoutingFunctionMap["flov_cmesh"] = &flov_mesh; // no express channels
   gRoutingFunctionMap["rp_mesh"] = &rp_mesh;
   gRoutingFunctionMap["nord_mesh"] = &nord_mesh;
   gRoutingFunctionMap["ring_dateline_mesh"] = &ring_dateline_mesh;
@@ -32,11 +32,17 @@
 #include "router.hpp"
 #include "outputset.hpp"
 #include "config_utils.hpp"
-
-typedef void (*tRoutingFunction)( const Router *, const Flit *, int in_channel, OutputSet *, bool );
+#include "globals.hpp"
+#include "random_utils.hpp"
 
 void InitializeRoutingMap( const Configuration & config );
 
+// the stream of a routing decision: the router's own, or the source's at
+// injection where there is no router yet
+inline RandomStream & RoutingRandom( const Router * r, const Flit * f ) {
+  return r ? r->Random( ) : SourceRandom( f->src );
+}
+
 /* ==== Power Gate - Begin ==== */
 enum Direction {
     DIR_EAST = 0,
@@ -47,16 +53,20 @@ enum Direction {
     DIR_INVALID,
 };
 
-extern int gRoutingDeadlockTimeoutThreshold;
-extern int gMissRouteThreshold;
+#define gRoutingDeadlockTimeoutThreshold (gSimContext->routing_deadlock_timeout_threshold)
+#define gMissRouteThreshold (gSimContext->miss_route_threshold)
 /* ==== Power Gate - End ==== */
 
-extern map<string, tRoutingFunction> gRoutingFunctionMap;
+#define gRoutingFunctionMap (gSimContext->routing_function_map)
 
-extern int gNumVCs;
-extern int gReadReqBeginVC, gReadReqEndVC;
-extern int gWriteReqBeginVC, gWriteReqEndVC;
-extern int gReadReplyBeginVC, gReadReplyEndVC;
-extern int gWriteReplyBeginVC, gWriteReplyEndVC;
+#define gNumVCs (gSimContext->num_vcs)
+#define gReadReqBeginVC (gSimContext->read_req_begin_vc)
+#define gReadReqEndVC (gSimContext->read_req_end_vc)
+#define gWriteReqBeginVC (gSimContext->write_req_begin_vc)
+#define gWriteReqEndVC (gSimContext->write_req_end_vc)
+#define gReadReplyBeginVC (gSimContext->read_reply_begin_vc)
+#define gReadReplyEndVC (gSimContext->read_reply_end_vc)
+#define gWriteReplyBeginVC (gSimContext->write_reply_begin_vc)
+#define gWriteReplyEndVC (gSimContext->write_reply_end_vc)
 
 #endif
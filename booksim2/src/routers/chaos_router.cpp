@@ -282,7 +282,7 @@ int ChaosRouter::_InputForOutput( int output ) const
   // return an input that prefers this output
 
   int  input;
-  int  offset = RandomInt( _inputs - 1 );
+  int  offset = _random.Int( _inputs - 1 );
   bool match  = false;
 
   for ( int i = 0; ( i < _inputs ) && ( !match ); ++i ) {
@@ -334,7 +334,7 @@ int ChaosRouter::_MultiQueueForOutput( int output ) const
   // Don't deroute MQs to the ejection channel
   if ( ( mq_oldest == -1 ) && isfull && 
        ( !_IsEjectionChan( output ) ) ) {
-    r = RandomInt( _multi_queue_size - 1 );
+    r = _random.Int( _multi_queue_size - 1 );
 
     // Find first routable multi-queue
     for ( int i = 0; i < _multi_queue_size; ++i ) {
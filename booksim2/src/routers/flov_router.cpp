@@ -41,11 +41,11 @@ FLOVRouter::FLOVRouter( Configuration const & config, Module *parent,
   for (int k = 0; k < _outputs; ++k) {
     _credit_counter[k].resize(_vcs, 0);
   }
-  _clear_credits.resize(4, false);
-  _drain_done_sent.resize(4, false);
-  _drain_tags.resize(4, false);
+  _clear_credits.resize(_num_dirs, false);
+  _drain_done_sent.resize(_num_dirs, false);
+  _drain_tags.resize(_num_dirs, false);
 
-  _handshake_buffer.resize(4);
+  _handshake_buffer.resize(_num_dirs);
 
   _flov_policy = gflov;
   /* ==== Power Gate - End ==== */
@@ -62,7 +62,7 @@ void FLOVRouter::ReadInputs( )
   /* ==== Power Gate - Begin ==== */
   _ReceiveHandshakes();
   // Should be evaluated before PowerStateEvaluate(), so put in ReadInputs()
-  _HandshakeEvaluate();
+  PROFILE_CALL(handshake, _HandshakeEvaluate());
   assert(_proc_handshakes.empty());
   /* ==== Power Gate - End ==== */
   _active = _active || have_flits || have_credits;
@@ -76,7 +76,7 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
   }
 
   // bottom row routers are always on
-  if (_id >= gNodes - gK)
+  if (IsAlwaysOn())
     assert(_power_state == power_on);
 
   /* power transition state machine */
@@ -91,7 +91,7 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
       assert(_outstanding_requests == 0);
       bool neighbor_draining_wakeup = false;
       // constraints: no 'neighbor' routers can drian/drain or drain/wakeup at the same time
-      for (int out = 0; out < 4; ++out) {
+      for (int out = 0; out < _num_dirs; ++out) {
         if (_downstream_states[out] == draining ||
             _downstream_states[out] == wakeup) {
           neighbor_draining_wakeup = true;
@@ -104,13 +104,10 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
         _drain_timer = 0;
         ++_drain_counter;
         _drain_tags.clear();
-        _drain_tags.resize(4, false);
+        _drain_tags.resize(_num_dirs, false);
         assert(_out_queue_handshakes.empty());
-        for (int out = 0; out < 4; ++out) {
-          if ((out == DIR_EAST && _id % gK == gK-1) ||
-              (out == DIR_WEST && _id % gK == 0) ||
-              (out == DIR_SOUTH && _id / gK == gK-1) ||
-              (out == DIR_NORTH && _id / gK == 0)) {
+        for (int out = 0; out < _num_dirs; ++out) {
+          if (IsEdgeOutput(out)) {
             _drain_tags[out] = true;
             continue;
           }
@@ -126,7 +123,7 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
           *gWatchOut << GetSimTime() << " | " << FullName() << " | "
             << "[G-FLOV | power-on] change from PowerOn to Draining." << endl
             << "  Drain done tags:";
-          for (int out = 0; out < 4; ++out) {
+          for (int out = 0; out < _num_dirs; ++out) {
             *gWatchOut << " " << out << ":" << (_drain_tags[out] ? "True" : "False");
           }
           *gWatchOut << endl;
@@ -143,19 +140,24 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
     ++_drain_timer;
     bool neighbor_wakeup = false;
     bool neighbor_draining = false;
-    for (int out = 0; out < 4; ++out) {
+    for (int out = 0; out < _num_dirs; ++out) {
       if (_downstream_states[out] == wakeup)
         neighbor_wakeup = true;
       if (_downstream_states[out] == draining)
-        if (out == DIR_WEST || out == DIR_NORTH) // They have higher priority
+        if (_DrainPriority(out, _logical_neighbors[out])) // They have higher priority
           neighbor_draining = true;
       if (neighbor_draining || neighbor_wakeup)
         break;
     }
-    bool drain_done = _drain_tags[0] && _drain_tags[1] &&
-      _drain_tags[2] && _drain_tags[3];
+    bool drain_done = true;
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _drain_tags[out];
     drain_done &= _in_queue_flits.empty();
     drain_done &= _crossbar_flits.empty();
+    // shared buffer policies: wait until the downstream credits fit the
+    // per-VC share the upstream router assumes after ClearCredits()
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _next_buf[out]->CanRelayCredits();
     for (int in_port = 0; in_port < _inputs; ++in_port) {
       Buffer const * const cur_buf = _buf[in_port];
       for (int vc = 0; vc < _vcs; ++vc) {
@@ -169,15 +171,12 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
     if (_wakeup_signal == true || neighbor_draining || neighbor_wakeup) {
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _idle_timer = 0;
       _drain_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
         _out_queue_handshakes[out]->new_state = power_on;
@@ -201,29 +200,23 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
       }
       _wakeup_signal = false;
     } else if (drain_done) {
-      for (int i = 0; i < 4; ++i) {
-        if ((i == DIR_EAST && _id % gK == 0) ||
-            (i == DIR_WEST && _id % gK == gK-1) ||
-            (i == DIR_SOUTH && _id / gK == 0) ||
-            (i == DIR_NORTH && _id / gK == gK-1))
+      for (int i = 0; i < _num_dirs; ++i) {
+        if (IsEdgeOutput(i ^ 1))
           continue;
         const BufferState * dest_buf = _next_buf[i];
         for (int vc = 0; vc < _vcs; ++vc) {
-          int credit_count = dest_buf->AvailableFor(vc);
+          int credit_count = dest_buf->RelayCreditsFor(vc);
           assert(credit_count >= 0);
           _credit_counter[i][vc] = credit_count;
         }
       }
       _power_state = power_off;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _off_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         int in = out;
         if (out % 2)
@@ -250,14 +243,11 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
     } else if (_drain_timer > _drain_threshold) {
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _idle_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue; // for edge routers
         _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
         _out_queue_handshakes[out]->new_state = power_on;
@@ -303,8 +293,9 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
     // don't consider draining since wakeup has higher priority
     // NOTE: can wake up at the same time, the handshake relaying is done
     // in _HandshakeEvaluate()
-    bool drain_done = _drain_tags[0] && _drain_tags[1] &&
-      _drain_tags[2] && _drain_tags[3];
+    bool drain_done = true;
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _drain_tags[out];
     drain_done &= _in_queue_flits.empty();
     ++_wakeup_timer;
     // NOTE: if I have handshake to relay, I should keep my state and delay my own handshake
@@ -315,15 +306,12 @@ void FLOVRouter::_GFLOVPowerStateEvaluate()
       _idle_timer = 0;
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       // _out_queue_handshakes don't need to be empty when it needs
       // to relay drain_tag for downstream waking up routers
       assert(_out_queue_handshakes.empty()); // the why assertion???
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_out_queue_handshakes.count(out) == 0)
           _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
@@ -355,7 +343,7 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
   }
 
   // bottom row routers are always on
-  if (_id >= gNodes - gK)
+  if (IsAlwaysOn())
     assert(_power_state == power_on);
 
   /* power transition state machine */
@@ -369,11 +357,8 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
     } else if (_router_state == false) {
       assert(_outstanding_requests == 0);
       bool neighbor_draining_wakeup_off = false;
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_neighbor_states[out] == draining ||
             _neighbor_states[out] == wakeup ||
@@ -388,13 +373,10 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
         _drain_timer = 0;
         ++_drain_counter;
         _drain_tags.clear();
-        _drain_tags.resize(4, false);
+        _drain_tags.resize(_num_dirs, false);
         assert(_out_queue_handshakes.empty());
-        for (int out = 0; out < 4; ++out) {
-          if ((out == DIR_EAST && _id % gK == gK-1) ||
-              (out == DIR_WEST && _id % gK == 0) ||
-              (out == DIR_SOUTH && _id / gK == gK-1) ||
-              (out == DIR_NORTH && _id / gK == 0)) {
+        for (int out = 0; out < _num_dirs; ++out) {
+          if (IsEdgeOutput(out)) {
             _drain_tags[out] = true;
             continue;
           }
@@ -410,7 +392,7 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
           *gWatchOut << GetSimTime() << " | " << FullName() << " | "
             << "[R-FLOV | power-on] change from PowerOn to Draining." << endl
             << "  Drain done tags:";
-          for (int out = 0; out < 4; ++out) {
+          for (int out = 0; out < _num_dirs; ++out) {
             *gWatchOut << " " << out << ":" << (_drain_tags[out] ? "True" : "False");
           }
           *gWatchOut << endl;
@@ -428,14 +410,11 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
     bool neighbor_draining = false;
     bool neighbor_off = false;
     bool neighbor_wakeup = false;
-    for (int out = 0; out < 4; ++out) {
-      if ((out == DIR_WEST && (_id % gK == 0)) ||
-          (out == DIR_NORTH && (_id / gK == 0)) ||
-          (out == DIR_EAST && (_id % gK == gK - 1)) ||
-          (out == DIR_SOUTH && (_id / gK == gK - 1)))
+    for (int out = 0; out < _num_dirs; ++out) {
+      if (IsEdgeOutput(out))
         continue;
       if (_neighbor_states[out] == draining &&
-          (out == DIR_WEST || out == DIR_NORTH)) {
+          _DrainPriority(out, NeighborID(out))) {
         neighbor_draining = true;
       } else if (_neighbor_states[out] == wakeup) {
         neighbor_wakeup = true;
@@ -443,10 +422,15 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
         neighbor_off = true;
       }
     }
-    bool drain_done = _drain_tags[0] && _drain_tags[1] &&
-      _drain_tags[2] && _drain_tags[3];
+    bool drain_done = true;
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _drain_tags[out];
     drain_done &= _in_queue_flits.empty();
     drain_done &= _crossbar_flits.empty();
+    // shared buffer policies: wait until the downstream credits fit the
+    // per-VC share the upstream router assumes after ClearCredits()
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _next_buf[out]->CanRelayCredits();
     for (int in_port = 0; in_port < _inputs; ++in_port) {
       Buffer const * const cur_buf = _buf[in_port];
       for (int vc = 0; vc < _vcs; ++vc) {
@@ -462,15 +446,12 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
       _wakeup_signal = false;
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _idle_timer = 0;
       _drain_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
         _out_queue_handshakes[out]->new_state = power_on;
@@ -496,29 +477,23 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
         *gWatchOut << endl;
       }
     } else if (drain_done) {
-      for (int i = 0; i < 4; ++i) {
-        if ((i == DIR_EAST && _id % gK == 0) ||
-            (i == DIR_WEST && _id % gK == gK-1) ||
-            (i == DIR_SOUTH && _id / gK == 0) ||
-            (i == DIR_NORTH && _id / gK == gK-1))
+      for (int i = 0; i < _num_dirs; ++i) {
+        if (IsEdgeOutput(i ^ 1))
           continue;
         const BufferState * dest_buf = _next_buf[i];
         for (int vc = 0; vc < _vcs; ++vc) {
-          int credit_count = dest_buf->AvailableFor(vc);
+          int credit_count = dest_buf->RelayCreditsFor(vc);
           assert(credit_count >= 0);
           _credit_counter[i][vc] = credit_count;
         }
       }
       _power_state = power_off;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _off_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         int in = out;
         if (out % 2)
@@ -545,14 +520,11 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
     } else if (_drain_timer > _drain_threshold) {
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       _idle_timer = 0;
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue; // for edge routers
         _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
         _out_queue_handshakes[out]->new_state = power_on;
@@ -589,11 +561,8 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
       ++_off_timer;
       bool neighbor_wakeup = false;
       bool neighbor_draining = false;
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_downstream_states[out] == wakeup) {
           neighbor_wakeup = true;
@@ -614,13 +583,10 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
         _off_timer = 0;
         ++_off_counter; // used for poewr gating overhead
         _drain_tags.clear();
-        _drain_tags.resize(4, false);
+        _drain_tags.resize(_num_dirs, false);
         assert(_out_queue_handshakes.empty());
-        for (int out = 0; out < 4; ++out) {
-          if ((out == DIR_EAST && _id % gK == gK-1) ||
-              (out == DIR_WEST && _id % gK == 0) ||
-              (out == DIR_SOUTH && _id / gK == gK-1) ||
-              (out == DIR_NORTH && _id / gK == 0)) {
+        for (int out = 0; out < _num_dirs; ++out) {
+          if (IsEdgeOutput(out)) {
             _drain_tags[out] = true;
             continue;
           }
@@ -636,7 +602,7 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
           *gWatchOut << GetSimTime() << " | " << FullName() << " | "
             << "[R-FLOV | power-off] change from PowerOff to WakeUp." << endl
             << "  Drain done tags:";
-          for (int out = 0; out < 4; ++out) {
+          for (int out = 0; out < _num_dirs; ++out) {
             *gWatchOut << " " << out << ":" << (_drain_tags[out] ? "True" : "False");
           }
           *gWatchOut << endl;
@@ -653,15 +619,16 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
         assert(cur_buf->GetState(vc) == VC::idle);
       }
     }
-    for (int out = 0; out < 4; ++out) {
+    for (int out = 0; out < _num_dirs; ++out) {
       if (_downstream_states[out] == power_off)
         _drain_tags[out] = true;
     }
     // don't consider draining since wakeup has higher priority
     // NOTE: can wake up at the same time, the handshake relaying is done
     // in _HandshakeEvaluate()
-    bool drain_done = _drain_tags[0] && _drain_tags[1] &&
-      _drain_tags[2] && _drain_tags[3];
+    bool drain_done = true;
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _drain_tags[out];
     drain_done &= _in_queue_flits.empty();
     ++_wakeup_timer;
     // NOTE: if I have handshake to relay, I should keep my state and delay my own handshake
@@ -672,15 +639,12 @@ void FLOVRouter::_RFLOVPowerStateEvaluate()
       _idle_timer = 0;
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       // _out_queue_handshakes don't need to be empty when it needs
       // to relay drain_tag for downstream waking up routers
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_out_queue_handshakes.count(out) == 0)
           _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
@@ -712,7 +676,7 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
   }
 
   // bottom row routers are always on
-  if (_id >= gNodes - gK)
+  if (IsAlwaysOn())
     assert(_power_state == power_on);
 
   /* power transition state machine */
@@ -732,15 +696,12 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
     _wakeup_signal = false;
     _power_state = power_on;
     _drain_tags.clear();
-    _drain_tags.resize(4, false);
+    _drain_tags.resize(_num_dirs, false);
     _idle_timer = 0;
     _drain_timer = 0;
     assert(_out_queue_handshakes.empty());
-    for (int out = 0; out < 4; ++out) {
-      if ((out == DIR_EAST && _id % gK == gK-1) ||
-          (out == DIR_WEST && _id % gK == 0) ||
-          (out == DIR_SOUTH && _id / gK == gK-1) ||
-          (out == DIR_NORTH && _id / gK == 0))
+    for (int out = 0; out < _num_dirs; ++out) {
+      if (IsEdgeOutput(out))
         continue;
       if (_out_queue_handshakes.count(out) == 0)
         _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
@@ -769,7 +730,7 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
     ++_off_timer;
     bool neighbor_wakeup = false;
     bool neighbor_draining = false;
-    for (int out = 0; out < 4; ++out) {
+    for (int out = 0; out < _num_dirs; ++out) {
       if (_downstream_states[out] == wakeup) {
         neighbor_wakeup = true;
         break;
@@ -790,13 +751,10 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
       _off_timer = 0;
       ++_off_counter; // used for poewr gating overhead
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       assert(_out_queue_handshakes.empty());
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0)) {
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out)) {
           _drain_tags[out] = true;
           continue;
         }
@@ -813,7 +771,7 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
         *gWatchOut << GetSimTime() << " | " << FullName() << " | "
           << "[No-FLOV | power-off] change from PowerOff to WakeUp." << endl
           << "  Drain done tags:";
-        for (int out = 0; out < 4; ++out) {
+        for (int out = 0; out < _num_dirs; ++out) {
           *gWatchOut << " " << out << ":" << (_drain_tags[out] ? "True" : "False");
         }
         *gWatchOut << endl;
@@ -832,8 +790,9 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
     // don't consider draining since wakeup has higher priority
     // NOTE: can wake up at the same time, the handshake relaying is done
     // in _HandshakeEvaluate()
-    bool drain_done = _drain_tags[0] && _drain_tags[1] &&
-      _drain_tags[2] && _drain_tags[3];
+    bool drain_done = true;
+    for (int out = 0; out < _num_dirs; ++out)
+      drain_done &= _drain_tags[out];
     drain_done &= _in_queue_flits.empty();
     ++_wakeup_timer;
     // NOTE: if I have handshake to relay, I should keep my state and delay my own handshake
@@ -844,15 +803,12 @@ void FLOVRouter::_NoFLOVPowerStateEvaluate()
       _idle_timer = 0;
       _power_state = power_on;
       _drain_tags.clear();
-      _drain_tags.resize(4, false);
+      _drain_tags.resize(_num_dirs, false);
       // _out_queue_handshakes don't need to be empty when it needs
       // to relay drain_tag for downstream waking up routers
       assert(_out_queue_handshakes.empty()); // the why assertion???
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_out_queue_handshakes.count(out) == 0)
           _out_queue_handshakes.insert(make_pair(out, Handshake::New()));
@@ -932,11 +888,8 @@ void FLOVRouter::RegressFLOVPolicy()
   if (_flov_policy == gflov) {
     _flov_policy = rflov;
     if (_power_state == power_off) {
-      for (int out = 0; out < 4; ++out) {
-        if ((out == DIR_EAST && _id % gK == gK-1) ||
-            (out == DIR_WEST && _id % gK == 0) ||
-            (out == DIR_SOUTH && _id / gK == gK-1) ||
-            (out == DIR_NORTH && _id / gK == 0))
+      for (int out = 0; out < _num_dirs; ++out) {
+        if (IsEdgeOutput(out))
           continue;
         if (_neighbor_states[out] == power_off) {
           _wakeup_signal = true;
@@ -972,8 +925,8 @@ void FLOVRouter::_InternalStep( )
 {
   /* ==== Power Gate - Begin ==== */
   if (_power_state == power_off || _power_state == wakeup) {
-    _FlovStep();
-    _OutputQueuing();
+    PROFILE_CALL(flov_step, _FlovStep());
+    PROFILE_CALL(output_queuing, _OutputQueuing());
     assert(_out_queue_handshakes.empty());
     //_active = !_out_queue_handshakes.empty() || ...
     _active = !_proc_credits.empty() || !_in_queue_flits.empty();
@@ -983,65 +936,65 @@ void FLOVRouter::_InternalStep( )
 
   if(!_active) {
     /* ==== Power Gate - Begin ==== */
-    _HandshakeResponse();
-    _OutputQueuing();
+    PROFILE_CALL(handshake, _HandshakeResponse());
+    PROFILE_CALL(output_queuing, _OutputQueuing());
     assert(_out_queue_handshakes.empty());
     /* ==== Power Gate - End ==== */
     return;
   }
 
-  _InputQueuing( );
+  PROFILE_CALL(input_queuing, _InputQueuing( ));
   bool activity = !_proc_credits.empty();
 
   if(!_route_vcs.empty())
-    _RouteEvaluate( );
+    PROFILE_CALL(route_evaluate, _RouteEvaluate( ));
   if(_vc_allocator) {
     _vc_allocator->Clear();
     if(!_vc_alloc_vcs.empty())
-      _VCAllocEvaluate( );
+      PROFILE_CALL(vc_alloc_evaluate, _VCAllocEvaluate( ));
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty())
-      _SWHoldEvaluate( );
+      PROFILE_CALL(sw_hold_evaluate, _SWHoldEvaluate( ));
   }
   _sw_allocator->Clear();
   if(_spec_sw_allocator)
     _spec_sw_allocator->Clear();
   if(!_sw_alloc_vcs.empty())
-    _SWAllocEvaluate( );
+    PROFILE_CALL(sw_alloc_evaluate, _SWAllocEvaluate( ));
   if(!_crossbar_flits.empty())
-    _SwitchEvaluate( );
+    PROFILE_CALL(switch_evaluate, _SwitchEvaluate( ));
 
   if(!_route_vcs.empty()) {
-    _RouteUpdate( );
+    PROFILE_CALL(route_update, _RouteUpdate( ));
     activity = activity || !_route_vcs.empty();
   }
   if(!_vc_alloc_vcs.empty()) {
-    _VCAllocUpdate( );
+    PROFILE_CALL(vc_alloc_update, _VCAllocUpdate( ));
     activity = activity || !_vc_alloc_vcs.empty();
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty()) {
-      _SWHoldUpdate( );
+      PROFILE_CALL(sw_hold_update, _SWHoldUpdate( ));
       activity = activity || !_sw_hold_vcs.empty();
     }
   }
   if(!_sw_alloc_vcs.empty()) {
-    _SWAllocUpdate( );
+    PROFILE_CALL(sw_alloc_update, _SWAllocUpdate( ));
     activity = activity || !_sw_alloc_vcs.empty();
   }
   if(!_crossbar_flits.empty()) {
-    _SwitchUpdate( );
+    PROFILE_CALL(switch_update, _SwitchUpdate( ));
     activity = activity || !_crossbar_flits.empty();
   }
   /* ==== Power Gate - Begin ==== */
-  _HandshakeResponse();
+  PROFILE_CALL(handshake, _HandshakeResponse());
 
   //flits are set back to RC in VC update
   _active = activity | !_route_vcs.empty();
   /* ==== Power Gate - End ==== */
 
-  _OutputQueuing( );
+  PROFILE_CALL(output_queuing, _OutputQueuing( ));
   /* ==== Power Gate - Begin ==== */
   assert(_out_queue_handshakes.empty());
   /* ==== Power Gate - End ==== */
@@ -1056,6 +1009,7 @@ void FLOVRouter::WriteOutputs( )
   _SendCredits( );
   /* ==== Power Gate - Begin ==== */
   _SendHandshakes( );
+  CongestionUpdate( );
   /* ==== Power Gate - End ==== */
 }
 
@@ -1067,7 +1021,7 @@ void FLOVRouter::WriteOutputs( )
 /* ==== Power Gate - Begin ==== */
 void FLOVRouter::_ReceiveHandshakes()
 {
-  for (int input = 0; input < 4; ++input) {
+  for (int input = 0; input < _num_dirs; ++input) {
     Handshake * const h = _input_handshakes[input]->Receive();
     if (h) {
       _proc_handshakes.push_back(make_pair(input, h));
@@ -1124,6 +1078,10 @@ void FLOVRouter::_InputQueuing( )
 
     _bufferMonitor->write(input, f) ;
 
+    if(_single_cycle && _SingleCycle(input, f)) {
+      continue;
+    }
+
     if(cur_buf->GetState(vc) == VC::idle) {
       assert(cur_buf->FrontFlit(vc) == f);
       assert(cur_buf->GetOccupancy(vc) == 1);
@@ -1248,7 +1206,7 @@ void FLOVRouter::_RouteUpdate( )
     // avoid rerouting by VCAlloc again and again
     f->rtime = GetSimTime();
 
-    if (f->dest != _id) {
+    if (NodeRouter(f->dest) != _id) {
       OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
       assert(route_set);
       set<OutputSet::sSetElement> const setlist = route_set->GetSet();
@@ -1259,7 +1217,7 @@ void FLOVRouter::_RouteUpdate( )
         const FlitChannel * channel = _output_channels[out_port];
         Router * router = channel->GetSink();
         assert(router);
-        if (f->dest == router->GetID()) {
+        if (NodeRouter(f->dest) == router->GetID()) {
           if (_neighbor_states[out_port] != power_on) { // what about draining, see the assertion below
             cout << GetSimTime() << " | router#" << _id << "'s neighbor router#"
               << router->GetID() << " is "
@@ -1343,7 +1301,7 @@ void FLOVRouter::_VCAllocUpdate( )
       const FlitChannel * channel = _output_channels[match_output];
       Router * router = channel->GetSink();
       if (router) {
-        const bool is_mc = (router->GetID() >= gNodes - gK);
+        const bool is_mc = router->IsAlwaysOn();
         if (!is_mc && (_downstream_states[match_output] == draining ||
               _downstream_states[match_output] == wakeup ||
               _downstream_states[match_output] == power_off))
@@ -1435,7 +1393,7 @@ void FLOVRouter::_VCAllocUpdate( )
         const FlitChannel * channel = _output_channels[out_port];
         Router * router = channel->GetSink();
         if (router) {
-          const bool is_mc = (router->GetID() >= gNodes - gK);
+          const bool is_mc = router->IsAlwaysOn();
           if (!is_mc && (_downstream_states[out_port] == draining ||
                 _downstream_states[out_port] == wakeup ||
                 _downstream_states[out_port] == power_off))
@@ -1578,63 +1536,14 @@ void FLOVRouter::_SWHoldUpdate( )
       f->vc = match_vc;
 
       if (f->head) {
-        int src_x = f->src / gK;
-        int src_y = f->src % gK;
-        int dest_x = f->dest / gK;
-        int dest_y = f->dest % gK;
-        int src_dest_x = abs(src_x - dest_x);
-        int src_dest_y = abs(src_y - dest_y);
-        int shortest_hops = src_dest_x + src_dest_y;
-
-        int curr_x = _id / gK;
-        int curr_y = _id % gK;
-        int curr_dest_x = abs(curr_x - dest_x);
-        int curr_dest_y = abs(curr_y - dest_y);
-        int curr_hops = curr_dest_x + curr_dest_y;
-
-        bool detour = false;
-        int neighbor_port = -1;
-
-        if (input < 4) {
-          neighbor_port = input;
-        }
-
-        if (neighbor_port >= 0) {
-          const FlitChannel *channel = _output_channels[neighbor_port];
-          Router *neighbor = channel->GetSink();
-          int prev_x = neighbor->GetID() / gK;
-          int prev_y = neighbor->GetID() % gK;
-          int prev_hops = abs(prev_x - dest_x) + abs(prev_y - dest_y);
-
-          if (prev_hops < curr_hops)
-            detour = true;
-        }
-
-        if (!detour) {
-          if (src_x <= dest_x) {
-            if (curr_x < src_x || curr_x > dest_x)
-              detour = true;
-          } else {
-            if (curr_x < dest_x || curr_x > src_x)
-              detour = true;
-          }
-          if (src_y <= dest_y) {
-            if (curr_y < src_y || curr_y > dest_y)
-              detour = true;
-          } else {
-            if (curr_y < dest_y || curr_y > src_y )
-              detour = true;
-          }
-        }
-
-        if (f->hops >= shortest_hops || detour)
-          f->misroute_hops++;
+        _CountMisroute(f, input);
       }
 
-      if(!_routing_delay && f->head) {
+      if((!_routing_delay || _single_cycle) && f->head) {
         const FlitChannel * channel = _output_channels[output];
-        const Router * router = channel->GetSink();
+        const Router * router = _LookaheadRouter(output);
         if(router) {
+          f->la_router = router->GetID();
           if(_noq) {
             if(f->watch) {
               *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -1681,37 +1590,37 @@ void FLOVRouter::_SWHoldUpdate( )
       _out_queue_credits[input]->vc.insert(vc);
 
       if(cur_buf->Empty(vc)) {
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-            << "  Cancelling held connection from input " << input
-            << "." << (expanded_input % _input_speedup)
-            << " to " << output
-            << "." << (expanded_output % _output_speedup)
-            << ": No more flits." << endl;
-        }
-        _switch_hold_vc[expanded_input] = -1;
-        _switch_hold_in[expanded_input] = -1;
-        _switch_hold_out[expanded_output] = -1;
         if(f->tail) {
           cur_buf->SetState(vc, VC::idle);
         }
-      } else {
-        Flit * const nf = cur_buf->FrontFlit(vc);
-        assert(nf);
-        assert(nf->vc == vc);
-        if(f->tail) {
-          assert(nf->head);
+        if(!f->tail || !_ChainSwitchHold(input, expanded_input, output)) {
           if(f->watch) {
             *gWatchOut << GetSimTime() << " | " << FullName() << " | "
               << "  Cancelling held connection from input " << input
               << "." << (expanded_input % _input_speedup)
               << " to " << output
               << "." << (expanded_output % _output_speedup)
-              << ": End of packet." << endl;
+              << ": No more flits." << endl;
+          }
+          _ReleaseSwitchHold(expanded_input);
+        }
+      } else {
+        Flit * const nf = cur_buf->FrontFlit(vc);
+        assert(nf);
+        assert(nf->vc == vc);
+        if(f->tail) {
+          assert(nf->head);
+          if(!_ChainSwitchHold(input, expanded_input, output)) {
+            if(f->watch) {
+              *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                << "  Cancelling held connection from input " << input
+                << "." << (expanded_input % _input_speedup)
+                << " to " << output
+                << "." << (expanded_output % _output_speedup)
+                << ": End of packet." << endl;
+            }
+            _ReleaseSwitchHold(expanded_input);
           }
-          _switch_hold_vc[expanded_input] = -1;
-          _switch_hold_in[expanded_input] = -1;
-          _switch_hold_out[expanded_output] = -1;
           if(_routing_delay) {
             cur_buf->SetState(vc, VC::routing);
             /* ==== Power Gate - Begin ==== */
@@ -1761,9 +1670,7 @@ void FLOVRouter::_SWHoldUpdate( )
           << "." << (held_expanded_output % _output_speedup)
           << ": Flit not sent." << endl;
       }
-      _switch_hold_vc[expanded_input] = -1;
-      _switch_hold_in[expanded_input] = -1;
-      _switch_hold_out[held_expanded_output] = -1;
+      _ReleaseSwitchHold(expanded_input);
       _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first,
               -1)));
     }
@@ -1915,7 +1822,7 @@ void FLOVRouter::_SWAllocUpdate( )
           const FlitChannel * channel = _output_channels[output];
           Router * router = channel->GetSink();
           if (router) {
-            const bool is_mc = (router->GetID() >= gNodes - gK);
+            const bool is_mc = router->IsAlwaysOn();
             if (!is_mc && (_downstream_states[output] == draining ||
                   _downstream_states[output] == wakeup ||
                   _downstream_states[output] == power_off)) {
@@ -1978,59 +1885,14 @@ void FLOVRouter::_SWAllocUpdate( )
       f->vc = match_vc;
 
       if (f->head) {
-        int src_x = f->src / gK;
-        int src_y = f->src % gK;
-        int dest_x = f->dest / gK;
-        int dest_y = f->dest % gK;
-        int shortest_hops = abs(src_x - dest_x) + abs(src_y - dest_y);
-
-        int curr_x = _id / gK;
-        int curr_y = _id % gK;
-        int curr_hops = abs(curr_x - dest_x) + abs(curr_y - dest_y);
-
-        bool detour = false;
-        int neighbor_port = -1;
-
-        if (input < 4) {
-          neighbor_port = input;
-        }
-
-        if (neighbor_port >= 0) {
-          const FlitChannel *channel = _output_channels[neighbor_port];
-          Router *neighbor = channel->GetSink();
-          int prev_x = neighbor->GetID() / gK;
-          int prev_y = neighbor->GetID() % gK;
-          int prev_hops = abs(prev_x - dest_x) + abs(prev_y - dest_y);
-
-          if (prev_hops < curr_hops)
-            detour = true;
-        }
-
-        if (!detour) {
-          if (src_x <= dest_x) {
-            if (curr_x < src_x || curr_x > dest_x)
-              detour = true;
-          } else {
-            if (curr_x < dest_x || curr_x > src_x)
-              detour = true;
-          }
-          if (src_y <= dest_y) {
-            if (curr_y < src_y || curr_y > dest_y)
-              detour = true;
-          } else {
-            if (curr_y < dest_y || curr_y > src_y )
-              detour = true;
-          }
-        }
-
-        if (f->hops >= shortest_hops || detour)
-          f->misroute_hops++;
+        _CountMisroute(f, input);
       }
 
-      if(!_routing_delay && f->head) {
+      if((!_routing_delay || _single_cycle) && f->head) {
         const FlitChannel * channel = _output_channels[output];
-        const Router * router = channel->GetSink();
+        const Router * router = _LookaheadRouter(output);
         if(router) {
+          f->la_router = router->GetID();
           if(_noq) {
             if(f->watch) {
               *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -2125,6 +1987,7 @@ void FLOVRouter::_SWAllocUpdate( )
             _switch_hold_vc[expanded_input] = vc;
             _switch_hold_in[expanded_input] = expanded_output;
             _switch_hold_out[expanded_output] = expanded_input;
+            _switch_hold_chain[expanded_input] = 1;
             _sw_hold_vcs.push_back(make_pair(-1, make_pair(item.second.first,
                     -1)));
           } else {
@@ -2165,7 +2028,7 @@ void FLOVRouter::_SWAllocUpdate( )
             const FlitChannel * channel = _output_channels[out_port];
             Router * router = channel->GetSink();
             if (router) {
-              const bool is_mc = (router->GetID() >= gNodes - gK);
+              const bool is_mc = router->IsAlwaysOn();
               if (!is_mc && (_downstream_states[out_port] == draining ||
                     _downstream_states[out_port] == wakeup ||
                     _downstream_states[out_port] == power_off))
@@ -2199,7 +2062,7 @@ void FLOVRouter::_SWAllocUpdate( )
           const FlitChannel * channel = _output_channels[output];
           Router * router = channel->GetSink();
           if (router) {
-            const bool is_mc = (router->GetID() >= gNodes - gK);
+            const bool is_mc = router->IsAlwaysOn();
             if (!is_mc && (_downstream_states[output] == draining ||
                   _downstream_states[output] == wakeup) && !is_mc) {
               back_to_route = true;
@@ -2327,7 +2190,7 @@ void FLOVRouter::_OutputQueuing( )
        ++iter) {
 
     int const output = iter->first;
-    assert((output >= 0) && (output < 4));
+    assert((output >= 0) && (output < _num_dirs));
 
     Handshake * const h = iter->second;
     assert(h);
@@ -2350,7 +2213,7 @@ void FLOVRouter::_OutputQueuing( )
 /* ==== Power Gate - Begin ==== */
 void FLOVRouter::_SendHandshakes()
 {
-  for (int output = 0; output < 4; ++output) {
+  for (int output = 0; output < _num_dirs; ++output) {
     if (!_handshake_buffer[output].empty()) {
       Handshake * const h = _handshake_buffer[output].front();
       assert(h);
@@ -2368,6 +2231,104 @@ void FLOVRouter::_SendHandshakes()
 //--------------------------------
 
 
+// Draining neighbor at out has higher priority. On a mesh it is the one
+// to the west/north, which is not a total order around a torus ring, so
+// the lower id wins there.
+bool FLOVRouter::_DrainPriority(int out, int neighbor) const
+{
+  return _torus ? (neighbor < _id) : (out % 2 == 1);
+}
+
+int FLOVRouter::_Hops(int src, int dest) const
+{
+  int hops = 0;
+  for (int dim = 0; dim < gN; ++dim) {
+    int dist = abs(Coordinate(src, dim) - Coordinate(dest, dim));
+    if (_torus)
+      dist = min(dist, gK - dist);
+    hops += dist;
+  }
+  return hops;
+}
+
+// a head flit is misrouted once it used up the minimal hop count, moved
+// away from its destination, or left the source/destination bounding box
+void FLOVRouter::_CountMisroute(Flit * f, int input) const
+{
+  int const src_router = NodeRouter(f->src);
+  int const dest_router = NodeRouter(f->dest);
+  int shortest_hops = _Hops(src_router, dest_router);
+  int curr_hops = _Hops(_id, dest_router);
+
+  bool detour = false;
+  if (input < _num_dirs) {
+    const Router * neighbor = _output_channels[input]->GetSink();
+    if (_Hops(neighbor->GetID(), dest_router) < curr_hops)
+      detour = true;
+  }
+
+  // wrap links make any coordinate minimal on a torus
+  if (!detour && !_torus) {
+    for (int dim = 0; dim < gN; ++dim) {
+      int src = Coordinate(src_router, dim);
+      int dest = Coordinate(dest_router, dim);
+      int curr = Coordinate(_id, dim);
+      if (curr < min(src, dest) || curr > max(src, dest)) {
+        detour = true;
+        break;
+      }
+    }
+  }
+
+  if (f->hops >= shortest_hops || detour)
+    f->misroute_hops++;
+}
+
+// same rule as SA: no new packet towards a neighbor that is not on
+bool FLOVRouter::_DownstreamAccepts(Flit const * f, int output) const
+{
+  if (f->head) {
+    const Router * router = _output_channels[output]->GetSink();
+    if (router && !router->IsAlwaysOn() &&
+        _downstream_states[output] != power_on)
+      return false;
+  }
+  return true;
+}
+
+bool FLOVRouter::_SingleCycleGrant(Flit const * f, int output) const
+{
+  return _power_state == power_on && _DownstreamAccepts(f, output);
+}
+
+bool FLOVRouter::_ChainGrant(Flit const * f, int output) const
+{
+  return _DownstreamAccepts(f, output);
+}
+
+void FLOVRouter::_SingleCycleTraverse(Flit * f, int input, int output)
+{
+  if (f->head)
+    _CountMisroute(f, input);
+}
+
+// flits fly over gated routers, look ahead to the logical neighbor
+Router * FLOVRouter::_LookaheadRouter(int output) const
+{
+  Router * router = _output_channels[output]->GetSink();
+  if (output >= _num_dirs)
+    return router;
+  int const neighbor = _logical_neighbors[output];
+  if (neighbor < 0)
+    return NULL;
+  for (int hop = 0; router && hop < gK; ++hop) {
+    if (router->GetID() == neighbor)
+      return router;
+    router = router->GetNeighborRouter(output);
+  }
+  return NULL;
+}
+
 void FLOVRouter::_FlovStep() {
   assert(_power_state == power_off || _power_state == wakeup);
   assert(_route_vcs.empty());
@@ -2383,81 +2344,12 @@ void FLOVRouter::_FlovStep() {
        iter != _in_queue_flits.end(); ++iter) {
 
     int const input = iter->first;
-    assert((input >= 0) && (input < 4));
+    assert((input >= 0) && (input < _num_dirs));
 
     Flit * const f = iter->second;
     assert(f);
 
-    int const vc = f->vc;
-    assert((vc >= 0) && (vc < _vcs));
-
-    if (f->watch) {
-      *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-      << "Bypass flit " << f->id << " to next router" << endl;
-    }
-
-    int output = input;
-    if (output % 2)
-      --output;
-    else
-      ++output;
-    assert((output >= 0) && (output < 4));
-
-    BufferState * const dest_buf = _next_buf[output];
-    if (f->head)
-      dest_buf->TakeBuffer(vc, _vcs * _inputs); // indicate its taken by flov
-    dest_buf->SendingFlit(f);
-
-    if (f->watch) {
-      *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-      << "Buffering flit " << f->id << " at output " << output << "."
-      << endl;
-    }
-    _output_buffer[output].push(f);
-
-    f->flov_hops++;
-
-    if (f->head) {
-      bool detour = false;
-
-      int src_x = f->src / gK;
-      int src_y = f->src % gK;
-      int dest_x = f->dest / gK;
-      int dest_y = f->dest % gK;
-      int shortest_hops = abs(src_x - dest_x) + abs(src_y - dest_y);
-
-      const FlitChannel *channel = _output_channels[input];
-      Router *neighbor = channel->GetSink();
-      int prev_x = neighbor->GetID() / gK;
-      int prev_y = neighbor->GetID() % gK;
-      int prev_hops = abs(prev_x - dest_x) + abs(prev_y - dest_y);
-
-      int curr_x = _id / gK;
-      int curr_y = _id % gK;
-      int curr_hops = abs(curr_x - dest_x) + abs(curr_y - dest_y);
-
-      if (prev_hops < curr_hops) {
-        detour = true;
-      } else {
-        if (src_x <= dest_x) {
-          if (curr_x < src_x || curr_x > dest_x)
-            detour = true;
-        } else {
-          if (curr_x < dest_x || curr_x > src_x)
-            detour = true;
-        }
-        if (src_y <= dest_y) {
-          if (curr_y < src_y || curr_y > dest_y)
-            detour = true;
-        } else {
-          if (curr_y < dest_y || curr_y > src_y )
-            detour = true;
-        }
-      }
-
-      if (f->hops >= shortest_hops || detour)
-        f->misroute_hops++;
-    }
+    _FlovLatch(f, input, 1);
   }
   _in_queue_flits.clear();
 
@@ -2498,17 +2390,14 @@ void FLOVRouter::_FlovStep() {
     //   1   -->   0
     //   2   -->   3
     //   3   -->   2
-    if (output < 4) {
+    if (output < _num_dirs) {
       int input = output;
       if (output % 2)
         --input;
       else
         ++input;
-      assert((input >= 0) && (input < 4));
-      if ((output == DIR_EAST && _id % gK == 0) ||
-          (output == DIR_WEST && _id % gK == gK-1) ||
-          (output == DIR_SOUTH && _id / gK == 0) ||
-          (output == DIR_NORTH && _id / gK == gK-1))
+      assert((input >= 0) && (input < _num_dirs));
+      if (IsEdgeOutput(output ^ 1))
         c->Free();
       else if (_power_state == wakeup && _downstream_states[input] == power_off)
         c->Free();
@@ -2517,12 +2406,12 @@ void FLOVRouter::_FlovStep() {
       }
     }
 
-    if (output >= 4)
+    if (output >= _num_dirs)
       c->Free();
     _proc_credits.pop_front();
   }
 
-  for (int in = 0; in < 4; ++in) {
+  for (int in = 0; in < _num_dirs; ++in) {
     int out = in;
     if (in % 2)
       --out;
@@ -2542,6 +2431,75 @@ void FLOVRouter::_FlovStep() {
   }
 }
 
+// Pass a flit through the latch towards the opposite output. With
+// multi-hop bypass it keeps going through the downstream latches in the
+// same cycle, at most smart_hpc_max links in total.
+void FLOVRouter::_FlovLatch(Flit * f, int input, int hops)
+{
+  int const vc = f->vc;
+  assert((vc >= 0) && (vc < _vcs));
+
+  if (f->watch) {
+    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+    << "Bypass flit " << f->id << " to next router" << endl;
+  }
+
+  int output = input;
+  if (output % 2)
+    --output;
+  else
+    ++output;
+  assert((output >= 0) && (output < _num_dirs));
+
+  BufferState * const dest_buf = _next_buf[output];
+  if (f->head)
+    dest_buf->TakeBuffer(vc, _vcs * _inputs); // indicate its taken by flov
+  dest_buf->SendingFlit(f);
+
+  f->flov_hops++;
+
+  if (f->head) {
+    _CountMisroute(f, input);
+  }
+
+  FLOVRouter * const next = (hops < _smart_hpc_max) ? _SmartNext(output) : NULL;
+  if (next) {
+    FlitChannel * const channel = _output_channels[output];
+    channel->Bypass(f);
+    f->smart_cycles += channel->GetLatency();
+    next->_FlovLatch(f, channel->GetSinkPort(), hops + 1);
+    return;
+  }
+
+  if (f->watch) {
+    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+    << "Buffering flit " << f->id << " at output " << output << "."
+    << endl;
+  }
+  _output_buffer[output].push(f);
+  ++_bypass_hops[hops];
+}
+
+// The setup request, sent one cycle ahead of the flit, only wins at a
+// gated-off downstream router that has no flit of its own in the latch
+// (local flits have priority), and only if nothing is still queued or in
+// flight ahead of the flit on this link.
+FLOVRouter * FLOVRouter::_SmartNext(int output) const
+{
+  if (IsEdgeOutput(output) || !_output_buffer[output].empty())
+    return NULL;
+  FlitChannel * const channel = _output_channels[output];
+  if (!channel->Empty())
+    return NULL;
+  FLOVRouter * const next = dynamic_cast<FLOVRouter *>(channel->GetSink());
+  if (!next || next->_power_state != power_off)
+    return NULL;
+  int const input = channel->GetSinkPort();
+  if (next->_in_queue_flits.count(input) || next->IsEdgeOutput(input ^ 1))
+    return NULL;
+  return next;
+}
+
 void FLOVRouter::_HandshakeEvaluate() {
   // Should be evaluated before PowerStateEvaluate(), so put in ReadInputs()
   assert(_out_queue_handshakes.empty());
@@ -2560,12 +2518,12 @@ void FLOVRouter::_HandshakeEvaluate() {
     pair<int, Handshake *> & item = (*iter);
     int const input = item.first;
     int output = input;
-    assert((input >= 0) && (input < 4));
+    assert((input >= 0) && (input < _num_dirs));
     if (output % 2)
       --output;
     else
       ++output;
-    assert((output >= 0) && (output < 4));
+    assert((output >= 0) && (output < _num_dirs));
 
     Handshake * h = item.second;
     assert(h);
@@ -2576,6 +2534,11 @@ void FLOVRouter::_HandshakeEvaluate() {
       *gWatchOut << *h;
     }
 
+    // my own handshake came back around a torus ring where every other
+    // router is off, there is no downstream router in this direction
+    if (h->id == _id)
+      continue;
+
     switch (_power_state) {
     case power_on: {
       if (src_state >= 0) {
@@ -2725,15 +2688,14 @@ void FLOVRouter::_HandshakeEvaluate() {
     // update downstream state
     if (h->new_state >= 0) {
       new_downstream_states[input] = (ePowerState) h->new_state;
-      if ((_id - h->id == -1) || (_id - h->id == 1) ||
-          (_id - h->id == -gK) || (_id - h->id == gK)) {
+      if (IsPhysicalNeighbor(h->id)) {
         assert(h->src_state >= 0);
         _neighbor_states[input] = (ePowerState) h->src_state;
       }
     }
 
     // update logical neighbor
-    if (h->logical_neighbor >= 0) {
+    if (h->logical_neighbor >= 0 && h->logical_neighbor != _id) {
       _logical_neighbors[input] = h->logical_neighbor;
     } else if (new_downstream_states[input] == power_off) {
       _logical_neighbors[input] = -1;
@@ -2746,12 +2708,12 @@ void FLOVRouter::_HandshakeEvaluate() {
     pair<int, Handshake *> const & item = _proc_handshakes.front();
     int const input = item.first;
     int output = input;
-    assert((input >= 0) && (input < 4));
+    assert((input >= 0) && (input < _num_dirs));
     if (output % 2)
       --output;
     else
       ++output;
-    assert((output >= 0) && (output < 4));
+    assert((output >= 0) && (output < _num_dirs));
 
     Handshake * h = item.second;
     assert(h);
@@ -2760,10 +2722,8 @@ void FLOVRouter::_HandshakeEvaluate() {
     if (_power_state == power_on || _power_state == draining)
       h->Free();
     else if (_power_state == wakeup) {
-      if ((input == DIR_EAST && _id % gK == 0) ||
-          (input == DIR_WEST && _id % gK == gK-1) ||
-          (input == DIR_SOUTH && _id / gK == 0) ||
-          (input == DIR_NORTH && _id / gK == gK-1)) {
+      // the last check stops a handshake going round a gated torus ring
+      if (IsEdgeOutput(input ^ 1) || h->id == _id) {
         h->Free();
       } else {
         if (h->drain_done && _drain_tags[input] &&
@@ -2818,10 +2778,7 @@ void FLOVRouter::_HandshakeEvaluate() {
       }
     } else {
       assert(_out_queue_handshakes.count(output) == 0);
-      if ((output == DIR_EAST && _id % gK == gK-1) ||
-          (output == DIR_WEST && _id % gK == 0) ||
-          (output == DIR_SOUTH && _id / gK == gK-1) ||
-          (output == DIR_NORTH && _id / gK == 0)) {
+      if (IsEdgeOutput(output) || h->id == _id) {
         h->Free();
       } else {
         if (!(_downstream_states[output] == draining || _downstream_states[output] == wakeup) && h->drain_done)
@@ -2841,7 +2798,7 @@ void FLOVRouter::_HandshakeEvaluate() {
 void FLOVRouter::_HandshakeResponse() {
   assert(_power_state == power_on || _power_state == draining);
 
-  for (int out_port = 0; out_port < 4; ++out_port) {
+  for (int out_port = 0; out_port < _num_dirs; ++out_port) {
     if (_downstream_states[out_port] == draining
         || _downstream_states[out_port] == wakeup) {
       if (_drain_done_sent[out_port])
@@ -55,6 +55,16 @@ protected:
   void _SendHandshakes( );
 
   void _FlovStep( );  // fly-over operations
+  void _FlovLatch(Flit * f, int input, int hops);
+  FLOVRouter * _SmartNext(int output) const;
+  bool _DrainPriority(int out, int neighbor) const;
+  int _Hops(int src, int dest) const;
+  void _CountMisroute(Flit * f, int input) const;
+  bool _DownstreamAccepts(Flit const * f, int output) const;
+  virtual bool _SingleCycleGrant(Flit const * f, int output) const;
+  virtual bool _ChainGrant(Flit const * f, int output) const;
+  virtual void _SingleCycleTraverse(Flit * f, int input, int output);
+  virtual Router * _LookaheadRouter(int output) const;
   void _HandshakeEvaluate();
   void _HandshakeResponse();
   void _RFLOVPowerStateEvaluate();
@@ -76,6 +86,7 @@ public:
   virtual void RegressFLOVPolicy();
   virtual inline void AggressPowerGatingPolicy() { AggressFLOVPolicy(); }
   virtual inline void RegressPowerGatingPolicy() { RegressFLOVPolicy(); }
+  virtual inline int PowerGatingLevel() const { return noflov - _flov_policy; }
   /* ==== Power Gate - End ==== */
 
   virtual void ReadInputs( );
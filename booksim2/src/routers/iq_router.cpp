@@ -44,6 +44,8 @@
 #include "buffer_state.hpp"
 #include "roundrobin_arb.hpp"
 #include "allocator.hpp"
+#include "network.hpp"
+#include "mesh_kernel.hpp"
 #include "switch_monitor.hpp"
 #include "buffer_monitor.hpp"
 
@@ -98,9 +100,19 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
     module_name.str("");
   }
 
-  // Alloc allocators
+  // Alloc allocators, on the flat arrays of the network in a baseline mesh
+  Network const * const net = dynamic_cast<Network const *>(parent);
+  MeshKernel * const mesh_kernel = net ? net->GetMeshKernel() : NULL;
+  // one iteration, as the allocators below get no configuration
+  int const alloc_iters = 1;
+
   string vc_alloc_type = config.GetStr( "vc_allocator" );
-  if(vc_alloc_type == "piggyback") {
+  if(mesh_kernel) {
+    _vc_allocator = mesh_kernel->NewAllocator( this, "vc_allocator",
+        _vcs*_inputs,
+        _vcs*_outputs,
+        alloc_iters );
+  } else if(vc_alloc_type == "piggyback") {
     if(!_speculative) {
       Error("Piggyback VC allocation requires speculative switch allocation to be enabled.");
     }
@@ -118,10 +130,17 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   }
 
   string sw_alloc_type = config.GetStr( "sw_allocator" );
-  _sw_allocator = Allocator::NewAllocator( this, "sw_allocator",
-      sw_alloc_type,
-      _inputs*_input_speedup,
-      _outputs*_output_speedup );
+  if(mesh_kernel) {
+    _sw_allocator = mesh_kernel->NewAllocator( this, "sw_allocator",
+        _inputs*_input_speedup,
+        _outputs*_output_speedup,
+        alloc_iters );
+  } else {
+    _sw_allocator = Allocator::NewAllocator( this, "sw_allocator",
+        sw_alloc_type,
+        _inputs*_input_speedup,
+        _outputs*_output_speedup );
+  }
 
   if ( !_sw_allocator ) {
     Error("Unknown sw_allocator type: " + sw_alloc_type);
@@ -157,6 +176,17 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   _noq_next_vc_start.resize(_inputs, vector<int>(_vcs, -1));
   _noq_next_vc_end.resize(_inputs, vector<int>(_vcs, -1));
 
+  _single_cycle = config.GetInt("single_cycle") > 0;
+  if(_single_cycle) {
+    string const router = config.GetStr("router");
+    if((router != "iq") && (router != "flov")) {
+      Error("Single-cycle pipeline needs router = iq or flov.");
+    }
+    if(_noq) {
+      Error("Single-cycle pipeline cannot be combined with NOQ.");
+    }
+  }
+
   // Output queues
   _output_buffer_size = config.GetInt("output_buffer_size");
   _output_buffer.resize(_outputs);
@@ -168,6 +198,22 @@ IQRouter::IQRouter( Configuration const & config, Module *parent,
   _switch_hold_out.resize(_outputs*_output_speedup, -1);
   _switch_hold_vc.resize(_inputs*_input_speedup, -1);
 
+  _packet_chain_max = config.GetInt("packet_chain_max");
+  if(_packet_chain_max < 1) {
+    Error("packet_chain_max must be at least 1.");
+  }
+  if(_packet_chain_max > 1) {
+    string const router = config.GetStr("router");
+    if((router != "iq") && (router != "flov")) {
+      Error("Packet chaining needs router = iq or flov.");
+    }
+    if(!_hold_switch_for_packet) {
+      Error("Packet chaining requires hold_switch_for_packet.");
+    }
+  }
+  _switch_hold_chain.resize(_inputs*_input_speedup, 0);
+  _packet_chains.resize(_packet_chain_max + 1, 0);
+
   _bufferMonitor = new BufferMonitor(inputs, _classes);
   _switchMonitor = new SwitchMonitor(inputs, outputs, _classes);
 
@@ -212,6 +258,9 @@ void IQRouter::AddOutputChannel(FlitChannel * channel, CreditChannel * backchann
 {
   int alloc_delay = _speculative ? max(_vc_alloc_delay, _sw_alloc_delay) : (_vc_alloc_delay + _sw_alloc_delay);
   int min_latency = 1 + _crossbar_delay + channel->GetLatency() + _routing_delay + alloc_delay + backchannel->GetLatency()  + _credit_delay;
+  if(_single_cycle) {
+    min_latency = 1 + channel->GetLatency() + backchannel->GetLatency() + _credit_delay;
+  }
   _next_buf[_output_channels.size()]->SetMinLatency(min_latency);
   Router::AddOutputChannel(channel, backchannel);
 }
@@ -229,54 +278,54 @@ void IQRouter::_InternalStep( )
     return;
   }
 
-  _InputQueuing( );
+  PROFILE_CALL(input_queuing, _InputQueuing( ));
   bool activity = !_proc_credits.empty();
 
   if(!_route_vcs.empty())
-    _RouteEvaluate( );
+    PROFILE_CALL(route_evaluate, _RouteEvaluate( ));
   if(_vc_allocator) {
     _vc_allocator->Clear();
     if(!_vc_alloc_vcs.empty())
-      _VCAllocEvaluate( );
+      PROFILE_CALL(vc_alloc_evaluate, _VCAllocEvaluate( ));
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty())
-      _SWHoldEvaluate( );
+      PROFILE_CALL(sw_hold_evaluate, _SWHoldEvaluate( ));
   }
   _sw_allocator->Clear();
   if(_spec_sw_allocator)
     _spec_sw_allocator->Clear();
   if(!_sw_alloc_vcs.empty())
-    _SWAllocEvaluate( );
+    PROFILE_CALL(sw_alloc_evaluate, _SWAllocEvaluate( ));
   if(!_crossbar_flits.empty())
-    _SwitchEvaluate( );
+    PROFILE_CALL(switch_evaluate, _SwitchEvaluate( ));
 
   if(!_route_vcs.empty()) {
-    _RouteUpdate( );
+    PROFILE_CALL(route_update, _RouteUpdate( ));
     activity = activity || !_route_vcs.empty();
   }
   if(!_vc_alloc_vcs.empty()) {
-    _VCAllocUpdate( );
+    PROFILE_CALL(vc_alloc_update, _VCAllocUpdate( ));
     activity = activity || !_vc_alloc_vcs.empty();
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty()) {
-      _SWHoldUpdate( );
+      PROFILE_CALL(sw_hold_update, _SWHoldUpdate( ));
       activity = activity || !_sw_hold_vcs.empty();
     }
   }
   if(!_sw_alloc_vcs.empty()) {
-    _SWAllocUpdate( );
+    PROFILE_CALL(sw_alloc_update, _SWAllocUpdate( ));
     activity = activity || !_sw_alloc_vcs.empty();
   }
   if(!_crossbar_flits.empty()) {
-    _SwitchUpdate( );
+    PROFILE_CALL(switch_update, _SwitchUpdate( ));
     activity = activity || !_crossbar_flits.empty();
   }
 
   _active = activity;
 
-  _OutputQueuing( );
+  PROFILE_CALL(output_queuing, _OutputQueuing( ));
 
   _bufferMonitor->cycle( );
   _switchMonitor->cycle( );
@@ -288,6 +337,26 @@ void IQRouter::WriteOutputs( )
   _SendCredits( );
 }
 
+// an idle router only has work again once a channel delivers to it
+int IQRouter::NextEventTime( ) const
+{
+  int const next = GetSimTime( ) + 1;
+  if ( _active || _regional_congestion || ( _internal_speedup != 1.0 ) ) {
+    return next;
+  }
+  for ( int output = 0; output < _outputs; ++output ) {
+    if ( !_output_buffer[output].empty( ) ) {
+      return next;
+    }
+  }
+  for ( int input = 0; input < _inputs; ++input ) {
+    if ( !_credit_buffer[input].empty( ) ) {
+      return next;
+    }
+  }
+  return numeric_limits<int>::max( );
+}
+
 
 //------------------------------------------------------------------------------
 // read inputs
@@ -376,6 +445,10 @@ void IQRouter::_InputQueuing( )
 
     _bufferMonitor->write(input, f) ;
 
+    if(_single_cycle && _SingleCycle(input, f)) {
+      continue;
+    }
+
     if(cur_buf->GetState(vc) == VC::idle) {
       assert(cur_buf->FrontFlit(vc) == f);
       assert(cur_buf->GetOccupancy(vc) == 1);
@@ -593,7 +666,7 @@ void IQRouter::_VCAllocEvaluate( )
     assert(route_set);
 
     int const out_priority = cur_buf->GetPriority(vc);
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    set<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
     bool elig = false;
     bool cred = false;
@@ -1079,10 +1152,11 @@ void IQRouter::_SWHoldUpdate( )
       f->hops++;
       f->vc = match_vc;
 
-      if(!_routing_delay && f->head) {
+      if((!_routing_delay || _single_cycle) && f->head) {
         const FlitChannel * channel = _output_channels[output];
-        const Router * router = channel->GetSink();
+        const Router * router = _LookaheadRouter(output);
         if(router) {
+          f->la_router = router->GetID();
           if(_noq) {
             if(f->watch) {
               *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -1129,37 +1203,37 @@ void IQRouter::_SWHoldUpdate( )
       _out_queue_credits.find(input)->second->vc.insert(vc);
 
       if(cur_buf->Empty(vc)) {
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | " << FullName() << " | "
-            << "  Cancelling held connection from input " << input
-            << "." << (expanded_input % _input_speedup)
-            << " to " << output
-            << "." << (expanded_output % _output_speedup)
-            << ": No more flits." << endl;
-        }
-        _switch_hold_vc[expanded_input] = -1;
-        _switch_hold_in[expanded_input] = -1;
-        _switch_hold_out[expanded_output] = -1;
         if(f->tail) {
           cur_buf->SetState(vc, VC::idle);
         }
-      } else {
-        Flit * const nf = cur_buf->FrontFlit(vc);
-        assert(nf);
-        assert(nf->vc == vc);
-        if(f->tail) {
-          assert(nf->head);
+        if(!f->tail || !_ChainSwitchHold(input, expanded_input, output)) {
           if(f->watch) {
             *gWatchOut << GetSimTime() << " | " << FullName() << " | "
               << "  Cancelling held connection from input " << input
               << "." << (expanded_input % _input_speedup)
               << " to " << output
               << "." << (expanded_output % _output_speedup)
-              << ": End of packet." << endl;
+              << ": No more flits." << endl;
+          }
+          _ReleaseSwitchHold(expanded_input);
+        }
+      } else {
+        Flit * const nf = cur_buf->FrontFlit(vc);
+        assert(nf);
+        assert(nf->vc == vc);
+        if(f->tail) {
+          assert(nf->head);
+          if(!_ChainSwitchHold(input, expanded_input, output)) {
+            if(f->watch) {
+              *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+                << "  Cancelling held connection from input " << input
+                << "." << (expanded_input % _input_speedup)
+                << " to " << output
+                << "." << (expanded_output % _output_speedup)
+                << ": End of packet." << endl;
+            }
+            _ReleaseSwitchHold(expanded_input);
           }
-          _switch_hold_vc[expanded_input] = -1;
-          _switch_hold_in[expanded_input] = -1;
-          _switch_hold_out[expanded_output] = -1;
           if(_routing_delay) {
             cur_buf->SetState(vc, VC::routing);
             _route_vcs.push_back(make_pair(-1, item.second.first));
@@ -1206,9 +1280,7 @@ void IQRouter::_SWHoldUpdate( )
           << "." << (held_expanded_output % _output_speedup)
           << ": Flit not sent." << endl;
       }
-      _switch_hold_vc[expanded_input] = -1;
-      _switch_hold_in[expanded_input] = -1;
-      _switch_hold_out[held_expanded_output] = -1;
+      _ReleaseSwitchHold(expanded_input);
       _sw_alloc_vcs.push_back(make_pair(-1, make_pair(item.second.first,
               -1)));
     }
@@ -1216,6 +1288,81 @@ void IQRouter::_SWHoldUpdate( )
   }
 }
 
+// Packet chaining: when a packet's tail leaves over a held connection,
+// another packet at the same crossbar input that already owns a VC at the
+// same output takes the connection over without switch allocation. The
+// VCs are scanned round-robin from the one just finished, and a connection
+// carries at most packet_chain_max packets before it is released.
+bool IQRouter::_ChainSwitchHold(int input, int expanded_input, int output)
+{
+  if(_switch_hold_chain[expanded_input] >= _packet_chain_max) {
+    return false;
+  }
+
+  int const held_vc = _switch_hold_vc[expanded_input];
+  assert((held_vc >= 0) && (held_vc < _vcs));
+
+  Buffer const * const cur_buf = _buf[input];
+  BufferState const * const dest_buf = _next_buf[output];
+
+  for(int i = 1; i < _vcs; ++i) {
+    int const vc = (held_vc + i) % _vcs;
+    if((vc % _input_speedup) != (held_vc % _input_speedup)) {
+      continue;
+    }
+    if((cur_buf->GetState(vc) != VC::active) || cur_buf->Empty(vc) ||
+        (cur_buf->GetOutputPort(vc) != output) ||
+        dest_buf->IsFullFor(cur_buf->GetOutputVC(vc))) {
+      continue;
+    }
+    Flit const * const f = cur_buf->FrontFlit(vc);
+    if(!_ChainGrant(f, output)) {
+      continue;
+    }
+
+    // the held input and output kept it out of this cycle's allocation
+    pair<int, int> const input_vc = make_pair(input, vc);
+    deque<pair<int, pair<pair<int, int>, int> > >::iterator iter = _sw_alloc_vcs.begin();
+    while((iter != _sw_alloc_vcs.end()) && (iter->second.first != input_vc)) {
+      ++iter;
+    }
+    assert(iter != _sw_alloc_vcs.end());
+    _sw_alloc_vcs.erase(iter);
+
+    if(f->watch) {
+      *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+        << "  Chaining held connection from input " << input
+        << "." << (expanded_input % _input_speedup)
+        << " to VC " << vc
+        << " (front: " << f->id
+        << ", chain: " << (_switch_hold_chain[expanded_input] + 1)
+        << ")." << endl;
+    }
+
+    _switch_hold_vc[expanded_input] = vc;
+    ++_switch_hold_chain[expanded_input];
+    _sw_hold_vcs.push_back(make_pair(-1, make_pair(input_vc, -1)));
+    return true;
+  }
+  return false;
+}
+
+void IQRouter::_ReleaseSwitchHold(int expanded_input)
+{
+  int const expanded_output = _switch_hold_in[expanded_input];
+  assert(expanded_output >= 0);
+  assert(_switch_hold_out[expanded_output] == expanded_input);
+
+  int const chain = _switch_hold_chain[expanded_input];
+  assert((chain >= 1) && (chain <= _packet_chain_max));
+  ++_packet_chains[chain];
+  _switch_hold_chain[expanded_input] = 0;
+
+  _switch_hold_vc[expanded_input] = -1;
+  _switch_hold_in[expanded_input] = -1;
+  _switch_hold_out[expanded_output] = -1;
+}
+
 
 //------------------------------------------------------------------------------
 // switch allocation
@@ -1397,7 +1544,7 @@ void IQRouter::_SWAllocEvaluate( )
     OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
     assert(route_set);
 
-    set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+    set<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
     assert(!_noq || (setlist.size() == 1));
 
@@ -1741,7 +1888,7 @@ void IQRouter::_SWAllocEvaluate( )
           OutputSet const * const route_set = cur_buf->GetRouteSet(vc);
           assert(route_set);
 
-          set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+          set<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
           bool busy = true;
           bool full = true;
@@ -1896,7 +2043,7 @@ void IQRouter::_SWAllocUpdate( )
         int match_prio = numeric_limits<int>::min();
 
         const OutputSet * route_set = cur_buf->GetRouteSet(vc);
-        set<OutputSet::sSetElement> const setlist = route_set->GetSet();
+        set<OutputSet::sSetElement> const & setlist = route_set->GetSet();
 
         assert(!_noq || (setlist.size() == 1));
 
@@ -1989,10 +2136,11 @@ void IQRouter::_SWAllocUpdate( )
       f->hops++;
       f->vc = match_vc;
 
-      if(!_routing_delay && f->head) {
+      if((!_routing_delay || _single_cycle) && f->head) {
         const FlitChannel * channel = _output_channels[output];
-        const Router * router = channel->GetSink();
+        const Router * router = _LookaheadRouter(output);
         if(router) {
+          f->la_router = router->GetID();
           if(_noq) {
             if(f->watch) {
               *gWatchOut << GetSimTime() << " | " << FullName() << " | "
@@ -2087,6 +2235,7 @@ void IQRouter::_SWAllocUpdate( )
             _switch_hold_vc[expanded_input] = vc;
             _switch_hold_in[expanded_input] = expanded_output;
             _switch_hold_out[expanded_output] = expanded_input;
+            _switch_hold_chain[expanded_input] = 1;
             _sw_hold_vcs.push_back(make_pair(-1, make_pair(item.second.first,
                     -1)));
           } else {
@@ -2396,3 +2545,202 @@ void IQRouter::_UpdateNOQ(int input, int vc, Flit const * f) {
     }
   }
 }
+
+//------------------------------------------------------------------------------
+// single-cycle pipeline
+//------------------------------------------------------------------------------
+
+// An arriving flit that finds its input and its output otherwise idle
+// traverses the router in the arrival cycle: heads use the lookahead route
+// and take the first free VC of the downstream buffer state, body and tail
+// flits follow the VC their head acquired. Anything else goes through the
+// regular pipeline, so conflicts cost nothing beyond the normal latency.
+bool IQRouter::_SingleCycle(int input, Flit * f)
+{
+  int const vc = f->vc;
+  Buffer * const cur_buf = _buf[input];
+
+  // no other flit buffered at, or crossing the switch from, this input
+  if(cur_buf->GetOccupancy() != 1) {
+    return false;
+  }
+  for(int s = 0; s < _input_speedup; ++s) {
+    if(_switch_hold_in[input*_input_speedup + s] >= 0) {
+      return false;
+    }
+  }
+  for(deque<pair<int, pair<Flit *, pair<int, int> > > >::const_iterator iter = _crossbar_flits.begin();
+      iter != _crossbar_flits.end();
+      ++iter) {
+    if(iter->second.second.first / _input_speedup == input) {
+      return false;
+    }
+  }
+
+  int output = -1;
+  int match_vc = -1;
+
+  if(f->head) {
+    if((cur_buf->GetState(vc) != VC::idle) || (f->la_router != GetID())) {
+      return false;
+    }
+    set<OutputSet::sSetElement> const & route = f->la_route_set.GetSet();
+    for(set<OutputSet::sSetElement>::const_iterator iter = route.begin();
+        (iter != route.end()) && (output < 0);
+        ++iter) {
+      int const out_port = iter->output_port;
+      if((out_port < 0) || !_SingleCycleOutputFree(input, out_port) ||
+          !_SingleCycleGrant(f, out_port)) {
+        continue;
+      }
+      BufferState const * const dest_buf = _next_buf[out_port];
+      for(int out_vc = iter->vc_start; out_vc <= iter->vc_end; ++out_vc) {
+        if(dest_buf->IsAvailableFor(out_vc) && !dest_buf->IsFullFor(out_vc)) {
+          output = out_port;
+          match_vc = out_vc;
+          break;
+        }
+      }
+    }
+    if(output < 0) {
+      return false;
+    }
+  } else {
+    if((cur_buf->GetState(vc) != VC::active) || (cur_buf->FrontFlit(vc) != f)) {
+      return false;
+    }
+    output = cur_buf->GetOutputPort(vc);
+    match_vc = cur_buf->GetOutputVC(vc);
+    if(!_SingleCycleOutputFree(input, output) ||
+        _next_buf[output]->IsFullFor(match_vc) ||
+        !_SingleCycleGrant(f, output)) {
+      return false;
+    }
+  }
+
+  BufferState * const dest_buf = _next_buf[output];
+
+  if(f->head) {
+    dest_buf->TakeBuffer(match_vc, input*_vcs + vc);
+    cur_buf->SetOutput(vc, output, match_vc);
+    cur_buf->SetState(vc, VC::active);
+  }
+
+  if(f->watch) {
+    *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+      << "Single-cycle traversal for flit " << f->id
+      << " from VC " << vc
+      << " at input " << input
+      << " to VC " << match_vc
+      << " at output " << output
+      << "." << endl;
+  }
+
+  cur_buf->RemoveFlit(vc);
+
+#ifdef TRACK_FLOWS
+  --_stored_flits[f->cl][input];
+  if(f->tail) --_active_packets[f->cl][input];
+#endif
+
+  _bufferMonitor->read(input, f) ;
+
+  f->hops++;
+  f->vc = match_vc;
+
+  _SingleCycleTraverse(f, input, output);
+
+  if(f->head) {
+    _UpdateLookahead(f, output);
+  }
+
+#ifdef TRACK_FLOWS
+  ++_outstanding_credits[f->cl][output];
+  _outstanding_classes[output][f->vc].push(f->cl);
+#endif
+
+  dest_buf->SendingFlit(f);
+
+  if(_out_queue_credits.count(input) == 0) {
+    _out_queue_credits.insert(make_pair(input, Credit::New()));
+  }
+  _out_queue_credits.find(input)->second->vc.insert(vc);
+
+  if(f->tail) {
+    cur_buf->SetState(vc, VC::idle);
+  }
+
+  if (_power_state == power_on || _power_state == draining)
+    _switchMonitor->traversal(input, output, f) ;
+
+  _output_buffer[output].push(f);
+
+  return true;
+}
+
+// nothing else holds, requests or is traversing the output this cycle
+bool IQRouter::_SingleCycleOutputFree(int input, int output) const
+{
+  assert((output >= 0) && (output < _outputs));
+
+  if(!_output_buffer[output].empty()) {
+    return false;
+  }
+  for(int s = 0; s < _output_speedup; ++s) {
+    if(_switch_hold_out[output*_output_speedup + s] >= 0) {
+      return false;
+    }
+  }
+  for(deque<pair<int, pair<Flit *, pair<int, int> > > >::const_iterator iter = _crossbar_flits.begin();
+      iter != _crossbar_flits.end();
+      ++iter) {
+    if(iter->second.second.second / _output_speedup == output) {
+      return false;
+    }
+  }
+
+  deque<pair<int, pair<pair<int, int>, int> > > const * const stages[] = {&_sw_hold_vcs, &_sw_alloc_vcs};
+  for(int i = 0; i < 2; ++i) {
+    for(deque<pair<int, pair<pair<int, int>, int> > >::const_iterator iter = stages[i]->begin();
+        iter != stages[i]->end();
+        ++iter) {
+      int const other = iter->second.first.first;
+      int const other_vc = iter->second.first.second;
+      Buffer const * const other_buf = _buf[other];
+      if(other_buf->GetState(other_vc) == VC::active) {
+        if(other_buf->GetOutputPort(other_vc) == output) {
+          return false;
+        }
+      } else if(other_buf->GetState(other_vc) == VC::vc_alloc) {
+        OutputSet const * const route_set = other_buf->GetRouteSet(other_vc);
+        if(route_set && !route_set->OutputEmpty(output)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+Router * IQRouter::_LookaheadRouter(int output) const
+{
+  return _output_channels[output]->GetSink();
+}
+
+void IQRouter::_UpdateLookahead(Flit * f, int output) const
+{
+  const FlitChannel * channel = _output_channels[output];
+  const Router * router = _LookaheadRouter(output);
+  if(router) {
+    f->la_router = router->GetID();
+    if(f->watch) {
+      *gWatchOut << GetSimTime() << " | " << FullName() << " | "
+        << "Updating lookahead routing information for flit " << f->id
+        << "." << endl;
+    }
+    int in_channel = channel->GetSinkPort();
+    _rf(router, f, in_channel, &f->la_route_set, false);
+  } else {
+    f->la_route_set.Clear();
+  }
+}
@@ -104,6 +104,11 @@ protected:
   vector<int> _switch_hold_out;
   vector<int> _switch_hold_vc;
 
+  int _packet_chain_max;
+  vector<int> _switch_hold_chain;
+
+  bool _single_cycle;
+
   bool _noq;
   vector<vector<int> > _noq_next_output_port;
   vector<vector<int> > _noq_next_vc_start;
@@ -120,6 +125,10 @@ protected:
 
   bool _SWAllocAddReq(int input, int vc, int output);
 
+  bool _ChainSwitchHold(int input, int expanded_input, int output);
+  void _ReleaseSwitchHold(int expanded_input);
+  virtual bool _ChainGrant(Flit const * f, int output) const { return true; }
+
   virtual void _InputQueuing( );
 
   void _RouteEvaluate( );
@@ -141,6 +150,15 @@ protected:
 
   void _UpdateNOQ(int input, int vc, Flit const * f);
 
+  // single-cycle pipeline: lookahead route, VC selection and switch
+  // traversal in the arrival cycle, regular pipeline on any conflict
+  bool _SingleCycle(int input, Flit * f);
+  bool _SingleCycleOutputFree(int input, int output) const;
+  virtual bool _SingleCycleGrant(Flit const * f, int output) const { return true; }
+  virtual void _SingleCycleTraverse(Flit * f, int input, int output) {}
+  virtual Router * _LookaheadRouter(int output) const;
+  void _UpdateLookahead(Flit * f, int output) const;
+
   // ----------------------------------------
   //
   //   Router Power Modellingyes
@@ -162,6 +180,7 @@ public:
 
   virtual void ReadInputs( );
   virtual void WriteOutputs( );
+  virtual int NextEventTime( ) const;
 
   void Display( ostream & os = cout ) const;
 
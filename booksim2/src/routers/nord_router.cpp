@@ -127,7 +127,7 @@ void NoRDRouter::ReadInputs( )
   /* ==== Power Gate - Begin ==== */
   _ReceiveHandshakes();
   // Should be evaluated before PowerStateEvaluate(), so put in ReadInputs()
-  _HandshakeEvaluate();
+  PROFILE_CALL(handshake, _HandshakeEvaluate());
   assert(_proc_handshakes.empty());
   /* ==== Power Gate - End ==== */
   _active = _active || have_flits || have_credits;
@@ -396,66 +396,66 @@ void NoRDRouter::_InternalStep( )
 {
   if(!_active) {
     /* ==== Power Gate - Begin ==== */
-    _HandshakeResponse();
-    _OutputQueuing();
+    PROFILE_CALL(handshake, _HandshakeResponse());
+    PROFILE_CALL(output_queuing, _OutputQueuing());
     assert(_out_queue_handshakes.empty());
     /* ==== Power Gate - End ==== */
     return;
   }
 
-  _InputQueuing( );
+  PROFILE_CALL(input_queuing, _InputQueuing( ));
   bool activity = !_proc_credits.empty();
 
   if(!_route_vcs.empty())
-    _RouteEvaluate( );
+    PROFILE_CALL(route_evaluate, _RouteEvaluate( ));
   if(_vc_allocator) {
     _vc_allocator->Clear();
     if(!_vc_alloc_vcs.empty())
-      _VCAllocEvaluate( );
+      PROFILE_CALL(vc_alloc_evaluate, _VCAllocEvaluate( ));
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty())
-      _SWHoldEvaluate( );
+      PROFILE_CALL(sw_hold_evaluate, _SWHoldEvaluate( ));
   }
   _sw_allocator->Clear();
   if(_spec_sw_allocator)
     _spec_sw_allocator->Clear();
   if(!_sw_alloc_vcs.empty())
-    _SWAllocEvaluate( );
+    PROFILE_CALL(sw_alloc_evaluate, _SWAllocEvaluate( ));
   if(!_crossbar_flits.empty())
-    _SwitchEvaluate( );
+    PROFILE_CALL(switch_evaluate, _SwitchEvaluate( ));
 
   if(!_route_vcs.empty()) {
-    _RouteUpdate( );
+    PROFILE_CALL(route_update, _RouteUpdate( ));
     activity = activity || !_route_vcs.empty();
   }
   if(!_vc_alloc_vcs.empty()) {
-    _VCAllocUpdate( );
+    PROFILE_CALL(vc_alloc_update, _VCAllocUpdate( ));
     activity = activity || !_vc_alloc_vcs.empty();
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty()) {
-      _SWHoldUpdate( );
+      PROFILE_CALL(sw_hold_update, _SWHoldUpdate( ));
       activity = activity || !_sw_hold_vcs.empty();
     }
   }
   if(!_sw_alloc_vcs.empty()) {
-    _SWAllocUpdate( );
+    PROFILE_CALL(sw_alloc_update, _SWAllocUpdate( ));
     activity = activity || !_sw_alloc_vcs.empty();
   }
   if(!_crossbar_flits.empty()) {
-    _SwitchUpdate( );
+    PROFILE_CALL(switch_update, _SwitchUpdate( ));
     activity = activity || !_crossbar_flits.empty();
   }
   /* ==== Power Gate - Begin ==== */
-  _HandshakeResponse();
+  PROFILE_CALL(handshake, _HandshakeResponse());
 
   //_active = activity;
   //flits are set back to RC in VC update
   _active = activity | !_route_vcs.empty();
   /* ==== Power Gate - End ==== */
 
-  _OutputQueuing( );
+  PROFILE_CALL(output_queuing, _OutputQueuing( ));
   /* ==== Power Gate - Begin ==== */
   assert(_out_queue_handshakes.empty());
   /* ==== Power Gate - End ==== */
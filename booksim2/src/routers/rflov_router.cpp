@@ -42,6 +42,9 @@ RFLOVRouter::RFLOVRouter( Configuration const & config, Module *parent,
   _drain_tags.resize(4, false);
 
   _handshake_buffer.resize(4);
+  if (gN != 2 || _torus) {
+    Error("R-FLOV router only supports 2D mesh, use router = flov");
+  }
   /* ==== Power Gate - End ==== */
 }
 
@@ -56,7 +59,7 @@ void RFLOVRouter::ReadInputs( )
   /* ==== Power Gate - Begin ==== */
   _ReceiveHandshakes();
   // Should be evaluated before PowerStateEvaluate(), so put in ReadInputs()
-  _HandshakeEvaluate();
+  PROFILE_CALL(handshake, _HandshakeEvaluate());
   assert(_proc_handshakes.empty());
   /* ==== Power Gate - End ==== */
   _active = _active || have_flits || have_credits;
@@ -149,6 +152,10 @@ void RFLOVRouter::PowerStateEvaluate()
       _drain_tags[2] && _drain_tags[3];
     drain_done &= _in_queue_flits.empty();
     drain_done &= _crossbar_flits.empty();
+    // shared buffer policies: wait until the downstream credits fit the
+    // per-VC share the upstream router assumes after ClearCredits()
+    for (int out = 0; out < 4; ++out)
+      drain_done &= _next_buf[out]->CanRelayCredits();
     for (int in_port = 0; in_port < _inputs; ++in_port) {
       Buffer const * const cur_buf = _buf[in_port];
       for (int vc = 0; vc < _vcs; ++vc) {
@@ -196,7 +203,7 @@ void RFLOVRouter::PowerStateEvaluate()
           continue;
         const BufferState * dest_buf = _next_buf[i];
         for (int vc = 0; vc < _vcs; ++vc) {
-          int credit_count = dest_buf->AvailableFor(vc);
+          int credit_count = dest_buf->RelayCreditsFor(vc);
           assert(credit_count >= 0);
           _credit_counter[i][vc] = credit_count;
         }
@@ -258,7 +265,7 @@ void RFLOVRouter::PowerStateEvaluate()
     }
     ++_power_off_cycles;
     ++_total_power_off_cycles;
-    if (_router_state) {
+    if (_router_state || _wakeup_signal) {
       ++_off_timer;
       if (_off_timer >= _bet_threshold) {
         _wakeup_signal = false;
@@ -328,8 +335,8 @@ void RFLOVRouter::_InternalStep( )
 {
   /* ==== Power Gate - Begin ==== */
   if (_power_state == power_off || _power_state == wakeup) {
-    _RFlovStep();
-    _OutputQueuing();
+    PROFILE_CALL(flov_step, _RFlovStep());
+    PROFILE_CALL(output_queuing, _OutputQueuing());
     assert(_out_queue_handshakes.empty());
     return;
   }
@@ -337,65 +344,65 @@ void RFLOVRouter::_InternalStep( )
 
   if(!_active) {
     /* ==== Power Gate - Begin ==== */
-    _HandshakeResponse();
-    _OutputQueuing();
+    PROFILE_CALL(handshake, _HandshakeResponse());
+    PROFILE_CALL(output_queuing, _OutputQueuing());
     assert(_out_queue_handshakes.empty());
     /* ==== Power Gate - End ==== */
     return;
   }
 
-  _InputQueuing( );
+  PROFILE_CALL(input_queuing, _InputQueuing( ));
   bool activity = !_proc_credits.empty();
 
   if(!_route_vcs.empty())
-    _RouteEvaluate( );
+    PROFILE_CALL(route_evaluate, _RouteEvaluate( ));
   if(_vc_allocator) {
     _vc_allocator->Clear();
     if(!_vc_alloc_vcs.empty())
-      _VCAllocEvaluate( );
+      PROFILE_CALL(vc_alloc_evaluate, _VCAllocEvaluate( ));
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty())
-      _SWHoldEvaluate( );
+      PROFILE_CALL(sw_hold_evaluate, _SWHoldEvaluate( ));
   }
   _sw_allocator->Clear();
   if(_spec_sw_allocator)
     _spec_sw_allocator->Clear();
   if(!_sw_alloc_vcs.empty())
-    _SWAllocEvaluate( );
+    PROFILE_CALL(sw_alloc_evaluate, _SWAllocEvaluate( ));
   if(!_crossbar_flits.empty())
-    _SwitchEvaluate( );
+    PROFILE_CALL(switch_evaluate, _SwitchEvaluate( ));
 
   if(!_route_vcs.empty()) {
-    _RouteUpdate( );
+    PROFILE_CALL(route_update, _RouteUpdate( ));
     activity = activity || !_route_vcs.empty();
   }
   if(!_vc_alloc_vcs.empty()) {
-    _VCAllocUpdate( );
+    PROFILE_CALL(vc_alloc_update, _VCAllocUpdate( ));
     activity = activity || !_vc_alloc_vcs.empty();
   }
   if(_hold_switch_for_packet) {
     if(!_sw_hold_vcs.empty()) {
-      _SWHoldUpdate( );
+      PROFILE_CALL(sw_hold_update, _SWHoldUpdate( ));
       activity = activity || !_sw_hold_vcs.empty();
     }
   }
   if(!_sw_alloc_vcs.empty()) {
-    _SWAllocUpdate( );
+    PROFILE_CALL(sw_alloc_update, _SWAllocUpdate( ));
     activity = activity || !_sw_alloc_vcs.empty();
   }
   if(!_crossbar_flits.empty()) {
-    _SwitchUpdate( );
+    PROFILE_CALL(switch_update, _SwitchUpdate( ));
     activity = activity || !_crossbar_flits.empty();
   }
   /* ==== Power Gate - Begin ==== */
-  _HandshakeResponse();
+  PROFILE_CALL(handshake, _HandshakeResponse());
 
   //flits are set back to RC in VC update
   _active = activity | !_route_vcs.empty();
   /* ==== Power Gate - End ==== */
 
-  _OutputQueuing( );
+  PROFILE_CALL(output_queuing, _OutputQueuing( ));
   /* ==== Power Gate - Begin ==== */
   assert(_out_queue_handshakes.empty());
   /* ==== Power Gate - End ==== */
@@ -410,6 +417,7 @@ void RFLOVRouter::WriteOutputs( )
   _SendCredits( );
   /* ==== Power Gate - Begin ==== */
   _SendHandshakes( );
+  CongestionUpdate( );
   /* ==== Power Gate - End ==== */
 }
 
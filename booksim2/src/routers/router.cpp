@@ -56,6 +56,12 @@
 /* ==== Power Gate - End ==== */
 ///////////////////////////////////////////////////////
 
+/* ==== Power Gate - Begin ==== */
+#include "routefunc.hpp"
+#include "misc_utils.hpp"
+#include "cmesh.hpp"
+/* ==== Power Gate - End ==== */
+
 /* ==== Power Gate - Begin ==== */
 const char * const Router::POWERSTATE[] = {"power-off",
   "power-on", "draining", "wakeup", "invalid"};
@@ -79,6 +85,8 @@ TimedModule( parent, name ), _id( id ), _inputs( inputs ), _outputs( outputs ),
   _output_speedup   = config.GetInt( "output_speedup" );
   _internal_speedup = config.GetFloat( "internal_speedup" );
   _classes          = config.GetInt( "classes" );
+  _profile_owner    = Profiler::Owner( config.GetStr( "router" ) + " router" );
+  _random.Key( RandomStream::router, RandomStreamId( FullName( ) ) );
 
 #ifdef TRACK_FLOWS
   _received_flits.resize(_classes, vector<int>(_inputs, 0));
@@ -115,40 +123,38 @@ TimedModule( parent, name ), _id( id ), _inputs( inputs ), _outputs( outputs ),
   _drain_timeout_counter = 0;
   _max_drain_time = 0;
   _min_drain_time = -1;
-  // XXX: only support mesh now
-  _neighbor_states.resize(4, power_on);
-  _downstream_states.resize(4, power_on);
-  _logical_neighbors.resize(4, -1);
-  _logical_neighbors[0] = _id + 1;
-  _logical_neighbors[1] = _id - 1;
-  _logical_neighbors[2] = _id + gK;
-  _logical_neighbors[3] = _id - gK;
-  // for edge routers
-  if (_id / gK == 0) {
-    _neighbor_states[3] = power_off;
-    _downstream_states[3] = power_off;
-    _logical_neighbors[3] = -1;
-  }
-  if (_id / gK == gK-1) {
-    _neighbor_states[2] = power_off;
-    _downstream_states[2] = power_off;
-    _logical_neighbors[2] = -1;
-  }
-  if (_id % gK == 0) {
-    _neighbor_states[1] = power_off;
-    _downstream_states[1] = power_off;
-    _logical_neighbors[1] = -1;
-  }
-  if (_id % gK == gK-1) {
-    _neighbor_states[0] = power_off;
-    _downstream_states[0] = power_off;
-    _logical_neighbors[0] = -1;
+  // k-ary n-cube (mesh or torus), output 2*dim goes up and 2*dim+1 goes
+  // down in dimension dim; a cmesh uses the same router grid, its edge
+  // express channels count as edges
+  _torus = (config.GetStr("topology") == "torus");
+  _cmesh = (config.GetStr("topology") == "cmesh");
+  _num_dirs = 2 * gN;
+  _neighbor_states.resize(_num_dirs, power_on);
+  _downstream_states.resize(_num_dirs, power_on);
+  _logical_neighbors.resize(_num_dirs, -1);
+  for (int out = 0; out < _num_dirs; ++out) {
+    if (IsEdgeOutput(out)) {  // for edge routers
+      _neighbor_states[out] = power_off;
+      _downstream_states[out] = power_off;
+    } else {
+      _logical_neighbors[out] = NeighborID(out);
+    }
   }
   _outstanding_requests = 0;
   _router_state = true;
-  _req_hids.resize(4, -1);
-  _resp_hids.resize(4, -1);
+  _req_hids.resize(_num_dirs, -1);
+  _resp_hids.resize(_num_dirs, -1);
   _watch_power_gating = false;
+  _regional_congestion = (config.GetInt("flov_regional_congestion") > 0);
+  _congestion.resize(_num_dirs, 0);
+  _next_congestion.resize(_num_dirs, 0);
+  _downstream_congestion.resize(_num_dirs, 0);
+  _smart_hpc_max = config.GetInt("smart_hpc_max");
+  if (_smart_hpc_max < 1)
+    Error("smart_hpc_max must be at least 1");
+  if (_smart_hpc_max > 1 && config.GetStr("router") != "flov")
+    Error("multi-hop bypass needs router = flov");
+  _bypass_hops.resize(_smart_hpc_max + 1, 0);
   /* ==== Power Gate - End ==== */
 }
 
@@ -157,6 +163,7 @@ void Router::AddInputChannel( FlitChannel *channel, CreditChannel *backchannel )
   _input_channels.push_back( channel );
   _input_credits.push_back( backchannel );
   channel->SetSink( this, _input_channels.size() - 1 ) ;
+  channel->SetReader( this );
 }
 
 void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel )
@@ -165,12 +172,14 @@ void Router::AddOutputChannel( FlitChannel *channel, CreditChannel *backchannel
   _output_credits.push_back( backchannel );
   _channel_faults.push_back( false );
   channel->SetSource( this, _output_channels.size() - 1 ) ;
+  backchannel->SetReader( this );
 }
 
 /* ==== Power Gate - Begin ==== */
 void Router::AddInputHandshake( HandshakeChannel *channel )
 {
   _input_handshakes.push_back(channel);
+  channel->SetReader( this );
 }
 
 void Router::AddOutputHandshake( HandshakeChannel *channel )
@@ -181,6 +190,9 @@ void Router::AddOutputHandshake( HandshakeChannel *channel )
 
 void Router::Evaluate( )
 {
+  /* ==== Power Gate - Begin ==== */
+  CongestionEvaluate( );
+  /* ==== Power Gate - End ==== */
   _partial_internal_cycles += _internal_speedup;
   while( _partial_internal_cycles >= 1.0 ) {
     _InternalStep( );
@@ -249,6 +261,57 @@ void Router::IdleDetected()
     ++_off_timer;
 }
 
+int Router::Coordinate(int id, int dim)
+{
+  return (id / powi(gK, dim)) % gK;
+}
+
+// the last row (plane for 3D) stays on, it carries the escape paths
+bool Router::IsAlwaysOn() const
+{
+  return Coordinate(_id, gN - 1) == gK - 1;
+}
+
+// no physical neighbor behind the output, never the case for a torus
+bool Router::IsEdgeOutput(int out_port) const
+{
+  assert((out_port >= 0) && (out_port < _num_dirs));
+  if (_torus)
+    return false;
+  int const c = Coordinate(_id, out_port / 2);
+  return (out_port % 2) ? (c == 0) : (c == gK - 1);
+}
+
+int Router::NeighborID(int out_port) const
+{
+  assert(!IsEdgeOutput(out_port));
+  int const dim = out_port / 2;
+  int const offset = powi(gK, dim);
+  int const c = Coordinate(_id, dim);
+  int const next = (out_port % 2) ? (c + gK - 1) % gK : (c + 1) % gK;
+  return _id + (next - c) * offset;
+}
+
+bool Router::IsPhysicalNeighbor(int id) const
+{
+  for (int out = 0; out < _num_dirs; ++out) {
+    if (!IsEdgeOutput(out) && NeighborID(out) == id)
+      return true;
+  }
+  return false;
+}
+
+int Router::NodeRouter(int node) const
+{
+  return _cmesh ? CMesh::NodeToRouter(node) : node;
+}
+
+// ejection ports follow the router-to-router ports
+int Router::EjectPort(int dest) const
+{
+  return _num_dirs + (_cmesh ? CMesh::NodeToPort(dest) : 0);
+}
+
 Router * Router::GetNeighborRouter(int out_port)
 {
   const FlitChannel * channel = _output_channels[out_port];
@@ -257,6 +320,37 @@ Router * Router::GetNeighborRouter(int out_port)
   return router;
 }
 
+// Regional congestion per direction: the used credits at this hop plus
+// half of what the next router in the same direction reports. A gated
+// router only forwards the value, so a FLOV bypass chain counts as one
+// hop. Evaluated from the values published last cycle, then published in
+// CongestionUpdate(), which models a one-hop-per-cycle side-band network.
+void Router::CongestionEvaluate()
+{
+  if (!_regional_congestion)
+    return;
+
+  for (int out = 0; out < _num_dirs; ++out) {
+    if (IsEdgeOutput(out)) {
+      _downstream_congestion[out] = 0;
+    } else {
+      _downstream_congestion[out] = GetNeighborRouter(out)->_congestion[out];
+    }
+    if (_power_state == power_off) {
+      _next_congestion[out] = _downstream_congestion[out];
+    } else {
+      _next_congestion[out] = GetUsedCredit(out) +
+        _downstream_congestion[out] / 2;
+    }
+  }
+}
+
+void Router::CongestionUpdate()
+{
+  if (_regional_congestion)
+    _congestion = _next_congestion;
+}
+
 void Router::SetRingOutputVCBufferSize(int vc_buf_size) {};
 /* ==== Power Gate - End ==== */
 
@@ -43,6 +43,8 @@
 #include "flitchannel.hpp"
 #include "channel.hpp"
 #include "config_utils.hpp"
+#include "profiler.hpp"
+#include "random_utils.hpp"
 
 typedef Channel<Credit> CreditChannel;
 /* ==== Power Gate - Begin ==== */
@@ -67,6 +69,8 @@ protected:
   static int const STALL_CROSSBAR_CONFLICT;
 
   int _id;
+  // routing and arbitration draws of this router
+  mutable RandomStream _random;
   /* ==== Power Gate - Begin ==== */
   int _ring_id;
   /* ==== Power Gate - End ==== */
@@ -111,6 +115,12 @@ protected:
   vector<int> _crossbar_conflict_stalls;
 #endif
 
+  // packets sent per held switch connection, index 1..packet_chain_max
+  vector<long long> _packet_chains;
+
+  // self-profile counters of this router type
+  int _profile_owner;
+
   virtual void _InternalStep() = 0;
 
   /* ==== Power Gate - Begin ==== */
@@ -150,6 +160,18 @@ protected:
   vector<int> _req_hids;
   vector<int> _resp_hids;
   bool _watch_power_gating;
+  // k-ary n-cube power-gating topology
+  bool _torus;
+  bool _cmesh;  // concentrated mesh, several nodes per router
+  int _num_dirs;
+  // regional congestion side-band, one hop per cycle
+  bool _regional_congestion;
+  vector<int> _congestion;
+  vector<int> _next_congestion;
+  vector<int> _downstream_congestion;
+  // multi-hop bypass, histogram of links crossed per bypass cycle
+  int _smart_hpc_max;
+  vector<long long> _bypass_hops;
   /* ==== Power Gate - End ==== */
 
 public:
@@ -191,6 +213,7 @@ public:
   bool IsFaultyOutput( int c ) const;
 
   inline int GetID( ) const {return _id;}
+  inline RandomStream & Random( ) const {return _random;}
 
 
   /* ==== Power Gate - Begin ==== */
@@ -272,6 +295,9 @@ public:
   }
 #endif
 
+  inline const vector<long long> & GetPacketChains() const {return _packet_chains;}
+  inline void ClearPacketChains() {_packet_chains.assign(_packet_chains.size(), 0);}
+
   inline int NumInputs() const {return _inputs;}
   inline int NumOutputs() const {return _outputs;}
 
@@ -295,6 +321,7 @@ public:
   inline int GetMinDrainTime() const {return _min_drain_time;}
   inline deque<int> GetDrainTime() const {return _drain_time_q;}
   inline double GetPowerGateOverheadCycles() const {return _off_counter*_bet_threshold;}
+  inline void CountPowerGateEvent() {++_off_counter;}
   inline void SetDrainTag(int input) {_drain_tags[input] = true;}
 
   inline void SetRouteTable(vector<int> rt_tbl) {_rt_tbl = rt_tbl;}
@@ -313,9 +340,25 @@ public:
 
   void IdleDetected();
   Router * GetNeighborRouter(int out_port);
+  static int Coordinate(int id, int dim);
+  bool IsAlwaysOn() const;
+  bool IsEdgeOutput(int out_port) const;
+  int NeighborID(int out_port) const;
+  bool IsPhysicalNeighbor(int id) const;
+  int NodeRouter(int node) const;
+  int EjectPort(int dest) const;
+
+  void CongestionEvaluate();
+  void CongestionUpdate();
+  inline bool RegionalCongestion() const {return _regional_congestion;}
+  inline int GetDownstreamCongestion(int out_port) const {return _downstream_congestion[out_port];}
+  inline const vector<long long> & GetBypassHops() const {return _bypass_hops;}
+  inline void ClearBypassHops() {_bypass_hops.assign(_bypass_hops.size(), 0);}
 
   virtual void AggressPowerGatingPolicy() {};
   virtual void RegressPowerGatingPolicy() {};
+  // how aggressively the router may gate, 0 never
+  virtual int PowerGatingLevel() const { return 0; }
   /* ==== Power Gate - End ==== */
 
 };
@@ -18,6 +18,9 @@
 #include "random_utils.hpp"
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
+/* ==== Power Gate - Begin ==== */
+#include "routetbl.hpp"
+/* ==== Power Gate - End ==== */
 
 
 RPTrafficManager::RPTrafficManager( const Configuration &config,
@@ -75,13 +78,47 @@ RPTrafficManager::RPTrafficManager( const Configuration &config,
         }
     }
 
+    /* ==== Power Gate - Begin ==== */
+    _reconfig_state = reconfig_idle;
+    _reconfig_epoch = config.GetInt("rp_reconfig_epoch");
+    _reconfig_compute_latency = config.GetInt("rp_reconfig_compute_latency");
+    _reconfig_hop_latency = config.GetInt("rp_reconfig_hop_latency");
+    _wakeup_latency = config.GetInt("wakeup_threshold");
+    double high_watermark = config.GetFloat("high_watermark");
+    double low_watermark = config.GetFloat("low_watermark");
+    double zeroload_latency = config.GetFloat("zeroload_latency");
+    _plat_high_watermark = zeroload_latency * high_watermark;
+    _plat_low_watermark = zeroload_latency * low_watermark;
+    // manually configured parking maps are treated as aggressive
+    _parking_type = (config.GetStr("powergate_type") == "rpc") ? "rpc" : "rpa";
+    _flits_in_network = 0;
+    _reconfig_timer = 0;
+    _drain_start_time = 0;
+    _distribute_start_time = 0;
+    if (_reconfig_epoch > 0 && _net[0]->GetFabricManager() < 0) {
+        Error("Router parking reconfiguration requires a fabric manager");
+    }
+    /* ==== Power Gate - End ==== */
+
     // ============ Statistics ============
 
+    /* ==== Power Gate - Begin ==== */
+    _epoch_plat = new Stats(this, "rp_epoch_plat", 1.0, 1000);
+    _reconfig_count = 0;
+    _reconfig_drain_cycles = 0.0;
+    _reconfig_distribute_cycles = 0.0;
+    _halted_cycles = 0.0;
+    _active_cycles = 0.0;
+    _halted_accepted_flits = 0.0;
+    _active_accepted_flits = 0.0;
+    /* ==== Power Gate - End ==== */
 }
 
 RPTrafficManager::~RPTrafficManager( )
 {
-
+    /* ==== Power Gate - Begin ==== */
+    delete _epoch_plat;
+    /* ==== Power Gate - End ==== */
 }
 
 
@@ -97,7 +134,7 @@ void RPTrafficManager::_GeneratePacket( int source, int stype,
     /* ==== Power Gate - End ==== */
 
     Flit::FlitType packet_type = Flit::ANY_TYPE;
-    int size = _GetNextPacketSize(cl); //input size
+    int size = _GetNextPacketSize(cl, source); //input size
     int pid = _cur_pid++;
     assert(_cur_pid);
     int packet_destination = _traffic_pattern[cl]->dest(source);
@@ -159,7 +196,7 @@ void RPTrafficManager::_GeneratePacket( int source, int stype,
     }
 
     int subnetwork = ((packet_type == Flit::ANY_TYPE) ?
-                      RandomInt(_subnets-1) :
+                      _packet_random[cl * _nodes + source].Int(_subnets-1) :
                       _subnet[packet_type]);
 
     if ( watch ) {
@@ -279,6 +316,10 @@ void RPTrafficManager::_Inject()
 
 void RPTrafficManager::_Step( )
 {
+    PROFILE_SCOPE(_profile_owner, step);
+    ProfileScope profile;
+    _ProfilePhase();
+
     bool flits_in_flight = false;
     for(int c = 0; c < _classes; ++c) {
         flits_in_flight |= !_total_in_flight_flits[c].empty();
@@ -301,8 +342,24 @@ void RPTrafficManager::_Step( )
         /* ==== Power Gate Debug - End ==== */
     }
 
+    /* ==== Power Gate - Begin ==== */
+    if (_reconfig_epoch > 0) {
+        _ReconfigStep();
+    }
+    // NIs hold new packets while the fabric manager drains the network and
+    // distributes the new routing tables
+    bool const inject_halted = (_reconfig_state == reconfig_draining) ||
+        (_reconfig_state == reconfig_distributing);
+    if (inject_halted) {
+        ++_halted_cycles;
+    } else {
+        ++_active_cycles;
+    }
+    /* ==== Power Gate - End ==== */
+
     vector<map<int, Flit *> > flits(_subnets);
 
+    profile.Start(_profile_owner, Profiler::eject);
     for ( int subnet = 0; subnet < _subnets; ++subnet ) {
         for ( int n = 0; n < _nodes; ++n ) {
             Flit * const f = _net[subnet]->ReadFlit( n );
@@ -316,6 +373,17 @@ void RPTrafficManager::_Step( )
                                << "." << endl;
                 }
                 flits[subnet].insert(make_pair(n, f));
+                /* ==== Power Gate - Begin ==== */
+                --_flits_in_network;
+                if (inject_halted) {
+                    ++_halted_accepted_flits;
+                } else {
+                    ++_active_accepted_flits;
+                }
+                if (f->tail) {
+                    _epoch_plat->AddSample(_time - f->ctime);
+                }
+                /* ==== Power Gate - End ==== */
                 if((_sim_state == warming_up) || (_sim_state == running)) {
                     ++_accepted_flits[f->cl][n];
                     if(f->tail) {
@@ -343,6 +411,7 @@ void RPTrafficManager::_Step( )
         _net[subnet]->ReadInputs( );
     }
 
+    profile.Start(_profile_owner, Profiler::inject);
     if ( !_empty_network ) {
         _Inject();
     }
@@ -394,6 +463,13 @@ void RPTrafficManager::_Step( )
                     continue;
                 }
 
+                /* ==== Power Gate - Begin ==== */
+                // packets already in flight must complete to drain
+                if(inject_halted && cf->head) {
+                    continue;
+                }
+                /* ==== Power Gate - End ==== */
+
                 if(cf->head && cf->vc == -1) { // Find first available VC
 
                     OutputSet route_set;
@@ -570,11 +646,15 @@ void RPTrafficManager::_Step( )
 #endif
 
                 _net[subnet]->WriteFlit(f, n);
+                /* ==== Power Gate - Begin ==== */
+                ++_flits_in_network;
+                /* ==== Power Gate - End ==== */
 
             }
         }
     }
 
+    profile.Start(_profile_owner, Profiler::retire);
     for(int subnet = 0; subnet < _subnets; ++subnet) {
         for(int n = 0; n < _nodes; ++n) {
             map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
@@ -608,11 +688,167 @@ void RPTrafficManager::_Step( )
         _net[subnet]->WriteOutputs( );
     }
 
+    profile.Stop();
+
     ++_time;
     assert(_time);
+    /* ==== DSENT power model - Begin ==== */
+    _PowerTraceStep();
+    /* ==== DSENT power model - End ==== */
     if(gTrace){
         cout<<"TIME "<<_time<<endl;
     }
 
 }
 
+
+/* ==== Power Gate - Begin ==== */
+void RPTrafficManager::_ReconfigStep( )
+{
+    switch (_reconfig_state) {
+    case reconfig_idle:
+        if (_time == 0 || _time % _reconfig_epoch != 0)
+            break;
+        // fabric manager decision, based on the latency of the last epoch
+        if (_epoch_plat->NumSamples() > 0) {
+            double avg_plat = _epoch_plat->Average();
+            _next_parking_type = _parking_type;
+            if (avg_plat > _plat_high_watermark) {
+                _next_parking_type = "rpc";
+            } else if (avg_plat < _plat_low_watermark) {
+                _next_parking_type = "rpa";
+            }
+            _epoch_plat->Clear();
+
+            if (_next_parking_type != _parking_type) {
+                _next_router_states =
+                    _net[0]->RouterParkingStates(_next_parking_type);
+                if (_next_router_states == _net[0]->GetRouterStates()) {
+                    _parking_type = _next_parking_type;
+                } else {
+                    // tables are computed off the critical path, traffic
+                    // keeps flowing with the old ones meanwhile
+                    _ComputeRouteTables();
+                    _reconfig_state = reconfig_computing;
+                    _reconfig_timer = _time + _reconfig_compute_latency;
+                }
+            }
+        }
+        break;
+    case reconfig_computing:
+        if (_time >= _reconfig_timer) {
+            _reconfig_state = reconfig_draining;
+            _drain_start_time = _time;
+        }
+        break;
+    case reconfig_draining:
+        if (_flits_in_network == 0 && Credit::OutStanding() == 0) {
+            // tables are sent from the fabric manager to every powered
+            // router, routers being unparked wake up in parallel
+            int const fabric_manager = _net[0]->GetFabricManager();
+            vector<bool> const & router_states = _net[0]->GetRouterStates();
+            int fx = fabric_manager % gK;
+            int fy = fabric_manager / gK;
+            int latency = 0;
+            for (int r = 0; r < _routers; ++r) {
+                if (_next_router_states[r] == false)
+                    continue;
+                int hops = abs(r % gK - fx) + abs(r / gK - fy);
+                latency = max(latency, hops * _reconfig_hop_latency);
+                if (router_states[r] == false) {
+                    latency = max(latency, _wakeup_latency);
+                }
+            }
+            _reconfig_drain_cycles += _time - _drain_start_time;
+            _reconfig_state = reconfig_distributing;
+            _distribute_start_time = _time;
+            _reconfig_timer = _time + latency;
+        }
+        break;
+    case reconfig_distributing:
+        if (_time >= _reconfig_timer) {
+            _ApplyRouterStates();
+            _reconfig_distribute_cycles += _time - _distribute_start_time;
+            ++_reconfig_count;
+            cout << GetSimTime() << " | fabric manager | "
+                 << "Router parking reconfigured from " << _parking_type
+                 << " to " << _next_parking_type
+                 << " (drain " << _distribute_start_time - _drain_start_time
+                 << " cycles, distribute " << _time - _distribute_start_time
+                 << " cycles)" << endl;
+            _parking_type = _next_parking_type;
+            _reconfig_state = reconfig_idle;
+        }
+        break;
+    }
+}
+
+void RPTrafficManager::_ComputeRouteTables( )
+{
+    int const fabric_manager = _net[0]->GetFabricManager();
+    assert(_next_router_states[fabric_manager]);
+
+    _next_rt_tbls.assign(_routers, vector<int>());
+    _next_esc_rt_tbls.assign(_routers, vector<int>());
+    for (int r = 0; r < _routers; ++r) {
+        if (_next_router_states[r] == false)
+            continue;
+        RouteTbl rt = RouteTbl(r, _routers, _next_router_states);
+        rt.BuildRoute();
+        rt.BuildEscRoute(fabric_manager);
+        _next_rt_tbls[r] = rt.GetRouteTbl();
+        _next_esc_rt_tbls[r] = rt.GetEscRouteTbl();
+    }
+}
+
+void RPTrafficManager::_ApplyRouterStates( )
+{
+    for (int subnet = 0; subnet < _subnets; ++subnet) {
+        vector<bool> & router_states = _net[subnet]->GetRouterStates();
+        const vector<Router *> & routers = _net[subnet]->GetRouters();
+        for (int r = 0; r < _routers; ++r) {
+            Router * const router = routers[r];
+            if (_next_router_states[r]) {
+                router->SetRouterState(true);
+                router->SetPowerState(Router::power_on);
+                router->SetRouteTable(_next_rt_tbls[r]);
+                router->SetEscRouteTable(_next_esc_rt_tbls[r]);
+            } else {
+                if (router_states[r]) {
+                    router->CountPowerGateEvent();
+                }
+                router->SetRouterState(false);
+                router->SetPowerState(Router::power_off);
+            }
+        }
+        router_states = _next_router_states;
+    }
+}
+
+void RPTrafficManager::DisplayOverallStats( ostream & os ) const
+{
+    TrafficManager::DisplayOverallStats(os);
+
+    if (_reconfig_epoch <= 0)
+        return;
+
+    os << "====== Router Parking Reconfiguration ======" << endl;
+    os << "Reconfigurations = " << _reconfig_count << endl;
+    if (_reconfig_count > 0) {
+        os << "Reconfiguration latency average = "
+           << (_reconfig_drain_cycles + _reconfig_distribute_cycles) / _reconfig_count
+           << " (drain = " << _reconfig_drain_cycles / _reconfig_count
+           << ", distribute = " << _reconfig_distribute_cycles / _reconfig_count
+           << ")" << endl;
+    }
+    os << "Injection halted cycles = " << _halted_cycles
+       << " (" << _halted_cycles / (_halted_cycles + _active_cycles) * 100
+       << "%)" << endl;
+    if (_halted_cycles > 0 && _active_accepted_flits > 0) {
+        double halted_rate = _halted_accepted_flits / _halted_cycles;
+        double active_rate = _active_accepted_flits / _active_cycles;
+        os << "Reconfiguration throughput loss = "
+           << (1.0 - halted_rate / active_rate) * 100 << "%" << endl;
+    }
+}
+/* ==== Power Gate - End ==== */
@@ -20,6 +20,41 @@ private:
   vector<vector<int> > _packet_size_rate;
   vector<int> _packet_size_max_val;
 
+  /* ==== Power Gate - Begin ==== */
+  // epoch-based re-parking by the fabric manager
+  enum eReconfigState { reconfig_idle, reconfig_computing, reconfig_draining,
+    reconfig_distributing };
+  eReconfigState _reconfig_state;
+  int _reconfig_epoch;
+  int _reconfig_compute_latency;
+  int _reconfig_hop_latency;
+  int _wakeup_latency;
+  double _plat_high_watermark;
+  double _plat_low_watermark;
+  string _parking_type;
+  string _next_parking_type;
+  vector<bool> _next_router_states;
+  vector<vector<int> > _next_rt_tbls;
+  vector<vector<int> > _next_esc_rt_tbls;
+  Stats * _epoch_plat;
+  int _flits_in_network;
+  int _reconfig_timer;
+  int _drain_start_time;
+  int _distribute_start_time;
+  /* ==== Power Gate - End ==== */
+
+  // ============ Statistics ============
+
+  /* ==== Power Gate - Begin ==== */
+  int _reconfig_count;
+  double _reconfig_drain_cycles;
+  double _reconfig_distribute_cycles;
+  double _halted_cycles;
+  double _active_cycles;
+  double _halted_accepted_flits;
+  double _active_accepted_flits;
+  /* ==== Power Gate - End ==== */
+
   // ============ Internal methods ============
 protected:
 
@@ -28,11 +63,22 @@ protected:
 
   virtual void _GeneratePacket( int source, int size, int cl, int time );
 
+  // the power-state machines keep running while fast-forwarding
+  virtual void _FastForwardStep( ) { _Step( ); }
+
+  /* ==== Power Gate - Begin ==== */
+  void _ReconfigStep( );
+  void _ComputeRouteTables( );
+  void _ApplyRouterStates( );
+  /* ==== Power Gate - End ==== */
+
 public:
 
   RPTrafficManager( const Configuration &config, const vector<Network *> & net );
   virtual ~RPTrafficManager( );
 
+  virtual void DisplayOverallStats( ostream & os = cout ) const ;
+
 };
 
 #endif
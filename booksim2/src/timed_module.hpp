@@ -29,11 +29,19 @@
 #define _TIMED_MODULE_HPP_
 
 #include "module.hpp"
+#include "globals.hpp"
+
+class EventWheel;
 
 class TimedModule : public Module {
 
+  EventWheel * _event_wheel;
+  int _event_id;
+  void _Schedule(int time);
+
 public:
-  TimedModule(Module * parent, string const & name) : Module(parent, name) {}
+  TimedModule(Module * parent, string const & name)
+    : Module(parent, name), _event_wheel(NULL), _event_id(-1) {}
   virtual ~TimedModule() {}
   
   virtual void ReadInputs() = 0;
@@ -42,6 +50,19 @@ public:
   /* ==== Power Gate - End ==== */
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // event kernel: the next cycle, after all phases of the current one,
+  // this module has work of its own; modules that cannot tell are
+  // evaluated every cycle
+  virtual int NextEventTime() const { return GetSimTime() + 1; }
+  void SetEventWheel(EventWheel * wheel, int id) {
+    _event_wheel = wheel;
+    _event_id = id;
+  }
+  // work handed to this module from outside, e.g. a flit sent to a channel
+  inline void Wake(int time) {
+    if(_event_wheel) _Schedule(time);
+  }
 };
 
 #endif
@@ -39,6 +39,16 @@ TrafficPattern::TrafficPattern(int nodes)
     cout << "Error: Traffic patterns require at least one node." << endl;
     exit(-1);
   }
+  _KeyRandom(0);
+}
+
+// one stream per source and traffic class
+void TrafficPattern::_KeyRandom(int cl)
+{
+  _random.resize(_nodes);
+  for(int n = 0; n < _nodes; ++n) {
+    _random[n].Key(RandomStream::traffic, cl * _nodes + n);
+  }
 }
 
 void TrafficPattern::reset()
@@ -47,7 +57,8 @@ void TrafficPattern::reset()
 }
 
 TrafficPattern * TrafficPattern::New(string const & pattern, int nodes, 
-				     Configuration const * const config)
+				     Configuration const * const config,
+				     int cl)
 {
   string pattern_name;
   string param_str;
@@ -179,9 +190,10 @@ TrafficPattern * TrafficPattern::New(string const & pattern, int nodes,
       params.push_back("-1");
     } 
     vector<int> hotspots = tokenize_int(params[0]);
+    RandomStream random(RandomStream::hotspot, cl);
     for(size_t i = 0; i < hotspots.size(); ++i) {
       if(hotspots[i] < 0) {
-	hotspots[i] = RandomInt(nodes - 1);
+	hotspots[i] = random.Int(nodes - 1);
       }
     }
     vector<int> rates;
@@ -196,6 +208,9 @@ TrafficPattern * TrafficPattern::New(string const & pattern, int nodes,
     cout << "Error: Unknown traffic pattern: " << pattern << endl;
     exit(-1);
   }
+  if(cl != 0) {
+    result->_KeyRandom(cl);
+  }
   return result;
 }
 
@@ -355,11 +370,13 @@ void RandomPermutationTrafficPattern::randomize(int seed)
   vector<double> save_u;
   SaveRandomState(save_x, save_u);
   RandomSeed(seed);
+  RandomStream random;
+  random.Key(RandomStream::permutation, 0, seed);
 
   _dest.assign(_nodes, -1);
 
   for(int i = 0; i < _nodes; ++i) {
-    int ind = RandomInt(_nodes - 1 - i);
+    int ind = random.Int(_nodes - 1 - i);
 
     int j = 0;
     int cnt = 0;
@@ -399,7 +416,7 @@ UniformRandomTrafficPattern::UniformRandomTrafficPattern(int nodes)
 int UniformRandomTrafficPattern::dest(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  return RandomInt(_nodes - 1);
+  return _random[source].Int(_nodes - 1);
 }
 
 UniformBackgroundTrafficPattern::UniformBackgroundTrafficPattern(int nodes, vector<int> excluded_nodes)
@@ -419,7 +436,7 @@ int UniformBackgroundTrafficPattern::dest(int source)
   int result;
 
   do {
-    result = RandomInt(_nodes - 1);
+    result = _random[source].Int(_nodes - 1);
   } while(_excluded.count(result) > 0);
 
   return result;
@@ -434,7 +451,7 @@ DiagonalTrafficPattern::DiagonalTrafficPattern(int nodes)
 int DiagonalTrafficPattern::dest(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  return ((RandomInt(2) == 0) ? ((source + 1) % _nodes) : source);
+  return ((_random[source].Int(2) == 0) ? ((source + 1) % _nodes) : source);
 }
 
 AsymmetricTrafficPattern::AsymmetricTrafficPattern(int nodes)
@@ -447,7 +464,7 @@ int AsymmetricTrafficPattern::dest(int source)
 {
   assert((source >= 0) && (source < _nodes));
   int const half = _nodes / 2;
-  return (source % half) + (RandomInt(1) ? half : 0);
+  return (source % half) + (_random[source].Int(1) ? half : 0);
 }
 
 Taper64TrafficPattern::Taper64TrafficPattern(int nodes)
@@ -463,10 +480,10 @@ Taper64TrafficPattern::Taper64TrafficPattern(int nodes)
 int Taper64TrafficPattern::dest(int source)
 {
   assert((source >= 0) && (source < _nodes));
-  if(RandomInt(1)) {
-    return ((64 + source + 8 * (RandomInt(2) - 1) + (RandomInt(2) - 1)) % 64);
+  if(_random[source].Int(1)) {
+    return ((64 + source + 8 * (_random[source].Int(2) - 1) + (_random[source].Int(2) - 1)) % 64);
   } else {
-    return RandomInt(_nodes - 1);
+    return _random[source].Int(_nodes - 1);
   }
 }
 
@@ -483,7 +500,7 @@ int BadPermDFlyTrafficPattern::dest(int source)
   int const grp_size_routers = 2 * _k;
   int const grp_size_nodes = grp_size_routers * _k;
 
-  return ((RandomInt(grp_size_nodes - 1) + ((source / grp_size_nodes) + 1) * grp_size_nodes) % _nodes);
+  return ((_random[source].Int(grp_size_nodes - 1) + ((source / grp_size_nodes) + 1) * grp_size_nodes) % _nodes);
 }
 
 BadPermYarcTrafficPattern::BadPermYarcTrafficPattern(int nodes, int k, int n, 
@@ -497,7 +514,7 @@ int BadPermYarcTrafficPattern::dest(int source)
 {
   assert((source >= 0) && (source < _nodes));
   int const row = source / (_xr * _k);
-  return RandomInt((_xr * _k) - 1) * (_xr * _k) + row;
+  return _random[source].Int((_xr * _k) - 1) * (_xr * _k) + row;
 }
 
 HotSpotTrafficPattern::HotSpotTrafficPattern(int nodes, vector<int> hotspots, 
@@ -524,7 +541,7 @@ int HotSpotTrafficPattern::dest(int source)
     return _hotspots[0];
   }
 
-  int pct = RandomInt(_max_val);
+  int pct = _random[source].Int(_max_val);
 
   for(size_t i = 0; i < (_hotspots.size() - 1); ++i) {
     int const limit = _rates[i];
@@ -31,19 +31,23 @@
 #include <vector>
 #include <set>
 #include "config_utils.hpp"
+#include "random_utils.hpp"
 
 using namespace std;
 
 class TrafficPattern {
 protected:
   int _nodes;
+  vector<RandomStream> _random;
   TrafficPattern(int nodes);
+  void _KeyRandom(int cl);
 public:
   virtual ~TrafficPattern() {}
   virtual void reset();
   virtual int dest(int source) = 0;
   static TrafficPattern * New(string const & pattern, int nodes, 
-			      Configuration const * const config = NULL);
+			      Configuration const * const config = NULL,
+			      int cl = 0);
 };
 
 class PermutationTrafficPattern : public TrafficPattern {
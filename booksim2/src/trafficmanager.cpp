@@ -31,6 +31,10 @@
 #include <limits>
 #include <cstdlib>
 #include <ctime>
+#include <iomanip>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 
 #include "booksim.hpp"
 #include "booksim_config.hpp"
@@ -42,6 +46,7 @@
 #include "nordtrafficmanager.hpp"
 /* ==== Power Gate - End ==== */
 #include "random_utils.hpp"
+#include "misc_utils.hpp"
 #include "vc.hpp"
 #include "packet_reply_info.hpp"
 
@@ -117,7 +122,7 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     }
     _rf = rf_iter->second;
 
-    _lookahead_routing = !config.GetInt("routing_delay");
+    _lookahead_routing = !config.GetInt("routing_delay") || config.GetInt("single_cycle");
     _noq = config.GetInt("noq");
     if(_noq) {
         if(!_lookahead_routing) {
@@ -240,9 +245,22 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
 
     _injection_process.resize(_classes);
 
+    int seed;
+    if(config.GetStr("seed") == "time") {
+      seed = int(time(NULL));
+      cout << "SEED: seed=" << seed << endl;
+    } else {
+      seed = config.GetInt("seed");
+    }
+    gSimContext->random_seed = seed;
+
+    _packet_random.resize(_classes * _nodes);
     for(int c = 0; c < _classes; ++c) {
-        _traffic_pattern[c] = TrafficPattern::New(_traffic[c], _nodes, &config);
-        _injection_process[c] = InjectionProcess::New(injection_process[c], _nodes, _load[c], &config);
+        _traffic_pattern[c] = TrafficPattern::New(_traffic[c], _nodes, &config, c);
+        _injection_process[c] = InjectionProcess::New(injection_process[c], _nodes, _load[c], &config, c);
+        for(int n = 0; n < _nodes; ++n) {
+            _packet_random[c * _nodes + n].Key(RandomStream::packet, c * _nodes + n);
+        }
     }
 
     // ============ Injection VC states  ============
@@ -312,16 +330,73 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     }
 
     //seed the network
-    int seed;
-    if(config.GetStr("seed") == "time") {
-      seed = int(time(NULL));
-      cout << "SEED: seed=" << seed << endl;
-    } else {
-      seed = config.GetInt("seed");
-    }
     RandomSeed(seed);
+    _seed = seed;
+
+    _replications = config.GetInt("replications");
+    _replication_workers = config.GetInt("replication_workers");
+    _replication_min = config.GetInt("replication_min");
+    _replication_ci = config.GetFloat("replication_ci");
+    _replication_confidence = config.GetFloat("replication_confidence");
+    _replication_log = config.GetStr("replication_log");
+    _replication_cancel = false;
+    _replication_stop = NULL;
+    _replications_failed = 0;
+    if (_replications > 1) {
+        _replication_config = config;
+    }
+    if ((_replication_confidence <= 0.0) || (_replication_confidence >= 1.0)) {
+        Error("replication_confidence must be between 0 and 1");
+    }
+
+    _sampling = (config.GetInt("sampling") > 0);
+    _sampling_windows = config.GetInt("sampling_windows");
+    _sampling_warmup = config.GetInt("sampling_warmup");
+    _sampling_window = config.GetInt("sampling_window");
+    _sampling_interval = config.GetInt("sampling_interval");
+    _sampling_confidence = config.GetFloat("sampling_confidence");
+    _detailed_cycles = 0;
+    _ffwd_latency.resize(_classes, 0.0);
+    _ffwd_packets.resize(_classes, 0);
+    _ffwd_flits.resize(_classes, 0);
+    _ffwd_latency_sum.resize(_classes, 0.0);
+    if (_sampling) {
+        if (_total_sims != 1) {
+            Error("sampling requires sim_count = 1");
+        }
+        if (config.GetStr("sim_type") == "batch") {
+            Error("sampling does not support batch simulations");
+        }
+        if ((_sampling_windows < 1) || (_sampling_window < 1) ||
+            (_sampling_warmup < 0) || (_sampling_interval < 0)) {
+            Error("sampling needs at least one window of at least one cycle");
+        }
+        if ((_sampling_confidence <= 0.0) || (_sampling_confidence >= 1.0)) {
+            Error("sampling_confidence must be between 0 and 1");
+        }
+    }
+
+    _event_kernel = (config.GetInt("event_kernel") > 0);
+    // replies and packets drawn ahead would reorder a shared stream
+    _event_skip = _event_kernel && gSimContext->random_streams;
+    for (int c = 0; c < _classes; ++c) {
+        _event_skip = _event_skip && !_use_read_write[c];
+    }
+    _skipped_cycles = 0;
+    if (_event_kernel) {
+        string const sim_type = config.GetStr("sim_type");
+        if ((sim_type != "latency") && (sim_type != "throughput") &&
+            (sim_type != "batch")) {
+            Error("event_kernel does not support sim_type = " + sim_type);
+        }
+        string const router = config.GetStr("router");
+        if ((router != "iq") && (router != "event") && (router != "chaos")) {
+            Error("event_kernel does not support router = " + router);
+        }
+    }
 
     _measure_latency = (config.GetStr("sim_type") == "latency");
+    _profile_owner = Profiler::Owner(config.GetStr("sim_type") + " traffic manager");
 
     _sample_period = config.GetInt( "sample_period" );
     _max_samples    = config.GetInt( "max_samples" );
@@ -398,6 +473,27 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
         config.WriteMatlabFile(_stats_out);
     }
 
+    /* ==== DSENT power model - Begin ==== */
+    _power_trace_epoch = config.GetInt("power_trace_epoch");
+    _power_trace_out = NULL;
+    if (_power_trace_epoch > 0) {
+        if (!config.GetInt("sim_power") || !config.GetInt("dsent_model")) {
+            Error("power_trace_epoch requires sim_power and dsent_model");
+        }
+        string power_trace_file = config.GetStr("power_trace_file");
+        if (power_trace_file == "-") {
+            _power_trace_out = &cout;
+        } else {
+            _power_trace_out = new ofstream(power_trace_file.c_str());
+        }
+        _power_trace.resize(_subnets);
+        for (int subnet = 0; subnet < _subnets; ++subnet) {
+            _power_trace[subnet] = new DSENT_Power_Module(_net[subnet], config);
+            _power_trace[subnet]->TraceHeader(*_power_trace_out);
+        }
+    }
+    /* ==== DSENT power model - End ==== */
+
 #ifdef TRACK_FLOWS
     _injected_flits.resize(_classes, vector<int>(_nodes, 0));
     _ejected_flits.resize(_classes, vector<int>(_nodes, 0));
@@ -497,6 +593,9 @@ TrafficManager::TrafficManager( const Configuration &config, const vector<Networ
     _hop_stats.resize(_classes);
     _overall_hop_stats.resize(_classes, 0.0);
 
+    _packet_chain_max = config.GetInt("packet_chain_max");
+    _overall_packet_chains.resize(_packet_chain_max + 1, 0);
+
     _sent_packets.resize(_classes);
     _overall_min_sent_packets.resize(_classes, 0.0);
     _overall_avg_sent_packets.resize(_classes, 0.0);
@@ -634,6 +733,12 @@ TrafficManager::~TrafficManager( )
 
     if(gWatchOut && (gWatchOut != &cout)) delete gWatchOut;
     if(_stats_out && (_stats_out != &cout)) delete _stats_out;
+    /* ==== DSENT power model - Begin ==== */
+    for (size_t i = 0; i < _power_trace.size(); ++i) {
+        delete _power_trace[i];
+    }
+    if(_power_trace_out && (_power_trace_out != &cout)) delete _power_trace_out;
+    /* ==== DSENT power model - End ==== */
 
 #ifdef TRACK_FLOWS
     if(_injected_flits_out) delete _injected_flits_out;
@@ -785,7 +890,7 @@ int TrafficManager::_IssuePacket( int source, int cl )
             if(_injection_process[cl]->test(source)) {
 
                 //coin toss to determine request type.
-                result = (RandomFloat() < _write_fraction[cl]) ? 2 : 1;
+                result = (_packet_random[cl * _nodes + source].Float() < _write_fraction[cl]) ? 2 : 1;
 
                 _requestsOutstanding[source]++;
             }
@@ -811,7 +916,7 @@ void TrafficManager::_GeneratePacket( int source, int stype,
     /* ==== Power Gate - End ==== */
 
     Flit::FlitType packet_type = Flit::ANY_TYPE;
-    int size = _GetNextPacketSize(cl); //input size
+    int size = _GetNextPacketSize(cl, source); //input size
     int pid = _cur_pid++;
     assert(_cur_pid);
     int packet_destination = _traffic_pattern[cl]->dest(source);
@@ -873,7 +978,7 @@ void TrafficManager::_GeneratePacket( int source, int stype,
     }
 
     int subnetwork = ((packet_type == Flit::ANY_TYPE) ?
-                      RandomInt(_subnets-1) :
+                      _packet_random[cl * _nodes + source].Int(_subnets-1) :
                       _subnet[packet_type]);
 
     if ( watch ) {
@@ -993,6 +1098,10 @@ void TrafficManager::_Inject(){
 
 void TrafficManager::_Step( )
 {
+    PROFILE_SCOPE(_profile_owner, step);
+    ProfileScope profile;
+    _ProfilePhase();
+
     bool flits_in_flight = false;
     for(int c = 0; c < _classes; ++c) {
         flits_in_flight |= !_total_in_flight_flits[c].empty();
@@ -1004,6 +1113,7 @@ void TrafficManager::_Step( )
 
     vector<map<int, Flit *> > flits(_subnets);
 
+    profile.Start(_profile_owner, Profiler::eject);
     for ( int subnet = 0; subnet < _subnets; ++subnet ) {
         for ( int n = 0; n < _nodes; ++n ) {
             Flit * const f = _net[subnet]->ReadFlit( n );
@@ -1044,6 +1154,7 @@ void TrafficManager::_Step( )
         _net[subnet]->ReadInputs( );
     }
 
+    profile.Start(_profile_owner, Profiler::inject);
     if ( !_empty_network ) {
         _Inject();
     }
@@ -1206,6 +1317,7 @@ void TrafficManager::_Step( )
                             assert(router);
                             int in_channel = inject->GetSinkPort();
                             _rf(router, f, in_channel, &f->la_route_set, false);
+                            f->la_router = router->GetID();
                             if(f->watch) {
                                 *gWatchOut << GetSimTime() << " | "
                                            << "node" << n << " | "
@@ -1276,6 +1388,7 @@ void TrafficManager::_Step( )
         }
     }
 
+    profile.Start(_profile_owner, Profiler::retire);
     for(int subnet = 0; subnet < _subnets; ++subnet) {
         for(int n = 0; n < _nodes; ++n) {
             map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
@@ -1306,14 +1419,99 @@ void TrafficManager::_Step( )
         _net[subnet]->WriteOutputs( );
     }
 
+    profile.Stop();
+
     ++_time;
     assert(_time);
+    /* ==== DSENT power model - Begin ==== */
+    _PowerTraceStep();
+    /* ==== DSENT power model - End ==== */
     if(gTrace){
         cout<<"TIME "<<_time<<endl;
     }
 
 }
 
+// ============ event kernel ============
+// One cycle, or all cycles up to the next one with work, at most to end:
+// no flit waits at a source, no channel or router of the networks is due
+// and the injection processes, drawn ahead, do not fire in between.
+
+void TrafficManager::_Advance( int end )
+{
+    if ( !_event_skip || _empty_network || gTrace ) {
+        _Step( );
+        return;
+    }
+
+    int next = end;
+    if ( _power_trace_epoch > 0 ) {
+        next = min( next, ( _time / _power_trace_epoch + 1 ) * _power_trace_epoch );
+    }
+    next = min( next, _NextNetworkEvent( ) );
+
+    vector<bool> & core_states = _net[0]->GetCoreStates();
+    for ( int input = 0; ( input < _nodes ) && ( next > _time ); ++input ) {
+        if ( core_states[input] == false ) {
+            continue;
+        }
+        for ( int c = 0; ( c < _classes ) && ( next > _time ); ++c ) {
+            if ( !_partial_packets[input][c].empty( ) ||
+                 ( _qtime[input][c] != _time ) ) {
+                next = _time;
+                break;
+            }
+            int const fail = _injection_process[c]->lookahead( input, next - _time );
+            if ( fail >= 0 ) {
+                next = _time + fail;
+            }
+        }
+    }
+    if ( next <= _time ) {
+        _Step( );
+        return;
+    }
+
+    int const cycles = next - _time;
+    for ( int input = 0; input < _nodes; ++input ) {
+        if ( core_states[input] == false ) {
+            continue;
+        }
+        for ( int c = 0; c < _classes; ++c ) {
+            _injection_process[c]->skip( input, cycles );
+            _requestsOutstanding[input] += cycles;
+            _qtime[input][c] = next;
+            if ( ( _sim_state == draining ) && ( next > _drain_time ) ) {
+                _qdrained[input][c] = true;
+            }
+        }
+    }
+    if ( _FlitsInFlight( ) ) {
+        for ( int i = 0; i < cycles; ++i ) {
+            if ( _deadlock_timer++ >= _deadlock_warn_timeout ) {
+                _deadlock_timer = 0;
+                cout << "WARNING: Possible network deadlock.\n";
+            }
+        }
+    }
+    _skipped_cycles += cycles;
+    _time = next;
+    /* ==== DSENT power model - Begin ==== */
+    _PowerTraceStep();
+    /* ==== DSENT power model - End ==== */
+}
+
+// the next cycle with work in any subnet, the next cycle without the
+// event kernel
+int TrafficManager::_NextNetworkEvent( ) const
+{
+    int next = numeric_limits<int>::max();
+    for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+        next = min( next, _net[subnet]->NextEventTime( ) );
+    }
+    return next;
+}
+
 bool TrafficManager::_PacketsOutstanding( ) const
 {
     for ( int c = 0; c < _classes; ++c ) {
@@ -1377,10 +1575,58 @@ void TrafficManager::_ClearStats( )
         _hop_stats[c]->Clear();
 
     }
+    _ClearPacketChains();
 
     _reset_time = _time;
 }
 
+void TrafficManager::_ClearPacketChains( )
+{
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+        for(int router = 0; router < _routers; ++router) {
+            _router[subnet][router]->ClearPacketChains();
+        }
+    }
+}
+
+void TrafficManager::_UpdatePacketChains( )
+{
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+        for(int router = 0; router < _routers; ++router) {
+            vector<long long> const & chains = _router[subnet][router]->GetPacketChains();
+            for(size_t n = 0; n < chains.size(); ++n) {
+                _overall_packet_chains[n] += chains[n];
+            }
+        }
+    }
+}
+
+void TrafficManager::_DisplayPacketChains( ostream & os ) const
+{
+    if(_packet_chain_max <= 1) {
+        return;
+    }
+    long long connections = 0;
+    long long packets = 0;
+    for(int n = 1; n <= _packet_chain_max; ++n) {
+        connections += _overall_packet_chains[n];
+        packets += n * _overall_packet_chains[n];
+    }
+    os << "====== Packet Chaining (max = " << _packet_chain_max << ") ======" << endl;
+    os << "Held connections = " << connections << endl;
+    if(connections > 0) {
+        os << "Packets per connection average = " << (double)packets / (double)connections << endl;
+    }
+    for(int n = 1; n <= _packet_chain_max; ++n) {
+        os << "\t" << n << " packet" << (n > 1 ? "s" : " ") << " = "
+           << _overall_packet_chains[n];
+        if(connections > 0) {
+            os << " (" << 100.0 * _overall_packet_chains[n] / connections << "%)";
+        }
+        os << endl;
+    }
+}
+
 void TrafficManager::_ComputeStats( const vector<int> & stats, int *sum, int *min, int *max, int *min_pos, int *max_pos ) const
 {
     int const count = stats.size();
@@ -1467,14 +1713,19 @@ bool TrafficManager::_SingleSim( )
            ( ( _sim_state != running ) ||
              ( _converged_threshold == -1 || converged < _converged_threshold ) ) ) {
 
+        if ( _ReplicationStopped( ) ) {
+            return false;
+        }
+
         if ( clear_last || (( ( _sim_state == warming_up ) && ( ( total_phases % 2 ) == 0 ) )) ) {
             clear_last = false;
             _ClearStats( );
         }
 
 
-        for ( int iter = 0; iter < _sample_period; ++iter )
-            _Step( );
+        int const end = _time + _sample_period;
+        while ( _time < end )
+            _Advance( end );
 
         //cout << _sim_state << endl;
 
@@ -1648,11 +1899,268 @@ bool TrafficManager::_SingleSim( )
     return ( converged > 0 );
 }
 
+// ============ sampled simulation ============
+// Detailed windows of sampling_warmup unmeasured and sampling_window
+// measured cycles alternate with sampling_interval fast-forward cycles. No
+// flits enter the network while fast-forwarding; the injection processes
+// and traffic patterns keep running and their packets are delivered after
+// the latency of their class in the previous window. Each window is one
+// sample of the overall statistics.
+
+bool TrafficManager::_SampledSim( )
+{
+    for ( int w = 0; w < _sampling_windows; ++w ) {
+
+        if ( _ReplicationStopped( ) ) {
+            return false;
+        }
+
+        if ( w > 0 ) {
+            _UpdateOverallStats( );
+            _FastForward( _sampling_interval );
+        }
+
+        int const start = _time;
+        _sim_state = warming_up;
+        for ( int iter = 0; iter < _sampling_warmup; ++iter )
+            _Step( );
+
+        _ClearStats( );
+        _sim_state = running;
+        for ( int iter = 0; iter < _sampling_window; ++iter )
+            _Step( );
+
+        _sim_state = draining;
+        _drain_time = _time;
+        if ( _measure_latency ) {
+            int empty_steps = 0;
+            while( _PacketsOutstanding( ) ) {
+                _Step( );
+                if ( ( ++empty_steps % 1000 == 0 ) && ( _LatencyExceeded( ) >= 0 ) ) {
+                    cout << "Average latency exceeded latency_thres in window "
+                         << w << ". Aborting simulation." << endl;
+                    return false;
+                }
+            }
+        }
+        // the rest finishes without new traffic, as in the final drain
+        _empty_network = true;
+        while ( _FlitsInFlight( ) ) {
+            _Step( );
+        }
+        _empty_network = false;
+        _detailed_cycles += _time - start;
+
+        cout << "Sample window " << w + 1 << " of " << _sampling_windows
+             << " ended at " << _time << " cycles" << endl;
+        UpdateStats();
+        DisplayStats();
+        _AddSample( );
+    }
+    return true;
+}
+
+// the first class whose average latency, packets in flight included,
+// exceeds its latency_thres, -1 if none does
+int TrafficManager::_LatencyExceeded( ) const
+{
+    for ( int c = 0; c < _classes; ++c ) {
+        if ( _latency_thres[c] < 0.0 ) {
+            continue;
+        }
+        double latency = _plat_stats[c]->Sum();
+        double count = (double)_plat_stats[c]->NumSamples();
+        map<int, Flit *>::const_iterator iter;
+        for(iter = _total_in_flight_flits[c].begin();
+            iter != _total_in_flight_flits[c].end();
+            iter++) {
+            latency += (double)(_time - iter->second->ctime);
+            count++;
+        }
+        if ( ( count > 0.0 ) && ( latency / count > _latency_thres[c] ) ) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+bool TrafficManager::_FlitsInFlight( ) const
+{
+    for ( int c = 0; c < _classes; ++c ) {
+        if ( !_total_in_flight_flits[c].empty() ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrafficManager::_NetworkEmpty( ) const
+{
+    return !_FlitsInFlight( ) && ( Credit::OutStanding() == 0 ) &&
+        ( Handshake::OutStanding() == 0 );
+}
+
+void TrafficManager::_FastForward( int cycles )
+{
+    vector<bool> & core_states = _net[0]->GetCoreStates();
+
+    _empty_network = true;
+    int const end = _time + cycles;
+    while ( _time < end ) {
+        for ( int input = 0; input < _nodes; ++input ) {
+            if ( core_states[input] == false ) {
+                continue;
+            }
+            for ( int c = 0; c < _classes; ++c ) {
+                if ( !_injection_process[c]->test( input ) ) {
+                    continue;
+                }
+                int dest = _traffic_pattern[c]->dest( input );
+                if ( ( _traffic[c].compare( 0, 7, "tornado" ) == 0 ) &&
+                     ( core_states[dest] == false ) ) {
+                    dest = input;
+                } else {
+                    while ( core_states[dest] != true )
+                        dest = _traffic_pattern[c]->dest( input );
+                }
+                int const latency = (int)( _ffwd_latency[c] + 0.5 );
+                ++_ffwd_packets[c];
+                _ffwd_flits[c] += _GetNextPacketSize( c, input );
+                _ffwd_latency_sum[c] += latency;
+                _FastForwardPacket( input, dest, c, latency );
+            }
+        }
+        _FastForwardStep( );
+    }
+    _empty_network = false;
+
+    // the sources resume injecting from here
+    for ( int s = 0; s < _nodes; ++s ) {
+        _qtime[s].assign( _classes, _time );
+        _qdrained[s].assign( _classes, false );
+    }
+}
+
+// the routers of this traffic manager have no power-state machines, an
+// empty network has nothing left to simulate
+void TrafficManager::_FastForwardStep( )
+{
+    if ( _NetworkEmpty( ) && ( _NextNetworkEvent( ) > _time ) ) {
+        ++_time;
+        /* ==== DSENT power model - Begin ==== */
+        _PowerTraceStep();
+        /* ==== DSENT power model - End ==== */
+    } else {
+        _Step( );
+    }
+}
+
+void TrafficManager::_AddSample( )
+{
+    vector<pair<string, double> > metrics;
+    double const time_delta = (double)(_drain_time - _reset_time);
+    for ( int c = 0; c < _classes; ++c ) {
+        if ( _plat_stats[c]->NumSamples() > 0 ) {
+            _ffwd_latency[c] = _plat_stats[c]->Average();
+        }
+        if ( _measure_stats[c] == 0 ) {
+            continue;
+        }
+        ostringstream prefix;
+        if ( _classes > 1 ) {
+            prefix << "Class " << c << " ";
+        }
+        int accepted;
+        _ComputeStats( _accepted_flits[c], &accepted );
+        metrics.push_back(make_pair(prefix.str() + "Packet latency average",
+                                    _plat_stats[c]->Average()));
+        metrics.push_back(make_pair(prefix.str() + "Network latency average",
+                                    _nlat_stats[c]->Average()));
+        metrics.push_back(make_pair(prefix.str() + "Accepted flit rate average",
+                                    (double)accepted / time_delta / (double)_nodes));
+        metrics.push_back(make_pair(prefix.str() + "Hops average",
+                                    _hop_stats[c]->Average()));
+    }
+    for ( size_t m = 0; m < metrics.size(); ++m ) {
+        size_t i = 0;
+        while ( ( i < _sample_names.size() ) && ( _sample_names[i] != metrics[m].first ) ) {
+            ++i;
+        }
+        if ( i == _sample_names.size() ) {
+            _sample_names.push_back( metrics[m].first );
+            _sample_values.push_back( vector<double>() );
+        }
+        _sample_values[i].push_back( metrics[m].second );
+    }
+}
+
+void TrafficManager::_DisplaySampling( ostream & os ) const
+{
+    if ( !_sampling ) {
+        return;
+    }
+    os << "====== Sampled Simulation ======" << endl;
+    os << "Detailed cycles = " << _detailed_cycles << " of " << _time
+       << " (" << 100.0 * (double)_detailed_cycles / (double)_time << "%)" << endl;
+    for ( int c = 0; c < _classes; ++c ) {
+        if ( _ffwd_packets[c] == 0 ) {
+            continue;
+        }
+        if ( _classes > 1 ) {
+            os << "Class " << c << " ";
+        }
+        os << "Fast-forward packets = " << _ffwd_packets[c]
+           << " (" << _ffwd_flits[c] << " flits, modeled latency average = "
+           << _ffwd_latency_sum[c] / (double)_ffwd_packets[c] << ")" << endl;
+    }
+    for ( size_t i = 0; i < _sample_names.size(); ++i ) {
+        double mean, half;
+        _MeanCI( _sample_values[i], _sampling_confidence, &mean, &half );
+        os << _sample_names[i] << " = " << mean;
+        if ( _sample_values[i].size() > 1 ) {
+            os << " +/- " << half << " (" << 100.0 * _sampling_confidence
+               << "% confidence, " << _sample_values[i].size() << " windows)";
+        }
+        os << endl;
+    }
+}
+
+/* ==== DSENT power model - Begin ==== */
+// flush the last partial epoch, the integrated energy equals the
+// end-of-run DSENT total power times the completion time
+void TrafficManager::_FinishPowerTrace( )
+{
+    for (size_t i = 0; i < _power_trace.size(); ++i) {
+        _power_trace[i]->TraceStep(*_power_trace_out);
+        double run_time = _power_trace[i]->GetTraceTime() /
+            _power_trace[i]->GetFrequency();
+        cout << "Power trace energy (" << _net[i]->Name() << ") = "
+             << _power_trace[i]->GetTraceEnergy()
+             << " (average power " << _power_trace[i]->GetTraceEnergy() / run_time
+             << ")" << endl;
+    }
+}
+/* ==== DSENT power model - End ==== */
+
 bool TrafficManager::Run( )
 {
+    if (_replications > 1) {
+        _StartReplications( );
+    }
+
     for ( int sim = 0; sim < _total_sims; ++sim ) {
 
         _time = 0;
+        for (size_t i = 0; i < _power_trace.size(); ++i) {
+            _power_trace[i]->TraceStart();
+        }
+
+        _skipped_cycles = 0;
+        if ( _event_kernel ) {
+            for ( int subnet = 0; subnet < _subnets; ++subnet ) {
+                _net[subnet]->EnableEventKernel( );
+            }
+        }
 
         //remove any pending request from the previous simulations
         _requestsOutstanding.assign(_nodes, 0);
@@ -1682,8 +2190,15 @@ bool TrafficManager::Run( )
             _injection_process[c]->reset();
         }
 
-        if ( !_SingleSim( ) ) {
-            cout << "Simulation unstable, ending ..." << endl;
+        if ( !( _sampling ? _SampledSim( ) : _SingleSim( ) ) ) {
+            if ( _ReplicationStopped( ) ) {
+                cout << "Replication stopped, ending ..." << endl;
+            } else {
+                cout << "Simulation unstable, ending ..." << endl;
+            }
+            if (_replications > 1) {
+                _EndReplications(false);
+            }
             return false;
         }
 
@@ -1724,6 +2239,14 @@ bool TrafficManager::Run( )
         //for the love of god don't ever say "Time taken" anywhere else
         //the power script depend on it
         cout << "Time taken is " << _time << " cycles" <<endl;
+        if ( _event_skip ) {
+            cout << "Event kernel skipped " << _skipped_cycles
+                 << " idle cycles" << endl;
+        }
+
+        /* ==== DSENT power model - Begin ==== */
+        _FinishPowerTrace();
+        /* ==== DSENT power model - End ==== */
 
         if(_stats_out) {
             WriteStats(*_stats_out);
@@ -1731,6 +2254,16 @@ bool TrafficManager::Run( )
         _UpdateOverallStats();
     }
 
+    // the overall statistics average the detailed windows
+    if (_sampling) {
+        _total_sims = _sampling_windows;
+    }
+
+    // waits for the workers
+    if (_replications > 1) {
+        _EndReplications(true);
+    }
+
     DisplayOverallStats();
     if(_print_csv_results) {
         DisplayOverallStatsCSV();
@@ -1740,6 +2273,8 @@ bool TrafficManager::Run( )
 }
 
 void TrafficManager::_UpdateOverallStats() {
+    _UpdatePacketChains();
+
     for ( int c = 0; c < _classes; ++c ) {
 
         if(_measure_stats[c] == 0) {
@@ -2215,6 +2750,9 @@ void TrafficManager::DisplayOverallStats( ostream & os ) const {
 
     }
 
+    _DisplayPacketChains(os);
+    _DisplaySampling(os);
+    _DisplayReplications(os);
 }
 
 string TrafficManager::_OverallStatsCSV(int c) const
@@ -2266,6 +2804,326 @@ void TrafficManager::DisplayOverallStatsCSV(ostream & os) const {
     for(int c = 0; c < _classes; ++c) {
         os << "results:" << c << ',' << _OverallStatsCSV() << endl;
     }
+    // metric, replications, mean, confidence interval half-width
+    for (size_t i = 0; i < _replication_names.size(); ++i) {
+        double mean, half;
+        _MeanCI(_replication_values[i], _replication_confidence, &mean, &half);
+        os << "replications:" << _replication_names[i]
+           << ',' << _replication_values[i].size()
+           << ',' << mean << ',' << half << endl;
+    }
+    // metric, windows, mean, confidence interval half-width
+    for (size_t i = 0; i < _sample_names.size(); ++i) {
+        double mean, half;
+        _MeanCI(_sample_values[i], _sampling_confidence, &mean, &half);
+        os << "sampling:" << _sample_names[i]
+           << ',' << _sample_values[i].size()
+           << ',' << mean << ',' << half << endl;
+    }
+}
+
+// ============ replications ============
+// Replications 1 .. N-1 run on worker threads, each in a SimContext of its
+// own with networks and a traffic manager built from the configuration
+// and seeded with seed + i, as main.cpp builds a simulation. A spawner
+// thread keeps replication_workers of them running while replication 0
+// runs in this traffic manager, which owns the console and the output
+// files. The workers write to their replication_log file instead.
+
+// the console of the thread, NULL discards
+static thread_local streambuf * gThreadConsole = NULL;
+
+// cout while replications run, each thread writes to its own console
+class ReplicationConsole : public streambuf {
+protected:
+    virtual int overflow( int c ) {
+        if ((c == EOF) || !gThreadConsole) {
+            return traits_type::not_eof(c);
+        }
+        return gThreadConsole->sputc(traits_type::to_char_type(c));
+    }
+    virtual streamsize xsputn( const char * s, streamsize n ) {
+        return gThreadConsole ? gThreadConsole->sputn(s, n) : n;
+    }
+    virtual int sync( ) {
+        return gThreadConsole ? gThreadConsole->pubsync() : 0;
+    }
+};
+
+static ReplicationConsole gReplicationConsole;
+
+struct TrafficManager::_Replication {
+    Configuration config;
+    int index;
+    int seed;
+    string log;
+    const atomic<bool> * stop;
+    // reports to the spawner
+    mutex * lock;
+    condition_variable * done;
+    deque<int> * finished;
+    string message;  // see _AddReplication
+};
+
+void TrafficManager::_StartReplications( )
+{
+    cout.flush();
+    gThreadConsole = cout.rdbuf(&gReplicationConsole);
+    _replication_spawner = thread(&TrafficManager::_SpawnReplications, this);
+}
+
+void TrafficManager::_SpawnReplications( )
+{
+    int workers = _replication_workers;
+    if (workers <= 0) {
+        workers = (int)thread::hardware_concurrency();
+    }
+    // replication 0 keeps one CPU busy
+    workers = max(workers - 1, 1);
+
+    mutex lock;
+    condition_variable done;
+    deque<int> finished;
+    vector<_Replication> replications(_replications);
+    vector<thread> threads(_replications);
+    unique_lock<mutex> guard(lock);
+    int next = 1;
+    int running = 0;
+    bool stop = false;
+    while (true) {
+        stop |= _replication_cancel.load();
+        while (!stop && (next < _replications) && (running < workers)) {
+            _Replication & r = replications[next];
+            r.config = _replication_config;
+            r.index = next;
+            r.seed = _seed + next;
+            if (!_replication_log.empty()) {
+                ostringstream log;
+                log << _replication_log << "." << next;
+                r.log = log.str();
+            }
+            r.stop = &_replication_cancel;
+            r.lock = &lock;
+            r.done = &done;
+            r.finished = &finished;
+            threads[next] = thread(_RunReplication, &r);
+            ++next;
+            ++running;
+        }
+        if (running == 0) {
+            break;
+        }
+
+        done.wait(guard, [&finished] { return !finished.empty(); });
+        int const i = finished.front();
+        finished.pop_front();
+        threads[i].join();
+        --running;
+        if (stop && (replications[i].message.find("\tok") == string::npos)) {
+            // stopped at the confidence target or with replication 0
+            continue;
+        }
+        _AddReplication(replications[i].message);
+
+        // replication 0 still adds one
+        if (!stop && !_replication_values.empty() &&
+            ((int)_replication_values.front().size() + 1 >= _replication_min) &&
+            _ReplicationConverged()) {
+            stop = true;
+            _replication_cancel = true;
+        }
+    }
+}
+
+void TrafficManager::_RunReplication( _Replication * r )
+{
+    ofstream log;
+    if (!r->log.empty()) {
+        log.open(r->log.c_str());
+        gThreadConsole = log.rdbuf();
+    }
+
+    SimContext context;
+    gSimContext = &context;
+    cout << "Replication " << r->index << " of "
+         << r->config.GetInt("replications") << ", seed " << r->seed << endl;
+    r->config.Assign("seed", string(""));
+    r->config.Assign("seed", r->seed);
+    r->config.Assign("replications", 1);
+    r->config.Assign("stats_out", string(""));
+    r->config.Assign("power_trace_epoch", 0);
+
+    InitializeRoutingMap(r->config);
+    gPrintActivity = (r->config.GetInt("print_activity") > 0);
+    context.random_streams = (r->config.GetInt("random_streams") > 0);
+    vector<Network *> net(r->config.GetInt("subnets"));
+    for (size_t i = 0; i < net.size(); ++i) {
+        ostringstream name;
+        name << "network_" << i;
+        net[i] = Network::New(r->config, name.str());
+    }
+    TrafficManager * const tm = TrafficManager::New(r->config, net);
+    context.traffic_manager = tm;
+    tm->_replication_stop = r->stop;
+    bool const result = tm->Run();
+
+    string const message = tm->_ReplicationReport(r->index, result);
+
+    delete tm;
+    context.traffic_manager = NULL;
+    for (size_t i = 0; i < net.size(); ++i) {
+        delete net[i];
+    }
+    gSimContext = NULL;
+    cout.flush();
+    gThreadConsole = NULL;
+
+    lock_guard<mutex> guard(*r->lock);
+    r->message = message;
+    r->finished->push_back(r->index);
+    r->done->notify_one();
+}
+
+void TrafficManager::_EndReplications( bool result )
+{
+    if (!result) {
+        _replication_cancel = true;
+    }
+    _replication_spawner.join();
+    cout.flush();
+    cout.rdbuf(gThreadConsole);
+    gThreadConsole = NULL;
+
+    _AddReplication(_ReplicationReport(0, result));
+}
+
+string TrafficManager::_ReplicationReport( int replication, bool result ) const
+{
+    ostringstream message;
+    message << replication << '\t' << (result ? "ok" : "unstable");
+    if (result) {
+        vector<pair<string, double> > metrics;
+        _ReplicationMetrics(metrics);
+        message << setprecision(12);
+        for (size_t i = 0; i < metrics.size(); ++i) {
+            message << '\t' << metrics[i].first << '=' << metrics[i].second;
+        }
+    }
+    return message.str();
+}
+
+// <replication>\t<ok|unstable>[\t<metric>=<value>]...
+void TrafficManager::_AddReplication( const string & message )
+{
+    istringstream in(message);
+    string field;
+    getline(in, field, '\t');
+    getline(in, field, '\t');
+    if (field.compare(0, 2, "ok") != 0) {
+        ++_replications_failed;
+        return;
+    }
+    while (getline(in, field, '\t')) {
+        size_t const eq = field.find('=');
+        if (eq == string::npos) {
+            continue;
+        }
+        string const name = field.substr(0, eq);
+        size_t i = 0;
+        while ((i < _replication_names.size()) && (_replication_names[i] != name)) {
+            ++i;
+        }
+        if (i == _replication_names.size()) {
+            _replication_names.push_back(name);
+            _replication_values.push_back(vector<double>());
+        }
+        _replication_values[i].push_back(strtod(field.c_str() + eq + 1, NULL));
+    }
+}
+
+void TrafficManager::_MeanCI( const vector<double> & values, double confidence,
+                              double * mean, double * half )
+{
+    int const n = values.size();
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        sum += values[i];
+    }
+    *mean = n ? sum / n : 0.0;
+    *half = 0.0;
+    if (n > 1) {
+        double ss = 0.0;
+        for (int i = 0; i < n; ++i) {
+            ss += (values[i] - *mean) * (values[i] - *mean);
+        }
+        *half = student_t_critical(confidence, n - 1) * sqrt(ss / (n - 1) / n);
+    }
+}
+
+bool TrafficManager::_ReplicationConverged( ) const
+{
+    if ((_replication_ci <= 0.0) || _replication_values.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < _replication_values.size(); ++i) {
+        if (_replication_values[i].size() < 2) {
+            return false;
+        }
+        double mean, half;
+        _MeanCI(_replication_values[i], _replication_confidence, &mean, &half);
+        if (half > _replication_ci * fabs(mean)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TrafficManager::_ReplicationMetrics( vector<pair<string, double> > & metrics ) const
+{
+    for (int c = 0; c < _classes; ++c) {
+        if (_measure_stats[c] == 0) {
+            continue;
+        }
+        ostringstream prefix;
+        if (_classes > 1) {
+            prefix << "Class " << c << " ";
+        }
+        metrics.push_back(make_pair(prefix.str() + "Packet latency average",
+                                    _overall_avg_plat[c] / (double)_total_sims));
+        metrics.push_back(make_pair(prefix.str() + "Network latency average",
+                                    _overall_avg_nlat[c] / (double)_total_sims));
+        metrics.push_back(make_pair(prefix.str() + "Accepted flit rate average",
+                                    _overall_avg_accepted[c] / (double)_total_sims));
+        metrics.push_back(make_pair(prefix.str() + "Hops average",
+                                    _overall_hop_stats[c] / (double)_total_sims));
+    }
+}
+
+void TrafficManager::_DisplayReplications( ostream & os ) const
+{
+    if (_replications <= 1) {
+        return;
+    }
+    size_t completed = 0;
+    for (size_t i = 0; i < _replication_values.size(); ++i) {
+        completed = max(completed, _replication_values[i].size());
+    }
+    os << "====== Replications ======" << endl;
+    os << "Replications = " << completed << " of " << _replications;
+    if (_replications_failed > 0) {
+        os << " (" << _replications_failed << " unstable or failed)";
+    }
+    os << endl;
+    for (size_t i = 0; i < _replication_names.size(); ++i) {
+        double mean, half;
+        _MeanCI(_replication_values[i], _replication_confidence, &mean, &half);
+        os << _replication_names[i] << " = " << mean;
+        if (_replication_values[i].size() > 1) {
+            os << " +/- " << half << " (" << 100.0 * _replication_confidence
+               << "% confidence, " << _replication_values[i].size() << " samples)";
+        }
+        os << endl;
+    }
 }
 
 //read the watchlist
@@ -2291,7 +3149,7 @@ void TrafficManager::_LoadWatchList(const string & filename){
     }
 }
 
-int TrafficManager::_GetNextPacketSize(int cl) const
+int TrafficManager::_GetNextPacketSize(int cl, int source)
 {
     assert(cl >= 0 && cl < _classes);
 
@@ -2305,7 +3163,7 @@ int TrafficManager::_GetNextPacketSize(int cl) const
     vector<int> const & prate = _packet_size_rate[cl];
     int max_val = _packet_size_max_val[cl];
 
-    int pct = RandomInt(max_val);
+    int pct = _packet_random[cl * _nodes + source].Int(max_val);
 
     for(int i = 0; i < (sizes - 1); ++i) {
         int const limit = prate[i];
@@ -32,6 +32,8 @@
 #include <map>
 #include <set>
 #include <cassert>
+#include <thread>
+#include <atomic>
 
 #include "module.hpp"
 #include "config_utils.hpp"
@@ -43,6 +45,10 @@
 #include "routefunc.hpp"
 #include "outputset.hpp"
 #include "injection.hpp"
+#include "profiler.hpp"
+/* ==== DSENT power model - Begin ==== */
+#include "dsent_power_module.hpp"
+/* ==== DSENT power model - End ==== */
 
 //register the requests to a node
 class PacketReplyInfo;
@@ -86,6 +92,9 @@ protected:
   vector<TrafficPattern *> _traffic_pattern;
   vector<InjectionProcess *> _injection_process;
 
+  // request type, packet size and subnet draws, per class and source
+  vector<RandomStream> _packet_random;
+
   // ============ Message priorities ============
 
   enum ePriority { class_based, age_based, network_age_based, local_age_based, queue_length_based, hop_count_based, sequence_based, none };
@@ -166,6 +175,10 @@ protected:
   vector<Stats *> _hop_stats;
   vector<double> _overall_hop_stats;
 
+  // packets per held switch connection, summed over the routers
+  int _packet_chain_max;
+  vector<long long> _overall_packet_chains;
+
   vector<vector<int> > _sent_packets;
   vector<double> _overall_min_sent_packets;
   vector<double> _overall_avg_sent_packets;
@@ -206,6 +219,16 @@ protected:
   enum eSimState { warming_up, running, draining, done };
   eSimState _sim_state;
 
+  // self-profile counters of this traffic manager type
+  int _profile_owner;
+  inline void _ProfilePhase( ) const {
+    if(gProfile) {
+      Profiler::SetPhase(_sim_state == running ? Profiler::measure :
+                         _sim_state == draining ? Profiler::drain :
+                         Profiler::warmup);
+    }
+  }
+
   bool _measure_latency;
 
   int   _reset_time;
@@ -244,6 +267,51 @@ protected:
   //flits to watch
   ostream * _stats_out;
 
+  /* ==== DSENT power model - Begin ==== */
+  int _power_trace_epoch;
+  vector<DSENT_Power_Module *> _power_trace;
+  ostream * _power_trace_out;
+  /* ==== DSENT power model - End ==== */
+
+  // ============ replications ============
+
+  int _seed;
+  int _replications;
+  int _replication_workers;
+  int _replication_min;
+  double _replication_ci;
+  double _replication_confidence;
+  string _replication_log;
+  Configuration _replication_config;  // the workers build their simulations from it
+  thread _replication_spawner;
+  atomic<bool> _replication_cancel;  // set once converged or unstable
+  const atomic<bool> * _replication_stop;  // a worker's, NULL otherwise
+  int _replications_failed;
+  vector<string> _replication_names;
+  vector<vector<double> > _replication_values;
+
+  // ============ sampled simulation ============
+
+  bool _sampling;
+  int _sampling_windows;
+  int _sampling_warmup;
+  int _sampling_window;
+  int _sampling_interval;
+  double _sampling_confidence;
+  long long _detailed_cycles;
+  vector<double> _ffwd_latency;  // per class, from the last window
+  vector<long long> _ffwd_packets;
+  vector<long long> _ffwd_flits;
+  vector<double> _ffwd_latency_sum;
+  vector<string> _sample_names;
+  vector<vector<double> > _sample_values;
+
+  // ============ event kernel ============
+
+  bool _event_kernel;
+  bool _event_skip;  // idle cycles are skipped, needs independent streams
+  long long _skipped_cycles;
+
 #ifdef TRACK_FLOWS
   vector<vector<int> > _injected_flits;
   vector<vector<int> > _ejected_flits;
@@ -287,9 +355,54 @@ protected:
 
   virtual void _UpdateOverallStats();
 
+  void _ClearPacketChains( );
+  void _UpdatePacketChains( );
+  void _DisplayPacketChains( ostream & os ) const;
+
   virtual string _OverallStatsCSV(int c = 0) const;
 
-  int _GetNextPacketSize(int cl) const;
+  struct _Replication;
+  void _StartReplications( );
+  void _SpawnReplications( );
+  static void _RunReplication( _Replication * r );
+  inline bool _ReplicationStopped( ) const {
+    return _replication_stop && _replication_stop->load();
+  }
+  void _EndReplications( bool result );
+  string _ReplicationReport( int replication, bool result ) const;
+  void _AddReplication( const string & message );
+  bool _ReplicationConverged( ) const;
+  static void _MeanCI( const vector<double> & values, double confidence,
+                       double * mean, double * half );
+  virtual void _ReplicationMetrics( vector<pair<string, double> > & metrics ) const;
+  void _DisplayReplications( ostream & os ) const;
+
+  bool _SampledSim( );
+  int _LatencyExceeded( ) const;
+  bool _FlitsInFlight( ) const;
+  bool _NetworkEmpty( ) const;
+  void _FastForward( int cycles );
+  virtual void _FastForwardStep( );
+  // a packet generated while fast-forwarding, delivered after latency
+  virtual void _FastForwardPacket( int source, int dest, int cl, int latency ) { }
+  void _AddSample( );
+  void _DisplaySampling( ostream & os ) const;
+
+  void _Advance( int end );
+  int _NextNetworkEvent( ) const;
+
+  /* ==== DSENT power model - Begin ==== */
+  inline void _PowerTraceStep( ) {
+    if ((_power_trace_epoch > 0) && (_time % _power_trace_epoch == 0)) {
+      for (size_t i = 0; i < _power_trace.size(); ++i) {
+        _power_trace[i]->TraceStep(*_power_trace_out);
+      }
+    }
+  }
+  void _FinishPowerTrace( );
+  /* ==== DSENT power model - End ==== */
+
+  int _GetNextPacketSize(int cl, int source);
   double _GetAveragePacketSize(int cl) const;
 
 public:
@@ -307,6 +420,9 @@ public:
   virtual void DisplayStats( ostream & os = cout ) const ;
   virtual void DisplayOverallStats( ostream & os = cout ) const ;
   virtual void DisplayOverallStatsCSV( ostream & os = cout ) const ;
+  // the averages a replication reports, see _ReplicationMetrics
+  void OverallMetrics( vector<pair<string, double> > & metrics ) const
+  { _ReplicationMetrics( metrics ); }
 
   inline int getTime() { return _time;}
   Stats * getStats(const string & name) { return _stats[name]; }
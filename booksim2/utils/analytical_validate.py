@@ -0,0 +1,127 @@
+#!/usr/bin/python3
+#
+# Validation of the analytical model (analytical_model = 2) against the
+# detailed simulation over the throughput benchmark workloads. Prints the
+# latency and hop count errors of every workload and whether the model
+# and the simulation agree on saturation, which is what pruning relies on.
+#
+#   ../utils/analytical_validate.py                    # from booksim2/src
+#   ../utils/analytical_validate.py --filter '_low$' --output val.csv
+
+import argparse
+import csv
+import os
+import re
+import statistics
+import subprocess
+import sys
+
+import bench
+
+PATTERNS = {
+    'model_latency': r'^Packet latency average: model = (\S+), simulated = ([0-9.eE+-]+)',
+    'model_hops': r'^Hops average: model = (\S+), simulated = ([0-9.eE+-]+)',
+    'throughput': r'^Accepted flit rate average: offered = ([0-9.eE+-]+), '
+                  r'simulated = ([0-9.eE+-]+), saturation estimate = ([0-9.eE+-]+)',
+    'model_time': r'^Analytical model time = ([0-9.eE+-]+) ms',
+    'run_time': r'^Total run time ([0-9.eE+-]+)',
+}
+
+FIELDS = ['workload', 'model_latency', 'sim_latency', 'latency_error',
+          'model_hops', 'sim_hops', 'offered', 'accepted', 'saturation',
+          'model_saturated', 'sim_saturated', 'model_ms', 'sim_s']
+
+
+def run(booksim, cfg, args):
+    cmd = [booksim, os.path.join(bench.ROOT, cfg)] + bench.COMMON + args + \
+        ['analytical_model=2']
+    proc = subprocess.run(cmd, cwd=bench.SRC, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+    found = {}
+    for key, pattern in PATTERNS.items():
+        match = re.search(pattern, proc.stdout, re.M)
+        if not match:
+            return None, proc.stdout
+        found[key] = match.groups()
+    offered, accepted, saturation = map(float, found['throughput'])
+    model_latency = found['model_latency'][0]
+    sim_latency = float(found['model_latency'][1])
+    row = {
+        'model_latency': model_latency,
+        'sim_latency': sim_latency,
+        'latency_error': '',
+        'model_hops': float(found['model_hops'][0]),
+        'sim_hops': float(found['model_hops'][1]),
+        'offered': offered,
+        'accepted': accepted,
+        'saturation': saturation,
+        'model_saturated': int(model_latency == 'saturated'),
+        # the simulation falls behind the offered load beyond saturation
+        'sim_saturated': int(accepted < 0.95 * offered),
+        'model_ms': float(found['model_time'][0]),
+        'sim_s': float(found['run_time'][0]),
+    }
+    if model_latency != 'saturated':
+        row['latency_error'] = float(model_latency) / sim_latency - 1.0
+    return row, proc.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Analytical model against the detailed simulation')
+    parser.add_argument('--booksim', default=os.path.join(bench.SRC, 'booksim'))
+    parser.add_argument('--output', default=os.path.join(
+        bench.ROOT, 'results', 'bench', 'analytical.csv'))
+    parser.add_argument('--filter', default='',
+                        help='only workloads whose name matches this regex')
+    opts = parser.parse_args()
+
+    rows = []
+    failures = 0
+    for name, cfg, args in bench.workloads():
+        if not re.search(opts.filter, name):
+            continue
+        row, log = run(os.path.abspath(opts.booksim), cfg, args)
+        if row is None:
+            print('%-32s FAILED' % name)
+            sys.stdout.write(''.join(log.splitlines(True)[-20:]))
+            failures += 1
+            continue
+        row['workload'] = name
+        rows.append(row)
+        error = row['latency_error']
+        print('%-32s latency %9s / %9.2f  %7s  hops %5.2f / %5.2f  '
+              'saturated %s / %s  %6.2f ms / %6.2f s' %
+              (name, row['model_latency'][:9], row['sim_latency'],
+               '' if error == '' else '%+6.1f%%' % (100.0 * error),
+               row['model_hops'], row['sim_hops'],
+               'yes' if row['model_saturated'] else 'no',
+               'yes' if row['sim_saturated'] else 'no',
+               row['model_ms'], row['sim_s']))
+        sys.stdout.flush()
+
+    if os.path.dirname(opts.output):
+        os.makedirs(os.path.dirname(opts.output), exist_ok=True)
+    with open(opts.output, 'w') as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        for row in rows:
+            writer.writerow(row)
+    print('Results written to %s' % opts.output)
+
+    errors = [abs(r['latency_error']) for r in rows
+              if r['latency_error'] != '' and not r['sim_saturated']]
+    if errors:
+        print('Latency error below saturation: median %.1f%%, max %.1f%% '
+              '(%d workloads)' % (100.0 * statistics.median(errors),
+                                  100.0 * max(errors), len(errors)))
+    agree = sum(r['model_saturated'] == r['sim_saturated'] for r in rows)
+    missed = sum(r['sim_saturated'] and not r['model_saturated'] for r in rows)
+    if rows:
+        print('Saturation agrees in %d of %d workloads, %d saturated in '
+              'simulation only' % (agree, len(rows), missed))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,236 @@
+#!/usr/bin/python3
+#
+# Simulator throughput benchmark. Runs a fixed matrix of workloads for a
+# fixed number of cycles, records simulated cycles/s, flit-hops/s, startup
+# time and peak RSS in a CSV file, and compares against a stored baseline.
+#
+#   make bench                        # from booksim2/src
+#   make bench BENCH_ARGS="--update"  # record a new baseline
+#   ../utils/bench.py --filter '^pg_flov' --repeat 3
+#
+# Exit status is non-zero when a workload fails or regresses beyond the
+# tolerance.
+
+import argparse
+import csv
+import os
+import re
+import subprocess
+import sys
+
+UTILS = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(UTILS)
+SRC = os.path.join(ROOT, 'src')
+
+# every workload runs 4000 cycles, one warmup period and no drain
+COMMON = [
+    'sim_type=throughput',
+    'converged_threshold=-1',
+    'warmup_periods=1',
+    'sample_period=1000',
+    'max_samples=4',
+    'sim_count=1',
+    'latency_thres=-1.0',
+    'injection_rate_uses_flits=1',
+    'sim_power=0',
+    'seed=1',
+]
+
+# fractions of the approximate uniform saturation rate of each workload,
+# beyond saturation the source queues grow without bound
+LOADS = [('low', 0.1), ('medium', 0.5), ('saturated', 1.2)]
+
+# name, base config, saturation rate in flits/node/cycle, size overrides
+TOPOLOGIES = [
+    ('mesh_k4', 'src/examples/mesh88_lat', 0.5, ['k=4', 'packet_size=4']),
+    ('mesh_k8', 'src/examples/mesh88_lat', 0.35, ['k=8', 'packet_size=4']),
+    ('mesh_k16', 'src/examples/mesh88_lat', 0.15, ['k=16', 'packet_size=4']),
+    ('torus_k4', 'src/examples/torus88', 0.7, ['k=4', 'packet_size=4']),
+    ('torus_k8', 'src/examples/torus88', 0.45, ['k=8', 'packet_size=4']),
+    ('cmesh_k4', 'src/examples/cmeshconfig', 0.2, ['packet_size=4']),
+    ('cmesh_k8', 'src/examples/cmeshconfig', 0.1,
+     ['k=8', 'x=8', 'y=8', 'packet_size=4']),
+    ('flatfly_k4', 'src/examples/flatflyconfig', 0.6, ['packet_size=4']),
+    ('flatfly_k8', 'src/examples/flatflyconfig', 0.5,
+     ['k=8', 'x=8', 'y=8', 'packet_size=4']),
+    ('dragonfly_k2', 'src/examples/dragonflyconfig', 0.5,
+     ['k=2', 'packet_size=4']),
+    ('dragonfly_k4', 'src/examples/dragonflyconfig', 0.4, ['packet_size=4']),
+    ('fattree_k4n2', 'src/examples/fattree_config', 0.8,
+     ['n=2', 'packet_size=4']),
+    ('fattree_k4n3', 'src/examples/fattree_config', 0.6, ['packet_size=4']),
+]
+
+# power-gating schemes on the 50% cores-off mesh, as in run_case_study.sh
+POWERGATE = [
+    ('no_pg', 'baseline', ['powergate_type=no_pg']),
+    ('flov', 'flov', ['powergate_type=flov', 'sim_type=flov',
+                      'wait_for_tail_credit=1']),
+    ('nord', 'nord', ['powergate_type=nord', 'sim_type=nord',
+                      'wait_for_tail_credit=1']),
+    ('rp', 'rpc', ['powergate_type=rpc', 'sim_type=rp',
+                   'wait_for_tail_credit=0']),
+]
+POWERGATE_SIZES = [(4, 0.4), (8, 0.25), (16, 0.12)]
+
+
+def workloads():
+    matrix = []
+    for name, cfg, sat, size in TOPOLOGIES:
+        for load, fraction in LOADS:
+            matrix.append(('%s_%s' % (name, load), cfg,
+                           size + ['injection_rate=%g' % (fraction * sat)]))
+    for scheme, runfile, args in POWERGATE:
+        cfg = 'runfiles/%s/meshcmp_50off.cfg' % runfile
+        for k, sat in POWERGATE_SIZES:
+            for load, fraction in LOADS:
+                matrix.append(('pg_%s_k%d_%s' % (scheme, k, load), cfg, args + [
+                    'k=%d' % k,
+                    'injection_rate=%g' % (fraction * sat),
+                    'powergate_auto_config=1',
+                    'powergate_percentile=50',
+                    'traffic=uniform',
+                ]))
+    return matrix
+
+
+PATTERNS = {
+    'run_time': r'^Total run time ([0-9.eE+-]+)',
+    'cycles': r'^Simulated cycles = (\d+)',
+    'flit_hops': r'^Flit hops = (\d+)',
+    'startup': r'^Startup time ([0-9.eE+-]+)',
+    'peak_rss_kb': r'^Peak RSS = (\d+) KB',
+}
+
+FIELDS = ['workload', 'cycles', 'flit_hops', 'run_time', 'cycles_per_sec',
+          'flit_hops_per_sec', 'startup', 'peak_rss_kb']
+
+
+def run(booksim, cfg, args):
+    cmd = [booksim, os.path.join(ROOT, cfg)] + COMMON + args
+    proc = subprocess.run(cmd, cwd=SRC, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+    result = {}
+    for key, pattern in PATTERNS.items():
+        match = re.search(pattern, proc.stdout, re.M)
+        if not match:
+            return None, proc.stdout
+        result[key] = float(match.group(1))
+    result['cycles_per_sec'] = result['cycles'] / result['run_time']
+    result['flit_hops_per_sec'] = result['flit_hops'] / result['run_time']
+    return result, proc.stdout
+
+
+def load_csv(path):
+    rows = {}
+    with open(path) as f:
+        for row in csv.DictReader(f):
+            rows[row['workload']] = row
+    return rows
+
+
+def compare(results, baseline, tolerance):
+    regressions = 0
+    for name, cur in results.items():
+        if name not in baseline:
+            print('%-32s no baseline' % name)
+            continue
+        base = baseline[name]
+        notes = []
+        speed = cur['cycles_per_sec'] / float(base['cycles_per_sec']) - 1.0
+        if speed < -tolerance:
+            notes.append('SLOWER')
+            regressions += 1
+        rss = cur['peak_rss_kb'] / float(base['peak_rss_kb']) - 1.0
+        if rss > tolerance:
+            notes.append('RSS')
+            regressions += 1
+        # same seed and cycles, a changed hop count means changed behavior
+        if int(cur['flit_hops']) != int(base['flit_hops']):
+            notes.append('hops %s -> %d' % (base['flit_hops'],
+                                           int(cur['flit_hops'])))
+        print('%-32s speed %+6.1f%%  rss %+6.1f%%  %s' %
+              (name, 100.0 * speed, 100.0 * rss, ' '.join(notes)))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BookSim throughput benchmark')
+    parser.add_argument('--booksim', default=os.path.join(SRC, 'booksim'))
+    parser.add_argument('--output', default=os.path.join(
+        ROOT, 'results', 'bench', 'bench.csv'))
+    parser.add_argument('--baseline', default=os.path.join(
+        UTILS, 'bench_baseline.csv'))
+    parser.add_argument('--tolerance', type=float, default=0.10,
+                        help='allowed relative slowdown or RSS growth')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help='runs per workload, the fastest is kept')
+    parser.add_argument('--min-time', type=float, default=1.0,
+                        help='repeat each workload for at least this many '
+                        'seconds')
+    parser.add_argument('--filter', default='',
+                        help='only workloads whose name matches this regex')
+    parser.add_argument('--update', action='store_true',
+                        help='write the results as the new baseline')
+    opts = parser.parse_args()
+
+    results = {}
+    failures = 0
+    for name, cfg, args in workloads():
+        if not re.search(opts.filter, name):
+            continue
+        # short workloads are repeated, the fastest run is the least noisy
+        best = None
+        runs = 0
+        elapsed = 0.0
+        while runs < opts.repeat or elapsed < opts.min_time:
+            result, log = run(os.path.abspath(opts.booksim), cfg, args)
+            if result is None:
+                break
+            runs += 1
+            elapsed += result['run_time']
+            if best is None or result['run_time'] < best['run_time']:
+                best = result
+        if result is None:
+            print('%-32s FAILED' % name)
+            sys.stdout.write(''.join(log.splitlines(True)[-20:]))
+            failures += 1
+            continue
+        results[name] = best
+        print('%-32s %10.0f cycles/s %12.0f flit-hops/s %6.3f s startup '
+              '%7d KB' % (name, best['cycles_per_sec'],
+                          best['flit_hops_per_sec'], best['startup'],
+                          best['peak_rss_kb']))
+        sys.stdout.flush()
+
+    output = opts.baseline if opts.update else opts.output
+    if os.path.dirname(output):
+        os.makedirs(os.path.dirname(output), exist_ok=True)
+    with open(output, 'w') as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        for name, result in results.items():
+            writer.writerow({
+                'workload': name,
+                'cycles': int(result['cycles']),
+                'flit_hops': int(result['flit_hops']),
+                'run_time': '%.6f' % result['run_time'],
+                'cycles_per_sec': '%.1f' % result['cycles_per_sec'],
+                'flit_hops_per_sec': '%.1f' % result['flit_hops_per_sec'],
+                'startup': '%.6f' % result['startup'],
+                'peak_rss_kb': int(result['peak_rss_kb']),
+            })
+    print('Results written to %s' % output)
+
+    regressions = 0
+    if not opts.update and os.path.exists(opts.baseline):
+        print('Against %s (tolerance %g%%):' % (opts.baseline,
+                                                100.0 * opts.tolerance))
+        regressions = compare(results, load_csv(opts.baseline),
+                              opts.tolerance)
+        print('%d regression(s)' % regressions)
+    return 1 if failures or regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,92 @@
+#!/usr/bin/python3
+#
+# Validation of the event kernel (event_kernel = 1) against the cycle
+# kernel over the throughput benchmark workloads. Both runs must print the
+# same statistics; prints the speedup of the simulated cycles per second
+# and the share of idle cycles skipped. The power-gating traffic managers
+# are left out, the event kernel does not support them.
+#
+#   ../utils/event_kernel_validate.py                  # from booksim2/src
+#   ../utils/event_kernel_validate.py --filter '_low$' --scale 0.1
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import bench
+
+# lines that differ between two runs of the same simulation
+TIMING = re.compile(r'run time|Startup time|Peak RSS|Simulation speed|'
+                    r'event_kernel|Event kernel|time = ')
+
+
+def run(booksim, cfg, args, kernel):
+    cmd = [booksim, os.path.join(bench.ROOT, cfg)] + bench.COMMON + args + \
+        ['random_streams=1', 'event_kernel=%d' % kernel]
+    proc = subprocess.run(cmd, cwd=bench.SRC, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+    found = {}
+    for key, pattern in bench.PATTERNS.items():
+        match = re.search(pattern, proc.stdout, re.M)
+        if not match:
+            return None, proc.stdout
+        found[key] = float(match.group(1))
+    match = re.search(r'^Event kernel skipped (\d+) idle cycles', proc.stdout,
+                      re.M)
+    found['skipped'] = int(match.group(1)) if match else 0
+    found['speed'] = found['cycles'] / (found['run_time'] - found['startup'])
+    found['stats'] = [line for line in proc.stdout.splitlines()
+                      if not TIMING.search(line)]
+    return found, proc.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Event kernel against the cycle kernel')
+    parser.add_argument('--booksim', default=os.path.join(bench.SRC, 'booksim'))
+    parser.add_argument('--filter', default='',
+                        help='only workloads whose name matches this regex')
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='injection rate factor applied to every workload')
+    opts = parser.parse_args()
+
+    booksim = os.path.abspath(opts.booksim)
+    failures = 0
+    speedups = []
+    for name, cfg, args in bench.workloads():
+        if not re.search(opts.filter, name) or \
+           re.search(r'^pg_(flov|nord|rp)_', name):
+            continue
+        args = [re.sub(r'^injection_rate=(.*)$',
+                       lambda m: 'injection_rate=%g' % (float(m.group(1)) *
+                                                        opts.scale), a)
+                for a in args]
+        cycle, log = run(booksim, cfg, args, 0)
+        event = None
+        if cycle is not None:
+            event, log = run(booksim, cfg, args, 1)
+        if event is None:
+            print('%-32s FAILED' % name)
+            sys.stdout.write(''.join(log.splitlines(True)[-20:]))
+            failures += 1
+            continue
+        same = cycle['stats'] == event['stats']
+        if not same:
+            failures += 1
+        speedup = event['speed'] / cycle['speed']
+        speedups.append(speedup)
+        print('%-32s %s  speedup %6.2fx  skipped %5.1f%% of %d cycles' %
+              (name, 'same     ' if same else 'DIFFERENT', speedup,
+               100.0 * event['skipped'] / event['cycles'], event['cycles']))
+        sys.stdout.flush()
+
+    if speedups:
+        print('Speedup: min %.2fx, max %.2fx (%d workloads)' %
+              (min(speedups), max(speedups), len(speedups)))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
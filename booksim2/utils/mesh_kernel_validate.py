@@ -0,0 +1,108 @@
+#!/usr/bin/python3
+#
+# Validation of the baseline mesh kernel (mesh_kernel = 1) against the
+# iSLIP_Sparse allocators of the IQ router (mesh_kernel = 0) over the mesh
+# benchmark workloads and a set of router variants. Both runs must print
+# the same statistics; prints the speedup of the simulated cycles per
+# second.
+#
+#   ../utils/mesh_kernel_validate.py                  # from booksim2/src
+#   ../utils/mesh_kernel_validate.py --filter 'k8'
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import bench
+
+# lines that differ between two runs of the same simulation
+TIMING = re.compile(r'run time|Startup time|Peak RSS|Simulation speed|'
+                    r'mesh_kernel|time = ')
+
+# router options the kernel has to follow, on the 8x8 mesh at medium load
+VARIANTS = [
+    ('vcs4', ['num_vcs=4']),
+    ('vcs12', ['num_vcs=12']),
+    ('no_speedup', ['input_speedup=1']),
+    ('output_speedup', ['input_speedup=1', 'output_speedup=2']),
+    ('busy_when_full', ['vc_busy_when_full=1', 'wait_for_tail_credit=0']),
+    ('speculative', ['speculative=1']),
+    ('hold_switch', ['hold_switch_for_packet=1']),
+    ('routing_delay', ['routing_delay=1']),
+    ('shuffle', ['vc_shuffle_requests=1', 'vc_prioritize_empty=1']),
+    ('uniform', ['traffic=uniform', 'packet_size=8']),
+    ('mesh3d', ['k=4', 'n=3']),
+    ('single_cycle', ['single_cycle=1']),
+]
+
+
+def workloads():
+    matrix = [w for w in bench.workloads() if w[0].startswith('mesh_')]
+    for name, cfg, _, size in bench.TOPOLOGIES:
+        if name != 'mesh_k8':
+            continue
+        for variant, args in VARIANTS:
+            matrix.append(('mesh_k8_%s' % variant, cfg,
+                           size + ['injection_rate=0.175'] + args))
+    return matrix
+
+
+def run(booksim, cfg, args, kernel):
+    cmd = [booksim, os.path.join(bench.ROOT, cfg)] + bench.COMMON + args + \
+        ['mesh_kernel=%d' % kernel]
+    proc = subprocess.run(cmd, cwd=bench.SRC, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+    found = {}
+    for key, pattern in bench.PATTERNS.items():
+        match = re.search(pattern, proc.stdout, re.M)
+        if not match:
+            return None, proc.stdout
+        found[key] = float(match.group(1))
+    found['speed'] = found['cycles'] / (found['run_time'] - found['startup'])
+    found['stats'] = [line for line in proc.stdout.splitlines()
+                      if not TIMING.search(line)]
+    return found, proc.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Baseline mesh kernel against the IQ router allocators')
+    parser.add_argument('--booksim', default=os.path.join(bench.SRC, 'booksim'))
+    parser.add_argument('--filter', default='',
+                        help='only workloads whose name matches this regex')
+    opts = parser.parse_args()
+
+    booksim = os.path.abspath(opts.booksim)
+    failures = 0
+    speedups = []
+    for name, cfg, args in workloads():
+        if not re.search(opts.filter, name):
+            continue
+        sparse, log = run(booksim, cfg, args, 0)
+        kernel = None
+        if sparse is not None:
+            kernel, log = run(booksim, cfg, args, 1)
+        if kernel is None:
+            print('%-32s FAILED' % name)
+            sys.stdout.write(''.join(log.splitlines(True)[-20:]))
+            failures += 1
+            continue
+        same = sparse['stats'] == kernel['stats']
+        if not same:
+            failures += 1
+        speedup = kernel['speed'] / sparse['speed']
+        speedups.append(speedup)
+        print('%-32s %s  speedup %6.2fx' %
+              (name, 'same     ' if same else 'DIFFERENT', speedup))
+        sys.stdout.flush()
+
+    if speedups:
+        print('Speedup: min %.2fx, max %.2fx (%d workloads)' %
+              (min(speedups), max(speedups), len(speedups)))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())